@@ -81,6 +81,13 @@ ELSE()
 	SET(pump_WITH_EPOLL "WITHOUT_EPOLL")
 ENDIF()
 
+CHECK_INCLUDE_FILE(linux/io_uring.h HAVE_IO_URING_HEADER)
+IF(HAVE_IO_URING_HEADER AND HAVE_EPOLL_HEADER AND WITH_IO_URING)
+	SET(pump_WITH_IO_URING "WITH_IO_URING")
+ELSE()
+	SET(pump_WITH_IO_URING "WITHOUT_IO_URING")
+ENDIF()
+
 CHECK_INCLUDE_FILE(strings.h FOUND_STRNGS_HEADER)
 IF(FOUND_STRNGS_HEADER)
 	SET(pump_FOUND_STRNGS_HEADER "FOUND_STRNGS_HEADER")
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_config_h
+#define pump_config_h
+
+// clang-format off
+
+#define PUMP_MAJOR_VERSION 1
+#define PUMP_MINOR_VERSION 3
+#define PUMP_BUILD_VERSION 3
+
+#define WITH_LITTLE_ENDIAN
+#if defined(WITH_BIG_ENDIAN)
+#define PUMP_HAVE_BIG_ENDIAN
+#elif defined(WITH_LITTLE_ENDIAN)
+#define PUMP_HAVE_LITTLE_ENDIAN
+#endif
+
+#define WITHOUT_WINSOCK
+#if defined(WITH_WINSOCK)
+#define PUMP_HAVE_WINSOCK
+#endif
+
+#define WITHOUT_IOCP
+#if defined(WITH_IOCP)
+#define PUMP_HAVE_IOCP
+#endif
+
+#define WITH_EPOLL
+#if defined(WITH_EPOLL) && !defined(WITH_IOCP)
+#define PUMP_HAVE_EPOLL
+#endif
+
+#define WITHOUT_IO_URING
+#if defined(WITH_IO_URING) && defined(PUMP_HAVE_EPOLL)
+#define PUMP_HAVE_IO_URING
+#endif
+
+#if !defined(WITH_EPOLL) && !defined(WITH_IOCP)
+#define PUMP_HAVE_SELECT
+#endif
+
+#define WITH_TLS
+#if defined(WITH_TLS)
+#define PUMP_HAVE_TLS
+#endif
+
+#define WITHOUT_JEMALLOC
+#if defined(WITH_JEMALLOC)
+#define PUMP_HAVE_JEMALLOC
+#endif
+
+#define FOUND_STRNGS_HEADER
+#if defined(FOUND_STRNGS_HEADER)
+#define PUMP_HAVE_STRNGS_HEADER
+#endif
+
+#define FOUND_ICONV_HEADER
+#if defined(FOUND_ICONV_HEADER)
+#define PUMP_HAVE_ICONV_HEADER
+#endif
+
+#define FOUND_STRNCPY
+#if defined(FOUND_STRCPYS)
+#define PUMP_HAVE_STRCPYS
+#elif defined(FOUND_STRNCPY)
+#define PUMP_HAVE_STRNCPY
+#endif
+
+#define FOUND_SNPRINTF
+#if defined(FOUND_SPRINTFS)
+#define PUMP_HAVE_SPRINTFS
+#elif defined(FOUND_SNPRINTF)
+#define PUMP_HAVE_SNPRINTF
+#endif
+
+#define FOUND_STRNCASECMP
+#if defined(FOUND_STRNICMP)
+#define PUMP_HAVE_STRNICMP
+#elif defined(FOUND_STRNCASECMP)
+#define PUMP_HAVE_STRNCASECMP
+#endif
+
+#define FOUND_SCHEDYIELD
+#if defined(FOUND_SWTCHTOTHREAD)
+#define PUMP_HAVE_SWTCHTOTHREAD
+#elif defined(FOUND_SCHEDYIELD)
+#define PUMP_HAVE_SCHEDYIELD
+#else
+#define PUMP_HAVE_SCHEDSLEEP
+#endif
+
+#define WITH_DEBUG_LOG
+#if defined(WITH_DEBUG_LOG)
+#define PUMP_HAVE_DEBUG_LOG
+#endif
+
+// clang-format on
+
+#endif
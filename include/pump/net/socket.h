@@ -36,6 +36,8 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
+#include <sys/uio.h>
+#include <limits.h>
 #endif
 
 #if defined(PUMP_HAVE_WINSOCK)
@@ -56,9 +58,24 @@
 #define invalid_socket -1
 #endif
 
+#if defined(PUMP_HAVE_WINSOCK)
+#define pump_iovec WSABUF
+#else
+#define pump_iovec struct iovec
+#endif
+
+#if defined(IOV_MAX)
+#define pump_iovec_max IOV_MAX
+#else
+#define pump_iovec_max 1024
+#endif
+
 namespace pump {
 namespace net {
 
+// Max datagram count of batch reading and sending
+const static int32_t max_batch_count = 32;
+
 /*********************************************************************************
  * Create socket file descriptor
  ********************************************************************************/
@@ -100,11 +117,37 @@ pump_lib bool set_keeplive(
  ********************************************************************************/
 pump_lib bool set_reuse(pump_socket fd, int32_t reuse);
 
+/*********************************************************************************
+ * Set reuse port
+ * Sockets bound to the same port with reuse port share incoming connections.
+ ********************************************************************************/
+pump_lib bool set_reuse_port(pump_socket fd, int32_t reuse);
+
 /*********************************************************************************
  * Set tcp no delay
  ********************************************************************************/
 pump_lib bool set_nodelay(pump_socket fd, int32_t nodelay);
 
+/*********************************************************************************
+ * Set zero copy
+ * Sending with zero copy flag doesn't copy data to kernel, and completion
+ * notifications are read from error queue of the socket.
+ ********************************************************************************/
+pump_lib bool set_zerocopy(pump_socket fd, int32_t zerocopy);
+
+/*********************************************************************************
+ * Set udp segment size
+ * Datagram larger than the size is segmented to datagrams of the size by
+ * kernel or device.
+ ********************************************************************************/
+pump_lib bool set_udp_segment(pump_socket fd, int32_t size);
+
+/*********************************************************************************
+ * Set udp gro
+ * Datagrams received from the same flow maybe coalesced to one large datagram.
+ ********************************************************************************/
+pump_lib bool set_udp_gro(pump_socket fd, int32_t gro);
+
 /*********************************************************************************
  * Update connect context
  ********************************************************************************/
@@ -131,6 +174,7 @@ pump_lib bool listen(pump_socket fd, int32_t backlog = 65535);
 
 /*********************************************************************************
  * Accept socket
+ * The accepted socket is in noblock mode.
  ********************************************************************************/
 pump_lib pump_socket accept(
     pump_socket fd,
@@ -163,6 +207,34 @@ pump_lib int32_t read_from(
     struct sockaddr *addr,
     int32_t *addrlen);
 
+/*********************************************************************************
+ * Readfrom with gro
+ * Read datagram which maybe coalesced by gro, and set segment size of it. If
+ * the datagram is not coalesced, segment size is the datagram size.
+ ********************************************************************************/
+pump_lib int32_t read_from_gro(
+    pump_socket fd,
+    char *b,
+    int32_t size,
+    struct sockaddr *addr,
+    int32_t *addrlen,
+    int32_t *segment_size);
+
+/*********************************************************************************
+ * Readfrom batch
+ * Read at most max_batch_count datagrams to buffers of the vector with one
+ * system call if supported, and set addresses and sizes of read datagrams.
+ * Address lengths are input as address buffer sizes. It returns read datagram
+ * count, -1 if no datagram and 0 if failed.
+ ********************************************************************************/
+pump_lib int32_t read_from_batch(
+    pump_socket fd,
+    pump_iovec *iovs,
+    struct sockaddr **addrs,
+    int32_t *addrlens,
+    int32_t *sizes,
+    int32_t count);
+
 /*********************************************************************************
  * Send
  ********************************************************************************/
@@ -171,6 +243,60 @@ pump_lib int32_t send(
     const char *b,
     int32_t size);
 
+/*********************************************************************************
+ * Set io vector
+ ********************************************************************************/
+pump_inline void set_iovec(pump_iovec &iov, const char *b, int32_t size) {
+#if defined(PUMP_HAVE_WINSOCK)
+    iov.buf = (char *)b;
+    iov.len = (ULONG)size;
+#else
+    iov.iov_base = (void *)b;
+    iov.iov_len = (size_t)size;
+#endif
+}
+
+/*********************************************************************************
+ * Send vector
+ * Gather buffers of the vector and send them with one system call.
+ ********************************************************************************/
+pump_lib int32_t send_vector(
+    pump_socket fd,
+    pump_iovec *iovs,
+    int32_t count);
+
+/*********************************************************************************
+ * Send with zero copy
+ * Data must keep valid and unchanged until kernel notifies completion. It
+ * returns sent size like send.
+ ********************************************************************************/
+pump_lib int32_t send_zerocopy(
+    pump_socket fd,
+    const char *b,
+    int32_t size);
+
+/*********************************************************************************
+ * Read zero copy completion
+ * Read one completion notification from error queue of the socket, which means
+ * zero copy sendings with counter from lo to hi are completed. It returns 1 if
+ * read, -1 if no more notification and 0 if failed.
+ ********************************************************************************/
+pump_lib int32_t read_zerocopy_completion(
+    pump_socket fd,
+    uint32_t *lo,
+    uint32_t *hi);
+
+/*********************************************************************************
+ * Send file
+ * Send data of the file region in kernel by sendfile if supported, else data is
+ * read to a temporary buffer and then sent. It returns sent size like send.
+ ********************************************************************************/
+pump_lib int32_t send_file(
+    pump_socket fd,
+    int32_t file_fd,
+    int64_t offset,
+    int32_t size);
+
 /*********************************************************************************
  * Sendto
  ********************************************************************************/
@@ -181,6 +307,19 @@ pump_lib int32_t send_to(
     struct sockaddr *addr,
     int32_t addrlen);
 
+/*********************************************************************************
+ * Sendto batch
+ * Send at most max_batch_count datagrams of the vector to addresses with one
+ * system call if supported. It returns sent datagram count, -1 if no datagram
+ * sent for socket buffer is full and 0 if the first datagram failed.
+ ********************************************************************************/
+pump_lib int32_t send_to_batch(
+    pump_socket fd,
+    pump_iovec *iovs,
+    struct sockaddr **addrs,
+    int32_t *addrlens,
+    int32_t count);
+
 /*********************************************************************************
  * Close the ability of writing
  ********************************************************************************/
@@ -57,6 +57,11 @@ class pump_lib afd_poller : public poller {
      ********************************************************************************/
     virtual void __poll(int32_t timeout) override;
 
+    /*********************************************************************************
+     * Wakeup parked poller
+     ********************************************************************************/
+    virtual void __wakeup() override;
+
   private:
     /*********************************************************************************
      * Dispatch pending event
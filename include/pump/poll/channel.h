@@ -26,6 +26,7 @@
 #include <pump/types.h>
 #include <pump/net/iocp.h>
 #include <pump/toolkit/features.h>
+#include <pump/toolkit/spin_mutex.h>
 
 namespace pump {
 namespace poll {
@@ -133,6 +134,16 @@ const int32_t tracker_append = 1;
 
 const int32_t tracker_idle = 0x00;
 const int32_t tracker_tracking = 0x02;
+const int32_t tracker_pending = 0x04;
+
+/*********************************************************************************
+ * Tracker mode
+ * Edge tracker is installed persistently with edge triggered, so restarting it
+ * needs no syscall. If an event comes when it is not tracking, it will be marked
+ * pending and channel should handle the pending event by itself.
+ ********************************************************************************/
+const int32_t tracker_mode_oneshot = 0;
+const int32_t tracker_mode_edge = 1;
 
 class poller;
 
@@ -143,20 +154,26 @@ class pump_lib channel_tracker : public toolkit::noncopyable {
      ********************************************************************************/
     channel_tracker(channel_sptr &ch, int32_t ev) noexcept
       : state_(tracker_idle),
+        mode_(tracker_mode_oneshot),
         expected_event_(ev),
         fd_(ch->get_fd()),
         ch_(ch),
-        pr_(nullptr) {
+        pr_(nullptr),
+        shareable_(false),
+        guest_(nullptr) {
 #if defined(PUMP_HAVE_EPOLL) || defined(PUMP_HAVE_IOCP)
         memset(&ev_, 0, sizeof(ev_));
 #endif
     }
     channel_tracker(channel_sptr &&ch, int32_t ev) noexcept
       : state_(tracker_idle),
+        mode_(tracker_mode_oneshot),
         expected_event_(ev),
         fd_(ch->get_fd()),
         ch_(ch),
-        pr_(nullptr) {
+        pr_(nullptr),
+        shareable_(false),
+        guest_(nullptr) {
 #if defined(PUMP_HAVE_EPOLL) || defined(PUMP_HAVE_IOCP)
         memset(&ev_, 0, sizeof(ev_));
 #endif
@@ -185,6 +202,104 @@ class pump_lib channel_tracker : public toolkit::noncopyable {
         return state_.load() == tracker_tracking;
     }
 
+    /*********************************************************************************
+     * Mark pending
+     * Only edge tracker can be marked pending when it is idle.
+     ********************************************************************************/
+    pump_inline bool mark_pending() {
+        int32_t expected = tracker_idle;
+        return state_.compare_exchange_strong(expected, tracker_pending);
+    }
+
+    /*********************************************************************************
+     * Clear pending
+     ********************************************************************************/
+    pump_inline bool clear_pending() {
+        int32_t expected = tracker_pending;
+        return state_.compare_exchange_strong(expected, tracker_idle);
+    }
+
+    /*********************************************************************************
+     * Get pending status
+     ********************************************************************************/
+    pump_inline bool is_pending() const {
+        return state_.load() == tracker_pending;
+    }
+
+    /*********************************************************************************
+     * Set tracker mode
+     * This should be called before installing.
+     ********************************************************************************/
+    pump_inline void set_mode(int32_t mode) {
+        mode_ = mode;
+    }
+
+    /*********************************************************************************
+     * Get tracker mode
+     ********************************************************************************/
+    pump_inline int32_t get_mode() const {
+        return mode_;
+    }
+
+    /*********************************************************************************
+     * Set shareable
+     * Registration of shareable tracker can be shared by a guest tracker, and it's
+     * updated with registration locked. Registration of other trackers is never
+     * locked. This should be called before installing.
+     ********************************************************************************/
+    pump_inline void set_shareable(bool on) {
+        shareable_ = on;
+    }
+
+    /*********************************************************************************
+     * Check shareable or not
+     ********************************************************************************/
+    pump_inline bool is_shareable() const {
+        return shareable_;
+    }
+
+    /*********************************************************************************
+     * Set host tracker
+     * Guest tracker shares the poller registration of its host tracker, so read
+     * and send interests of one fd are registered once. Poller which doesn't
+     * support it registers guest tracker by itself. This should be called before
+     * installing, and host tracker should be shareable and installed at the same
+     * poller.
+     ********************************************************************************/
+    pump_inline void set_host(std::shared_ptr<channel_tracker> &host) {
+        host_ = host;
+    }
+
+    /*********************************************************************************
+     * Get host tracker
+     ********************************************************************************/
+    pump_inline channel_tracker *get_host() {
+        return host_.get();
+    }
+
+    /*********************************************************************************
+     * Set guest tracker
+     * This should be called with registration locked.
+     ********************************************************************************/
+    pump_inline void set_guest(channel_tracker *guest) {
+        guest_ = guest;
+    }
+
+    /*********************************************************************************
+     * Get guest tracker
+     * This should be called with registration locked.
+     ********************************************************************************/
+    pump_inline channel_tracker *get_guest() {
+        return guest_;
+    }
+
+    /*********************************************************************************
+     * Get registration locker
+     ********************************************************************************/
+    pump_inline toolkit::spin_mutex &get_locker() {
+        return mx_;
+    }
+
     /*********************************************************************************
      * Set expected event
      ********************************************************************************/
@@ -250,6 +365,8 @@ class pump_lib channel_tracker : public toolkit::noncopyable {
   private:
     // State
     std::atomic_int32_t state_;
+    // Mode
+    int32_t mode_;
     // Track expected event
     int32_t expected_event_;
     // Track fd
@@ -258,6 +375,13 @@ class pump_lib channel_tracker : public toolkit::noncopyable {
     channel_wptr ch_;
     // Poller
     poller *pr_;
+    // Shareable registration
+    bool shareable_;
+    // Shared registration trackers
+    std::shared_ptr<channel_tracker> host_;
+    channel_tracker *guest_;
+    // Registration locker
+    toolkit::spin_mutex mx_;
 #if defined(PUMP_HAVE_EPOLL)
     struct epoll_event ev_;
 #elif defined(PUMP_HAVE_IOCP)
@@ -55,14 +55,41 @@ class pump_lib epoll_poller : public poller {
      ********************************************************************************/
     virtual void __poll(int32_t timeout) override;
 
+    /*********************************************************************************
+     * Wakeup parked poller
+     ********************************************************************************/
+    virtual void __wakeup() override;
+
   private:
     /*********************************************************************************
      * Dispatch pending event
      ********************************************************************************/
     void __dispatch_pending_event(int32_t count);
 
+    /*********************************************************************************
+     * Start channel registration
+     * Registration of the tracker is armed with its expected event.
+     ********************************************************************************/
+    bool __start_channel_registration(channel_tracker *tracker);
+
+    /*********************************************************************************
+     * Arm shared registration
+     * Read interest of host and send interest of guest are armed together. Caller
+     * must hold the registration locker of host.
+     ********************************************************************************/
+    bool __arm_shared_registration(channel_tracker *host);
+
+    /*********************************************************************************
+     * Dispatch shared registration event
+     ********************************************************************************/
+    void __dispatch_shared_event(
+        channel_tracker *host,
+        channel_tracker *guest,
+        uint32_t events);
+
   private:
     int32_t fd_;
+    int32_t wakeup_fd_;
 
     void *events_;
     int32_t max_event_count_;
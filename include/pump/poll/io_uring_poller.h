@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_poll_io_uring_poller_h
+#define pump_poll_io_uring_poller_h
+
+#include <vector>
+
+#include <pump/poll/poller.h>
+#include <pump/toolkit/spin_mutex.h>
+
+namespace pump {
+namespace poll {
+
+/*********************************************************************************
+ * The io_uring_poller tracks channels with io_uring poll requests. Oneshot
+ * trackers use oneshot poll requests, and edge trackers use multishot poll
+ * requests which keep armed until the tracker is uninstalled.
+ ********************************************************************************/
+class pump_lib io_uring_poller : public poller {
+  protected:
+    struct tracker_slot {
+        tracker_slot() noexcept
+          : tracker(nullptr),
+            gen(0) {}
+        channel_tracker *tracker;
+        uint32_t gen;
+    };
+
+  public:
+    /*********************************************************************************
+     * Constructor
+     ********************************************************************************/
+    io_uring_poller() noexcept;
+
+    /*********************************************************************************
+     * Deconstructor
+     ********************************************************************************/
+    virtual ~io_uring_poller();
+
+    /*********************************************************************************
+     * Check io_uring supported or not
+     * The kernel must support multishot poll requests.
+     ********************************************************************************/
+    static bool is_supported();
+
+  protected:
+    /*********************************************************************************
+     * Install channel tracker for derived class
+     ********************************************************************************/
+    virtual bool __install_channel_tracker(channel_tracker *tracker) override;
+
+    /*********************************************************************************
+     * Uninstall append channel for derived class
+     ********************************************************************************/
+    virtual bool __uninstall_channel_tracker(channel_tracker *tracker) override;
+
+    /*********************************************************************************
+     * Start channel tracker for derived class
+     ********************************************************************************/
+    virtual bool __start_channel_tracker(channel_tracker *tracker) override;
+
+    /*********************************************************************************
+     * Poll
+     ********************************************************************************/
+    virtual void __poll(int32_t timeout) override;
+
+    /*********************************************************************************
+     * Wakeup parked poller
+     ********************************************************************************/
+    virtual void __wakeup() override;
+
+  private:
+    /*********************************************************************************
+     * Arm poll request
+     * Caller must hold the lock.
+     ********************************************************************************/
+    bool __arm_poll_request(channel_tracker *tracker);
+
+    /*********************************************************************************
+     * Queue submission entry
+     * Caller must hold the lock. Entries queued by the polling thread are
+     * submitted at the next polling, others are submitted at once.
+     ********************************************************************************/
+    bool __queue_sqe(
+        uint8_t opcode,
+        int32_t fd,
+        uint32_t poll_events,
+        uint32_t len,
+        uint64_t addr,
+        uint64_t user_data);
+
+    /*********************************************************************************
+     * Submit queued entries
+     * Caller must hold the lock.
+     ********************************************************************************/
+    bool __submit_sqes();
+
+    /*********************************************************************************
+     * Reap completion entries
+     ********************************************************************************/
+    void __reap_cqes();
+
+    /*********************************************************************************
+     * Dispatch pending event
+     ********************************************************************************/
+    void __dispatch_pending_event();
+
+  private:
+    // Ring fd
+    int32_t fd_;
+
+    // Submission ring
+    void *sq_ring_;
+    size_t sq_ring_size_;
+    uint32_t *sq_head_;
+    uint32_t *sq_tail_;
+    uint32_t *sq_mask_;
+    uint32_t *sq_array_;
+    uint32_t sq_entries_;
+    void *sqes_;
+
+    // Completion ring
+    void *cq_ring_;
+    size_t cq_ring_size_;
+    uint32_t *cq_head_;
+    uint32_t *cq_tail_;
+    uint32_t *cq_mask_;
+    void *cqes_;
+
+    // Submission and slots locker
+    toolkit::spin_mutex mx_;
+
+    // Tracker slots, user data of request is index and generation of slot
+    std::vector<tracker_slot> slots_;
+    std::vector<uint32_t> free_slots_;
+
+    // Ready trackers
+    std::vector<channel_tracker *> ready_trackers_;
+};
+
+DEFINE_SMART_POINTERS(io_uring_poller);
+
+}  // namespace poll
+}  // namespace pump
+
+#endif
@@ -17,13 +17,13 @@
 #ifndef pump_poll_poller_h
 #define pump_poll_poller_h
 
-#include <map>
 #include <thread>
 
 #include <pump/debug.h>
 #include <pump/memory.h>
 #include <pump/net/socket.h>
 #include <pump/poll/channel.h>
+#include <pump/poll/tracker_table.h>
 #include <pump/toolkit/freelock_m2m_queue.h>
 
 namespace pump {
@@ -32,6 +32,9 @@ namespace poll {
 class pump_lib poller : public toolkit::noncopyable {
   protected:
     struct channel_event {
+        channel_event() noexcept
+          : event(0),
+            arg(nullptr) {}
         channel_event(
             std::shared_ptr<channel> &c,
             int32_t ev,
@@ -45,6 +48,8 @@ class pump_lib poller : public toolkit::noncopyable {
     };
 
     struct tracker_event {
+        tracker_event() noexcept
+          : event(0) {}
         tracker_event(
             channel_tracker_sptr &t,
             int32_t ev) noexcept
@@ -127,10 +132,30 @@ class pump_lib poller : public toolkit::noncopyable {
 
     /*********************************************************************************
      * Poll
-     * Timeout is polling timeout time. If set to -1, then no wait
+     * Timeout is polling timeout time. If set to -1, then wait until events come
+     * or poller is waked up.
      ********************************************************************************/
     virtual void __poll(int32_t timeout) {}
 
+    /*********************************************************************************
+     * Wakeup parked poller for derived class
+     ********************************************************************************/
+    virtual void __wakeup() {}
+
+    /*********************************************************************************
+     * Wakeup poller if parked
+     ********************************************************************************/
+    pump_inline void __wakeup_if_parked() {
+        if (parked_.load() && parked_.exchange(false)) {
+            __wakeup();
+        }
+    }
+
+    /*********************************************************************************
+     * Pend edge event
+     ********************************************************************************/
+    void __pend_edge_event(channel_tracker *tracker);
+
   private:
     /*********************************************************************************
      * Handle channel events
@@ -149,16 +174,22 @@ class pump_lib poller : public toolkit::noncopyable {
     // Worker thread
     std::shared_ptr<std::thread> worker_;
 
-    // Channel event
+    // Parked status
+    std::atomic_bool parked_;
+    // Parked polling timeout, -1 means derived poller can be waked up
+    int32_t parked_timeout_;
+
+    // Channel events
+    // Events are constructed in place of preallocated queue nodes.
     std::atomic_int32_t cev_cnt_;
-    toolkit::freelock_m2m_queue<channel_event *> cevents_;
+    toolkit::freelock_m2m_queue<channel_event> cevents_;
 
-    // Channel tracker event
+    // Channel tracker events
     std::atomic_int32_t tev_cnt_;
-    toolkit::freelock_m2m_queue<tracker_event *> tevents_;
+    toolkit::freelock_m2m_queue<tracker_event> tevents_;
 
     // Channel trackers
-    std::map<channel_tracker *, channel_tracker_sptr> trackers_;
+    tracker_table trackers_;
 };
 DEFINE_SMART_POINTERS(poller);
 
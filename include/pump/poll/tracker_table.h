@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_poll_tracker_table_h
+#define pump_poll_tracker_table_h
+
+#include <vector>
+
+#include <pump/types.h>
+#include <pump/poll/channel.h>
+
+namespace pump {
+namespace poll {
+
+/*********************************************************************************
+ * The tracker_table owns channel trackers in a flat slot array indexed by fd.
+ * Every slot has two ways, so read and send trackers of one fd can be held in
+ * one slot. Trackers which can't get a way, such as reused fd whose old tracker
+ * is not removed yet, are held in the overflow list.
+ ********************************************************************************/
+class pump_lib tracker_table : public toolkit::noncopyable {
+  public:
+    // Slot way count
+    const static int32_t slot_way_count = 2;
+
+    // Tracker slot
+    struct tracker_slot {
+        channel_tracker_sptr ways[slot_way_count];
+    };
+
+  public:
+    /*********************************************************************************
+     * Constructor
+     ********************************************************************************/
+    tracker_table(int32_t size = 1024) noexcept;
+
+    /*********************************************************************************
+     * Deconstructor
+     ********************************************************************************/
+    ~tracker_table() = default;
+
+    /*********************************************************************************
+     * Insert tracker
+     ********************************************************************************/
+    void insert(channel_tracker_sptr &&tracker);
+
+    /*********************************************************************************
+     * Remove tracker
+     ********************************************************************************/
+    bool remove(channel_tracker *tracker);
+
+    /*********************************************************************************
+     * Get tracker count
+     ********************************************************************************/
+    pump_inline int32_t size() const noexcept {
+        return count_;
+    }
+
+    /*********************************************************************************
+     * For each tracker
+     * The visiting tracker can be removed in the callback.
+     ********************************************************************************/
+    template <typename Callback>
+    void for_each(const Callback &cb) {
+        for (auto &slot : slots_) {
+            for (int32_t i = 0; i < slot_way_count; i++) {
+                if (slot.ways[i]) {
+                    cb(slot.ways[i].get());
+                }
+            }
+        }
+        for (auto i = (int32_t)overflow_.size() - 1; i >= 0; i--) {
+            if (i < (int32_t)overflow_.size()) {
+                cb(overflow_[i].get());
+            }
+        }
+    }
+
+  private:
+    /*********************************************************************************
+     * Get slot index
+     ********************************************************************************/
+    pump_inline size_t __get_index(pump_socket fd) const noexcept {
+#if defined(OS_WINDOWS)
+        // Socket handles are multiples of 4 on windows.
+        return (size_t)fd >> 2;
+#else
+        return (size_t)fd;
+#endif
+    }
+
+  private:
+    // Tracker count
+    int32_t count_;
+    // Tracker slots
+    std::vector<tracker_slot> slots_;
+    // Overflow trackers
+    std::vector<channel_tracker_sptr> overflow_;
+};
+
+}  // namespace poll
+}  // namespace pump
+
+#endif
@@ -42,6 +42,10 @@ struct http_callbacks {
     pump_function<void(packet_sptr &)> packet_cb;
     // Http connection error callback
     pump_function<void(const std::string &)> error_cb;
+    // Http connection send paused callback
+    pump_function<void()> send_paused_cb;
+    // Http connection send resumed callback
+    pump_function<void()> send_resumed_cb;
 };
 
 struct websocket_callbacks {
@@ -49,6 +53,10 @@ struct websocket_callbacks {
     pump_function<void(const char *, int32_t, bool)> frame_cb;
     // Websocket connection error callback
     pump_function<void(const std::string &)> error_cb;
+    // Websocket connection send paused callback
+    pump_function<void()> send_paused_cb;
+    // Websocket connection send resumed callback
+    pump_function<void()> send_resumed_cb;
 };
 
 class pump_lib connection : public std::enable_shared_from_this<connection> {
@@ -84,6 +92,14 @@ class pump_lib connection : public std::enable_shared_from_this<connection> {
     }
     bool send(packet *pk);
 
+    /*********************************************************************************
+     * Send http packet with file region as body
+     * Content length of the packet is set to the region size, and the packet
+     * should have no body. Tcp transport sends the region by sendfile, so static
+     * files are served without copying them to user space.
+     ********************************************************************************/
+    bool send_file(packet *pk, int32_t fd, int64_t offset, int32_t size);
+
     /*********************************************************************************
      * Start websocket
      ********************************************************************************/
@@ -97,6 +113,17 @@ class pump_lib connection : public std::enable_shared_from_this<connection> {
         int32_t size,
         bool text = true);
 
+    /*********************************************************************************
+     * Set send watermarks
+     * Send paused and resumed callbacks of http or websocket are triggered when
+     * pending send size of the transport crosses the watermarks.
+     ********************************************************************************/
+    pump_inline void set_send_watermark(int32_t high, int32_t low) {
+        if (transp_) {
+            transp_->set_send_watermark(high, low);
+        }
+    }
+
     /*********************************************************************************
      * Stop connection
      ********************************************************************************/
@@ -125,8 +152,7 @@ class pump_lib connection : public std::enable_shared_from_this<connection> {
      ********************************************************************************/
     static void on_read(
         connection_wptr conn,
-        const char *b,
-        int32_t size);
+        toolkit::io_buffer *iob);
 
     /*********************************************************************************
      * Disconnected event callback
@@ -138,6 +164,11 @@ class pump_lib connection : public std::enable_shared_from_this<connection> {
      ********************************************************************************/
     static void on_stopped(connection_wptr conn);
 
+    /*********************************************************************************
+     * Send paused and resumed event callback
+     ********************************************************************************/
+    static void on_send_watermark(connection_wptr conn, bool paused);
+
   private:
     /*********************************************************************************
      * Read next one http packet.
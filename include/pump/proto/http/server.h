@@ -22,6 +22,7 @@
 #include <pump/proto/http/connection.h>
 #include <pump/transport/tcp_acceptor.h>
 #include <pump/transport/tls_acceptor.h>
+#include <pump/transport/sharded_acceptor.h>
 
 namespace pump {
 namespace proto {
@@ -29,6 +30,7 @@ namespace http {
 
 using transport::address;
 using transport::base_acceptor_sptr;
+using transport::sharded_acceptor_sptr;
 using transport::tls_credentials;
 
 class server;
@@ -56,6 +58,16 @@ class pump_lib server : public std::enable_shared_from_this<server> {
      ********************************************************************************/
     virtual ~server() = default;
 
+    /*********************************************************************************
+     * Set sharded listening
+     * Every poller shard of service listens with its own SO_REUSEPORT socket and
+     * serves connections accepted by itself. This should be called before
+     * starting.
+     ********************************************************************************/
+    pump_inline void set_sharded(bool on) noexcept {
+        sharded_ = on;
+    }
+
     /*********************************************************************************
      * Start server
      ********************************************************************************/
@@ -121,6 +133,10 @@ class pump_lib server : public std::enable_shared_from_this<server> {
     // Acceptor
     base_acceptor_sptr acceptor_;
 
+    // Sharded listening
+    bool sharded_;
+    sharded_acceptor_sptr sharded_acceptor_;
+
     // Connections
     std::mutex conn_mx_;
     std::map<connection *, connection_sptr> conns_;
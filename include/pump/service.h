@@ -17,11 +17,14 @@
 #ifndef pump_service_h
 #define pump_service_h
 
+#include <vector>
+
 #include <pump/poll/poller.h>
 #include <pump/time/engine.h>
 #include <pump/toolkit/freelock_queue.h>
 #include <pump/toolkit/freelock_m2m_queue.h>
 #include <pump/toolkit/freelock_o2o_queue.h>
+#include <pump/toolkit/freelock_ws_deque.h>
 
 namespace pump {
 
@@ -32,12 +35,29 @@ typedef int32_t poller_id;
 const poller_id read_pid = 0;
 const poller_id send_pid = 1;
 
+/*********************************************************************************
+ * Poller shard id in service
+ * Every shard owns a read poller and a send poller.
+ ********************************************************************************/
+typedef int32_t shard_id;
+const shard_id invalid_sid = -1;
+
 class pump_lib service : public toolkit::noncopyable {
+  public:
+    // Task callback
+    typedef pump_function<void()> task_callback;
+
   public:
     /*********************************************************************************
      * Constructor
+     * If shard count is not positive, it will be the hardware concurrency.
+     * If task worker count is greater than 1, posted tasks maybe run in parallel
+     * and not in order.
      ********************************************************************************/
-    service(bool enable_poll = true);
+    service(
+        bool enable_poll = true,
+        int32_t shard_count = 0,
+        int32_t task_worker_count = 1);
 
     /*********************************************************************************
      * Deconstructor
@@ -59,12 +79,33 @@ class pump_lib service : public toolkit::noncopyable {
      ********************************************************************************/
     void wait_stopped();
 
+    /*********************************************************************************
+     * Get poller shard count
+     ********************************************************************************/
+    pump_inline int32_t get_shard_count() const noexcept {
+        return shard_count_;
+    }
+
+    /*********************************************************************************
+     * Select poller shard
+     * Shards are selected in round robin.
+     ********************************************************************************/
+    pump_inline shard_id select_shard() noexcept {
+        if (pump_unlikely(shard_count_ == 0)) {
+            return invalid_sid;
+        }
+        return next_shard_.fetch_add(1, std::memory_order_relaxed) % shard_count_;
+    }
+
     /*********************************************************************************
      * Get poller
      ********************************************************************************/
-    pump_inline poll::poller *get_poller(poller_id pid) {
+    pump_inline poll::poller *get_poller(shard_id sid, poller_id pid) {
         pump_assert(pid <= send_pid);
-        return pollers_[pid];
+        if (pump_unlikely(sid < 0 || sid >= shard_count_)) {
+            return nullptr;
+        }
+        return pollers_[sid * 2 + pid];
     }
 
     /*********************************************************************************
@@ -74,20 +115,30 @@ class pump_lib service : public toolkit::noncopyable {
         poll::channel_sptr &ch,
         int32_t event,
         void *arg,
+        shard_id sid,
         poller_id pid) {
-        pump_assert(pid <= send_pid);
-        if (pump_likely(!!pollers_[pid])) {
-            return pollers_[pid]->push_channel_event(ch, event, arg);
+        auto poller = get_poller(sid, pid);
+        if (pump_likely(poller != nullptr)) {
+            return poller->push_channel_event(ch, event, arg);
         }
         return false;
     }
 
+    /*********************************************************************************
+     * Get task worker count
+     ********************************************************************************/
+    pump_inline int32_t get_task_worker_count() const noexcept {
+        return task_worker_count_;
+    }
+
     /*********************************************************************************
      * Post task callback
+     * If posting in task worker thread, task will be pushed to the local deque of
+     * the worker, otherwise it will be pushed to the shared queue.
      ********************************************************************************/
     template <typename TaskCallbackType>
     pump_inline void post(TaskCallbackType &&task) {
-        posted_tasks_.enqueue(std::forward<TaskCallbackType>(task));
+        __post_task(task_callback(std::forward<TaskCallbackType>(task)));
     }
 
     /*********************************************************************************
@@ -119,9 +170,24 @@ class pump_lib service : public toolkit::noncopyable {
     void __post_triggered_timers(time::timer_list_sptr &tl);
 
     /*********************************************************************************
-     * Start task worker
+     * Post task
+     ********************************************************************************/
+    void __post_task(task_callback &&task);
+
+    /*********************************************************************************
+     * Start task workers
+     ********************************************************************************/
+    void __start_task_workers();
+
+    /*********************************************************************************
+     * Run task worker
      ********************************************************************************/
-    void __start_task_worker();
+    void __run_task_worker(int32_t id);
+
+    /*********************************************************************************
+     * Steal task from other task workers
+     ********************************************************************************/
+    bool __steal_task(int32_t id, task_callback *&task);
 
     /*********************************************************************************
      * Start timer callback worker
@@ -132,14 +198,21 @@ class pump_lib service : public toolkit::noncopyable {
     // Status
     bool running_;
 
-    // Pollers
-    poll::poller *pollers_[2];
+    // Poller shards
+    int32_t shard_count_;
+    std::atomic_uint32_t next_shard_;
+    std::vector<poll::poller *> pollers_;
 
-    // Task worker
-    std::shared_ptr<std::thread> task_worker_;
-    typedef pump_function<void()> task_callback;
-    typedef toolkit::freelock_m2m_queue<task_callback> task_queue;
-    toolkit::freelock_queue<task_queue> posted_tasks_;
+    // Task workers
+    int32_t task_worker_count_;
+    std::vector<std::shared_ptr<std::thread>> task_workers_;
+    // Task worker deques
+    typedef toolkit::freelock_ws_deque<task_callback *> task_deque;
+    std::vector<task_deque *> worker_tasks_;
+    // Shared posted tasks
+    toolkit::freelock_m2m_queue<task_callback> posted_tasks_;
+    // Pending task count semaphore
+    toolkit::light_semaphore pending_tasks_;
 
     // Timers
     time::engine_sptr timers_;
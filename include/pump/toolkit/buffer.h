@@ -24,6 +24,7 @@
 #include <pump/types.h>
 #include <pump/memory.h>
 #include <pump/platform.h>
+#include <pump/toolkit/slab_pool.h>
 
 namespace pump {
 namespace toolkit {
@@ -32,8 +33,9 @@ class pump_lib base_buffer {
   public:
     /*********************************************************************************
      * Constructor
+     * If pooled, raw buffer is allocated from slab pool.
      ********************************************************************************/
-    base_buffer(bool alloced) noexcept;
+    base_buffer(bool alloced, bool pooled = false) noexcept;
 
     /*********************************************************************************
      * Deconstructor
@@ -61,6 +63,13 @@ class pump_lib base_buffer {
         return alloced_;
     }
 
+    /*********************************************************************************
+     * Check raw buffer pooled or not
+     ********************************************************************************/
+    pump_inline bool is_pooled() const noexcept {
+        return pooled_;
+    }
+
   protected:
     /*********************************************************************************
      * Init by allocate
@@ -79,9 +88,21 @@ class pump_lib base_buffer {
      ********************************************************************************/
     bool __init_by_reference(const char *b, uint32_t size) noexcept;
 
+    /*********************************************************************************
+     * Allocate raw memory
+     ********************************************************************************/
+    char *__alloc_raw(uint32_t size, uint32_t *capacity) noexcept;
+
+    /*********************************************************************************
+     * Free raw memory
+     ********************************************************************************/
+    void __free_raw(char *raw, uint32_t capacity) noexcept;
+
   protected:
     // Alloced flag
     bool alloced_;
+    // Pooled flag
+    bool pooled_;
 
     // Raw buffer
     char *raw_;
@@ -95,21 +116,21 @@ class pump_lib io_buffer : public base_buffer {
      * Create
      ********************************************************************************/
     static io_buffer *create(uint32_t size = 0) {
-        pump_object_create_inline(io_buffer, obj, true);
+        auto obj = __create(true);
         if (obj != nullptr) {
             if (size > 0 && !obj->__init_by_alloc(size)) {
-                pump_object_destroy_inline(obj, io_buffer);
+                obj->__destroy();
                 return nullptr;
             }
         }
         return obj;
     }
     static io_buffer *create_by_copy(const char *b = nullptr, uint32_t size = 0) {
-        pump_object_create_inline(io_buffer, obj, true);
+        auto obj = __create(true);
         if (obj != nullptr) {
             if (b != nullptr && size > 0) {
                 if (!obj->__init_by_copy(b, size)) {
-                    pump_object_destroy_inline(obj, io_buffer);
+                    obj->__destroy();
                     return nullptr;
                 }
                 obj->size_ = size;
@@ -118,11 +139,11 @@ class pump_lib io_buffer : public base_buffer {
         return obj;
     }
     static io_buffer *create_by_reference(const char *b = nullptr, uint32_t size = 0) {
-        pump_object_create_inline(io_buffer, obj, false);
+        auto obj = __create(false);
         if (obj != nullptr) {
             if (b != nullptr && size > 0) {
                 if (!obj->__init_by_reference(b, size)) {
-                    pump_object_destroy_inline(obj, io_buffer);
+                    obj->__destroy();
                     return nullptr;
                 }
                 obj->size_ = size;
@@ -131,6 +152,47 @@ class pump_lib io_buffer : public base_buffer {
         return obj;
     }
 
+    /*********************************************************************************
+     * Create by file
+     * The buffer refers to a file region instead of memory, and it owns the file
+     * fd which is closed after the buffer destroyed. Data of the buffer is not
+     * in memory, so it can only be shifted and sent by tcp transport.
+     ********************************************************************************/
+    static io_buffer *create_by_file(int32_t fd, int64_t offset, uint32_t size) {
+        if (fd < 0 || offset < 0 || size == 0) {
+            return nullptr;
+        }
+        auto obj = __create(false);
+        if (obj != nullptr) {
+            obj->file_fd_ = fd;
+            obj->file_offset_ = offset;
+            obj->size_ = size;
+        }
+        return obj;
+    }
+
+    /*********************************************************************************
+     * Check file buffer or not
+     ********************************************************************************/
+    pump_inline bool is_file() const noexcept {
+        return file_fd_ >= 0;
+    }
+
+    /*********************************************************************************
+     * Get file fd of file buffer
+     ********************************************************************************/
+    pump_inline int32_t file_fd() const noexcept {
+        return file_fd_;
+    }
+
+    /*********************************************************************************
+     * Get file offset of file buffer
+     * The offset is moved forward with shifting.
+     ********************************************************************************/
+    pump_inline int64_t file_offset() const noexcept {
+        return file_offset_ + rpos_;
+    }
+
     /*********************************************************************************
      * Write bytes
      ********************************************************************************/
@@ -141,6 +203,19 @@ class pump_lib io_buffer : public base_buffer {
      ********************************************************************************/
     bool write(char b, uint32_t count = 1);
 
+    /*********************************************************************************
+     * Prepare writing
+     * Make sure there is at least the size space after data, and return the
+     * space. Data can be written to the space directly, and then be committed.
+     * If failed return nullptr.
+     ********************************************************************************/
+    char *prepare_write(uint32_t size);
+
+    /*********************************************************************************
+     * Commit written data size
+     ********************************************************************************/
+    bool commit_write(uint32_t size);
+
     /*********************************************************************************
      * Read bytes
      ********************************************************************************/
@@ -205,7 +280,7 @@ class pump_lib io_buffer : public base_buffer {
     /*********************************************************************************
      * Constructor
      ********************************************************************************/
-    io_buffer(bool free) noexcept;
+    io_buffer(bool alloced, bool pooled) noexcept;
 
     /*********************************************************************************
      * Copy constructor
@@ -215,13 +290,31 @@ class pump_lib io_buffer : public base_buffer {
     /*********************************************************************************
      * Deconstructor
      ********************************************************************************/
-    virtual ~io_buffer() = default;
+    virtual ~io_buffer();
 
     /*********************************************************************************
      * Assign operator
      ********************************************************************************/
     io_buffer &operator=(const io_buffer &) = delete;
 
+  private:
+    /*********************************************************************************
+     * Create object
+     * Object of alloced buffer is allocated from slab pool if pool enabled.
+     ********************************************************************************/
+    static io_buffer *__create(bool alloced) noexcept;
+
+    /*********************************************************************************
+     * Destroy object
+     ********************************************************************************/
+    void __destroy() noexcept;
+
+    /*********************************************************************************
+     * Expand raw buffer
+     * Data of pooled buffer is moved to the head of new raw buffer.
+     ********************************************************************************/
+    bool __expand(uint32_t size) noexcept;
+
   private:
     // Data size
     uint32_t size_;
@@ -229,6 +322,10 @@ class pump_lib io_buffer : public base_buffer {
     uint32_t rpos_;
     // Reference count
     std::atomic_int count_;
+
+    // File fd and offset of file buffer
+    int32_t file_fd_;
+    int64_t file_offset_;
 };
 
 class shared_buffer {
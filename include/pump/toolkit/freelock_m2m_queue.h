@@ -54,7 +54,7 @@ class freelock_m2m_queue : public noncopyable {
 
         volatile int32_t ready;
 
-        char data[element_size];
+        alignas(element_type) char data[element_size];
     };
 
     // Block node
@@ -115,35 +115,8 @@ class freelock_m2m_queue : public noncopyable {
      ********************************************************************************/
     template <typename U>
     bool push(U &&data) {
-        // Get current head node as write node.
-        auto next_write_node = head_.load(std::memory_order_acquire);
-        do {
-            // If current write node is invalid, list is being extended and try
-            // again.
-            while (next_write_node == nullptr) {
-                next_write_node = head_.load(std::memory_order_relaxed);
-            }
-
-            // If next write node is ready or is the tail node, list is full and
-            // we need try to extend it.
-            if (next_write_node->next != tail_.load(std::memory_order_relaxed)) {
-                if (head_.compare_exchange_strong(
-                        next_write_node,
-                        next_write_node->next,
-                        std::memory_order_release,
-                        std::memory_order_relaxed)) {
-                    break;
-                }
-            } else {
-                if (__extend_list(next_write_node)) {
-                    break;
-                }
-            }
-        } while (true);
-
-        // Wait node is unready.
-        while (next_write_node->ready == 1) {
-        }
+        // Get next write node.
+        auto next_write_node = __get_write_node();
 
         // Construct node data.
         if (no_constructor) {
@@ -158,6 +131,24 @@ class freelock_m2m_queue : public noncopyable {
         return true;
     }
 
+    /*********************************************************************************
+     * Emplace
+     * Element is constructed in place of the queue node.
+     ********************************************************************************/
+    template <typename... Args>
+    bool emplace(Args &&...args) {
+        // Get next write node.
+        auto next_write_node = __get_write_node();
+
+        // Construct node data in place.
+        new (next_write_node->data) element_type(std::forward<Args>(args)...);
+
+        // Mark node ready.
+        next_write_node->ready = 1;
+
+        return true;
+    }
+
     /*********************************************************************************
      * Pop
      ********************************************************************************/
@@ -217,6 +208,43 @@ class freelock_m2m_queue : public noncopyable {
     }
 
   private:
+    /*********************************************************************************
+     * Get next write node
+     ********************************************************************************/
+    element_node *__get_write_node() {
+        // Get current head node as write node.
+        auto next_write_node = head_.load(std::memory_order_acquire);
+        do {
+            // If current write node is invalid, list is being extended and try
+            // again.
+            while (next_write_node == nullptr) {
+                next_write_node = head_.load(std::memory_order_relaxed);
+            }
+
+            // If next write node is ready or is the tail node, list is full and
+            // we need try to extend it.
+            if (next_write_node->next != tail_.load(std::memory_order_relaxed)) {
+                if (head_.compare_exchange_strong(
+                        next_write_node,
+                        next_write_node->next,
+                        std::memory_order_release,
+                        std::memory_order_relaxed)) {
+                    break;
+                }
+            } else {
+                if (__extend_list(next_write_node)) {
+                    break;
+                }
+            }
+        } while (true);
+
+        // Wait node is unready.
+        while (next_write_node->ready == 1) {
+        }
+
+        return next_write_node;
+    }
+
     /*********************************************************************************
      * Init list
      ********************************************************************************/
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_toolkit_freelock_ws_deque_h
+#define pump_toolkit_freelock_ws_deque_h
+
+#include <atomic>
+#include <type_traits>
+
+#include <pump/debug.h>
+#include <pump/memory.h>
+#include <pump/toolkit/features.h>
+
+namespace pump {
+namespace toolkit {
+
+/*********************************************************************************
+ * The freelock_ws_deque is chase-lev work stealing deque. Only the owner thread
+ * can push and pop elements at the bottom, other threads can steal elements at
+ * the top at the same time.
+ * Element type must be integral or pointer type.
+ ********************************************************************************/
+template <typename T>
+class freelock_ws_deque : public noncopyable {
+  public:
+    // Element type
+    typedef T element_type;
+    static_assert(
+        std::is_integral<element_type>::value ||
+            std::is_pointer<element_type>::value,
+        "element type must be integral or pointer");
+
+    // Ring node
+    struct ring_node {
+        ring_node(int64_t size, ring_node *p)
+          : mask(size - 1),
+            prev(p),
+            elems(nullptr) {
+        }
+
+        int64_t mask;
+
+        ring_node *prev;
+
+        std::atomic<element_type> *elems;
+    };
+
+  public:
+    /*********************************************************************************
+     * Constructor
+     ********************************************************************************/
+    freelock_ws_deque(int32_t size = 1024)
+      : top_(0),
+        bottom_(0),
+        ring_(nullptr) {
+        int64_t ring_size = 16;
+        while (ring_size < size) {
+            ring_size <<= 1;
+        }
+        ring_.store(__create_ring(ring_size, nullptr), std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Deconstructor
+     ********************************************************************************/
+    ~freelock_ws_deque() {
+        auto ring = ring_.load(std::memory_order_relaxed);
+        while (ring != nullptr) {
+            auto prev = ring->prev;
+            pump_free(ring->elems);
+            pump_object_destroy(ring);
+            ring = prev;
+        }
+    }
+
+    /*********************************************************************************
+     * Push
+     * Only the owner thread can push element.
+     ********************************************************************************/
+    void push(element_type data) {
+        auto b = bottom_.load(std::memory_order_relaxed);
+        auto t = top_.load(std::memory_order_acquire);
+        auto ring = ring_.load(std::memory_order_relaxed);
+        if (pump_unlikely(b - t > ring->mask)) {
+            ring = __grow_ring(ring, t, b);
+        }
+        ring->elems[b & ring->mask].store(data, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Pop
+     * Only the owner thread can pop element.
+     ********************************************************************************/
+    bool pop(element_type &data) {
+        auto b = bottom_.load(std::memory_order_relaxed) - 1;
+        auto ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            // Deque is empty.
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        data = ring->elems[b & ring->mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // The last element, race with stealers.
+            bool ok = top_.compare_exchange_strong(
+                t,
+                t + 1,
+                std::memory_order_seq_cst,
+                std::memory_order_relaxed);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return ok;
+        }
+
+        return true;
+    }
+
+    /*********************************************************************************
+     * Steal
+     * Any thread can steal element. This maybe fail when racing with others.
+     ********************************************************************************/
+    bool steal(element_type &data) {
+        auto t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        auto ring = ring_.load(std::memory_order_acquire);
+        data = ring->elems[t & ring->mask].load(std::memory_order_relaxed);
+        return top_.compare_exchange_strong(
+            t,
+            t + 1,
+            std::memory_order_seq_cst,
+            std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Empty
+     ********************************************************************************/
+    pump_inline bool empty() const noexcept {
+        auto b = bottom_.load(std::memory_order_relaxed);
+        auto t = top_.load(std::memory_order_relaxed);
+        return b <= t;
+    }
+
+  private:
+    /*********************************************************************************
+     * Create ring
+     ********************************************************************************/
+    ring_node *__create_ring(int64_t size, ring_node *prev) {
+        auto ring = pump_object_create<ring_node>(size, prev);
+        if (ring == nullptr) {
+            pump_abort();
+        }
+        ring->elems = (std::atomic<element_type> *)pump_malloc(
+            sizeof(std::atomic<element_type>) * size);
+        if (ring->elems == nullptr) {
+            pump_abort();
+        }
+        for (int64_t i = 0; i < size; i++) {
+            new (ring->elems + i) std::atomic<element_type>(element_type());
+        }
+        return ring;
+    }
+
+    /*********************************************************************************
+     * Grow ring
+     * Old ring will be kept until deque destroyed, because stealers maybe still
+     * reading it.
+     ********************************************************************************/
+    ring_node *__grow_ring(ring_node *ring, int64_t t, int64_t b) {
+        auto new_ring = __create_ring((ring->mask + 1) * 2, ring);
+        for (auto i = t; i < b; i++) {
+            new_ring->elems[i & new_ring->mask].store(
+                ring->elems[i & ring->mask].load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+        }
+        ring_.store(new_ring, std::memory_order_release);
+        return new_ring;
+    }
+
+  private:
+    // Top index
+    pump_cache_line_alignas std::atomic_int64_t top_;
+
+    // Bottom index
+    pump_cache_line_alignas std::atomic_int64_t bottom_;
+
+    // Ring node
+    pump_cache_line_alignas std::atomic<ring_node *> ring_;
+};
+
+}  // namespace toolkit
+}  // namespace pump
+
+#endif
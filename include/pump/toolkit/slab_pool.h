@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_toolkit_slab_pool_h
+#define pump_toolkit_slab_pool_h
+
+#include <pump/types.h>
+#include <pump/memory.h>
+
+namespace pump {
+namespace toolkit {
+
+/*********************************************************************************
+ * The slab_pool allocates memory blocks in power of two size classes from 64B
+ * to 64KB. Blocks are carved from slabs which are never returned to heap. Every
+ * thread caches blocks in its magazines, and magazines exchange blocks with the
+ * shared depot of the size class in batches. Blocks larger than the max class
+ * are allocated from heap directly.
+ ********************************************************************************/
+class pump_lib slab_pool {
+  public:
+    // Min block size
+    const static uint32_t min_block_size = 64;
+    // Max block size
+    const static uint32_t max_block_size = 64 * 1024;
+
+  public:
+    /*********************************************************************************
+     * Allocate block
+     * Capacity of the block is rounded up to its size class.
+     ********************************************************************************/
+    static void *alloc(uint32_t size, uint32_t *capacity = nullptr) noexcept;
+
+    /*********************************************************************************
+     * Deallocate block
+     * The capacity must be the one got when allocating.
+     ********************************************************************************/
+    static void dealloc(void *block, uint32_t capacity) noexcept;
+
+    /*********************************************************************************
+     * Get block capacity of the size
+     ********************************************************************************/
+    static uint32_t get_block_capacity(uint32_t size) noexcept;
+
+    /*********************************************************************************
+     * Set enabled
+     * Io buffers created when disabled are allocated from heap. The pool is
+     * enabled by default.
+     ********************************************************************************/
+    static void set_enabled(bool on) noexcept;
+
+    /*********************************************************************************
+     * Get enabled status
+     ********************************************************************************/
+    static bool is_enabled() noexcept;
+};
+
+}  // namespace toolkit
+}  // namespace pump
+
+#endif
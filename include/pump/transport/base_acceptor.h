@@ -23,6 +23,10 @@ namespace pump {
 namespace transport {
 
 class pump_lib base_acceptor : public base_channel {
+  public:
+    // Default accept budget
+    const static int32_t default_accept_budget = 64;
+
   public:
     /*********************************************************************************
      * Constructor
@@ -31,7 +35,9 @@ class pump_lib base_acceptor : public base_channel {
         int32_t type,
         const address &listen_address) noexcept
       : base_channel(type, nullptr, -1),
-        listen_address_(listen_address) {
+        listen_address_(listen_address),
+        accept_budget_(default_accept_budget),
+        reuse_port_(false) {
     }
 
     /*********************************************************************************
@@ -58,6 +64,25 @@ class pump_lib base_acceptor : public base_channel {
         return listen_address_;
     }
 
+    /*********************************************************************************
+     * Set accept budget
+     * Acceptor accepts at most budget connections for one read event before
+     * restarting its tracker. This should be called before starting.
+     ********************************************************************************/
+    pump_inline void set_accept_budget(int32_t budget) noexcept {
+        accept_budget_ = budget > 0 ? budget : 1;
+    }
+
+    /*********************************************************************************
+     * Set reuse port
+     * Acceptor listens with SO_REUSEPORT, so acceptors of every shard can listen
+     * on the same address. Accepted transports are bound to the shard of the
+     * acceptor. This should be called before starting.
+     ********************************************************************************/
+    pump_inline void set_reuse_port(bool on) noexcept {
+        reuse_port_ = on;
+    }
+
   protected:
     /*********************************************************************************
      * Channel event callback
@@ -96,10 +121,25 @@ class pump_lib base_acceptor : public base_channel {
      ********************************************************************************/
     void __trigger_interrupt_callbacks();
 
+    /*********************************************************************************
+     * Bind accepted channel to the shard of acceptor if reusing port
+     ********************************************************************************/
+    pump_inline void __bind_accepted_shard(base_channel *ch) noexcept {
+        if (reuse_port_) {
+            ch->set_shard(shard_);
+        }
+    }
+
   protected:
     // Listen address
     address listen_address_;
 
+    // Accept budget for one read event
+    int32_t accept_budget_;
+
+    // Reuse port
+    bool reuse_port_;
+
     // Channel tracker
     poll::channel_tracker_sptr tracker_;
 
@@ -17,12 +17,16 @@
 #ifndef pump_transport_channel_h
 #define pump_transport_channel_h
 
+#include <vector>
+
 #include <pump/service.h>
 #include <pump/poll/channel.h>
 #include <pump/toolkit/buffer.h>
+#include <pump/toolkit/freelock_m2m_queue.h>
 #include <pump/transport/types.h>
 #include <pump/transport/address.h>
 #include <pump/transport/callbacks.h>
+#include <pump/transport/rate_limiter.h>
 
 namespace pump {
 namespace transport {
@@ -34,6 +38,13 @@ class flow_base;
 const static int32_t max_tcp_buffer_size = 4096;  // 4KB
 const static int32_t max_udp_buffer_size = 8192;  // 8KB
 
+const static int32_t min_read_iob_size = 1024;       // 1KB
+const static int32_t max_read_iob_size = 64 * 1024;  // 64KB
+
+// Max size of one sending with send limiter, which lets transports sharing the
+// limiter send in turn.
+const static int32_t max_limited_send_size = 64 * 1024;  // 64KB
+
 class pump_lib base_channel
   : public service_getter,
     public poll::channel {
@@ -48,7 +59,8 @@ class pump_lib base_channel
       : service_getter(sv),
         poll::channel(fd),
         type_(type),
-        state_(state_none) {
+        state_(state_none),
+        shard_(invalid_sid) {
     }
 
     /*********************************************************************************
@@ -70,7 +82,33 @@ class pump_lib base_channel
         return __is_state(state_started, std::memory_order_relaxed);
     }
 
+    /*********************************************************************************
+     * Get poller shard
+     ********************************************************************************/
+    pump_inline shard_id get_shard() const noexcept {
+        return shard_;
+    }
+
+    /*********************************************************************************
+     * Set poller shard
+     * This should be called before starting.
+     ********************************************************************************/
+    pump_inline void set_shard(shard_id sid) noexcept {
+        shard_ = sid;
+    }
+
   protected:
+    /*********************************************************************************
+     * Get poller of the bound shard
+     * If no shard is bound, service will select one.
+     ********************************************************************************/
+    pump_inline poll::poller *__get_poller(poller_id pid) {
+        if (shard_ == invalid_sid) {
+            shard_ = get_service()->select_shard();
+        }
+        return get_service()->get_poller(shard_, pid);
+    }
+
     /*********************************************************************************
      * Set channel state
      ********************************************************************************/
@@ -100,7 +138,7 @@ class pump_lib base_channel
         int32_t event,
         void *arg = nullptr,
         poller_id pid = send_pid) {
-        return get_service()->post_channel_event(ch, event, arg, pid);
+        return get_service()->post_channel_event(ch, event, arg, shard_, pid);
     }
 
   protected:
@@ -108,11 +146,20 @@ class pump_lib base_channel
     transport_type type_;
     // Transport state
     std::atomic<transport_state> state_;
+    // Poller shard
+    shard_id shard_;
 };
 
 const static int32_t channel_event_disconnected = 0;
 const static int32_t channel_event_buffer_sent = 1;
 const static int32_t channel_event_read = 2;
+const static int32_t channel_event_send_watermark = 3;
+const static int32_t channel_event_send = 4;
+const static int32_t channel_event_buffers_sent = 5;
+const static int32_t channel_event_handshake_step = 6;
+
+// Io buffer batch
+typedef std::vector<toolkit::io_buffer *> io_buffer_batch;
 
 class pump_lib base_transport
   : public base_channel,
@@ -128,7 +175,26 @@ class pump_lib base_transport
       : base_channel(type, sv, fd),
         rmode_(read_mode_none),
         rstate_(read_none),
-        pending_send_size_(0) {
+        single_reg_(false),
+        edge_read_(false),
+        read_budget_size_(0),
+        read_budget_count_(0),
+        read_iob_size_(max_tcp_buffer_size),
+        read_iob_min_size_(min_read_iob_size),
+        read_iob_max_size_(max_read_iob_size),
+        read_iob_idle_cnt_(0),
+        send_iobs_size_(0),
+        carried_iob_(nullptr),
+        sendlist_(32),
+        pending_send_size_(0),
+        send_high_watermark_(0),
+        send_low_watermark_(0),
+        send_paused_(false),
+        send_paused_changes_(0),
+        send_paused_notified_(false),
+        send_paused_notified_changes_(0),
+        sent_batch_(nullptr),
+        spare_sent_batch_(nullptr) {
     }
 
     /*********************************************************************************
@@ -182,6 +248,15 @@ class pump_lib base_transport
         return error_disable;
     }
 
+    /*********************************************************************************
+     * Send file region
+     * The region is sent after buffers sent before, and file fd can be closed
+     * after calling. Sent callback is triggered with the buffer of the region.
+     ********************************************************************************/
+    virtual error_code send_file(int32_t fd, int64_t offset, int32_t size) {
+        return error_disable;
+    }
+
     /*********************************************************************************
      * Send buffer to peer address
      ********************************************************************************/
@@ -201,6 +276,48 @@ class pump_lib base_transport
         return error_disable;
     }
 
+    /*********************************************************************************
+     * Send datagrams to their peer addresses in batch
+     * If sent count is not null, it is set to count of datagrams sent.
+     ********************************************************************************/
+    virtual error_code send_batch(
+        const udp_datagram *dgs,
+        int32_t count,
+        int32_t *sent_count = nullptr) {
+        return error_disable;
+    }
+
+    /*********************************************************************************
+     * Set single registration
+     * Read and send trackers share one registration in the read poller, which
+     * halves poller registrations of a connection. This should be called before
+     * starting, and it doesn't work with edge triggered read.
+     ********************************************************************************/
+    pump_inline void set_single_registration(bool on) noexcept {
+        single_reg_ = on;
+    }
+
+    /*********************************************************************************
+     * Set read budget
+     * Transport reads until no more data or the budget is used up on every read
+     * event, instead of reading once. Size limits read bytes and count limits
+     * read times, zero means no limit. Data read to io buffers is coalesced
+     * until the buffer is full. It only works with read loop mode, and should
+     * be set before starting.
+     ********************************************************************************/
+    pump_inline void set_read_budget(int32_t size, int32_t count) noexcept {
+        read_budget_size_ = size > 0 ? size : 0;
+        read_budget_count_ = count > 0 ? count : 0;
+    }
+
+    /*********************************************************************************
+     * Set read io buffer size range
+     * Io buffers handed to read io buffer callback start with the max tcp buffer
+     * size, grow when reads fill them and shrink when reads keep much smaller.
+     * This should be called before starting.
+     ********************************************************************************/
+    void set_read_iob_size_range(int32_t min_size, int32_t max_size);
+
     /*********************************************************************************
      * Get pending send buffer size
      ********************************************************************************/
@@ -208,6 +325,36 @@ class pump_lib base_transport
         return pending_send_size_.load(std::memory_order_relaxed);
     }
 
+    /*********************************************************************************
+     * Set send watermarks
+     * When pending send size reaches the high watermark, send paused callback is
+     * triggered. After it falls back to the low watermark, send resumed callback
+     * is triggered. Sending is still accepted when paused. Zero high watermark
+     * turns off watermarks.
+     ********************************************************************************/
+    void set_send_watermark(int32_t high, int32_t low);
+
+    /*********************************************************************************
+     * Set rate limiters
+     * Reading stops when read limiter is exhausted, and sending holds buffers in
+     * sendlist when send limiter is exhausted, then they are resumed after the
+     * limiter is refilled. Share one limiter by transports to limit them as a
+     * group. This should be called before starting.
+     ********************************************************************************/
+    pump_inline void set_read_limiter(const rate_limiter_sptr &limiter) {
+        read_limiter_ = limiter;
+    }
+    pump_inline void set_send_limiter(const rate_limiter_sptr &limiter) {
+        send_limiter_ = limiter;
+    }
+
+    /*********************************************************************************
+     * Get send paused status
+     ********************************************************************************/
+    pump_inline bool is_send_paused() const noexcept {
+        return send_paused_.load(std::memory_order_relaxed);
+    }
+
     /*********************************************************************************
      * Get local address
      ********************************************************************************/
@@ -228,6 +375,22 @@ class pump_lib base_transport
      ********************************************************************************/
     virtual void on_channel_event(int32_t ev, void *arg) override;
 
+    /*********************************************************************************
+     * Read event callback
+     ********************************************************************************/
+    virtual void on_read_event() override;
+
+    /*********************************************************************************
+     * Send event callback
+     ********************************************************************************/
+    virtual void on_send_event() override;
+
+    /*********************************************************************************
+     * Limiter refilled callbacks
+     ********************************************************************************/
+    static void on_read_limiter_refilled(base_transport_wptr transp);
+    static void on_send_limiter_refilled(base_transport_wptr transp);
+
   protected:
     /*********************************************************************************
      * Shutdown transport flow
@@ -240,6 +403,66 @@ class pump_lib base_transport
     virtual void __close_transport_flow() {
     }
 
+    /*********************************************************************************
+     * Read from transport flow
+     * It returns read size like net read.
+     ********************************************************************************/
+    virtual int32_t __read_from_flow(char *b, int32_t size) {
+        return 0;
+    }
+
+    /*********************************************************************************
+     * Check transport flow has buffered data to read or not
+     * Data buffered in flow doesn't trigger read tracker.
+     ********************************************************************************/
+    virtual bool __has_buffered_read_data() {
+        return false;
+    }
+
+    /*********************************************************************************
+     * Handle no more data to read
+     ********************************************************************************/
+    virtual void __handle_read_again() {
+    }
+
+    /*********************************************************************************
+     * Send buffers by transport flow
+     * Rest of file buffer beyond max file size is left in the buffer.
+     ********************************************************************************/
+    virtual error_code __send_to_flow(
+        toolkit::io_buffer **iobs,
+        int32_t count,
+        int32_t max_file_size) {
+        return error_fault;
+    }
+
+    /*********************************************************************************
+     * Continue sending buffers by transport flow
+     ********************************************************************************/
+    virtual error_code __resend_to_flow() {
+        return error_fault;
+    }
+
+    /*********************************************************************************
+     * Flush data generated by transport flow itself
+     ********************************************************************************/
+    virtual error_code __flush_flow() {
+        return error_fault;
+    }
+
+    /*********************************************************************************
+     * Check buffer sent alone or not
+     ********************************************************************************/
+    virtual bool __is_sent_alone(toolkit::io_buffer *iob) const noexcept {
+        return false;
+    }
+
+    /*********************************************************************************
+     * Handle sent buffers
+     * Sent buffers are handed to sent callbacks.
+     ********************************************************************************/
+    virtual void __handle_sent_buffers();
+
     /*********************************************************************************
      * Change read state
      ********************************************************************************/
@@ -267,7 +490,7 @@ class pump_lib base_transport
     /*********************************************************************************
      * Install trackers
      ********************************************************************************/
-    bool __install_read_tracker();
+    bool __install_read_tracker(int32_t mode = poll::tracker_mode_oneshot);
     bool __install_send_tracker();
 
     /*********************************************************************************
@@ -276,12 +499,236 @@ class pump_lib base_transport
     void __uninstall_read_tracker();
     void __uninstall_send_tracker();
 
+    /*********************************************************************************
+     * Uninstall read and send trackers
+     * Flows of transports close sockets when destroyed, which is before base
+     * transport deconstructor. So transports uninstall trackers in their own
+     * deconstructors, otherwise removing a closed fd from poller fails or removes
+     * a new socket reusing the fd.
+     ********************************************************************************/
+    pump_inline void __uninstall_trackers() {
+        __uninstall_read_tracker();
+        __uninstall_send_tracker();
+    }
+
     /*********************************************************************************
      * Start trackers
      ********************************************************************************/
     bool __start_read_tracker();
     bool __start_send_tracker();
 
+    /*********************************************************************************
+     * Read until no more data or read budget used up
+     * Without read budget or edge triggered read, it reads once, and data
+     * buffered in transport flow is read as well.
+     ********************************************************************************/
+    void __read_until_again();
+
+    /*********************************************************************************
+     * Check read budget enabled
+     ********************************************************************************/
+    pump_inline bool __has_read_budget() const noexcept {
+        return read_budget_size_ > 0 || read_budget_count_ > 0;
+    }
+
+    /*********************************************************************************
+     * Check read budget used up
+     ********************************************************************************/
+    pump_inline bool __is_read_budget_used(
+        int32_t size,
+        int32_t count) const noexcept {
+        return (read_budget_size_ > 0 && size >= read_budget_size_) ||
+               (read_budget_count_ > 0 && count >= read_budget_count_);
+    }
+
+    /*********************************************************************************
+     * Read data
+     * If read io buffer callback is set, data is read to the io buffer. A new io
+     * buffer is created if the io buffer is null, else data is appended to it.
+     ********************************************************************************/
+    int32_t __read(char *b, toolkit::io_buffer **iob);
+
+    /*********************************************************************************
+     * Callback read data
+     ********************************************************************************/
+    void __callback_read(const char *b, int32_t size, toolkit::io_buffer *iob);
+
+    /*********************************************************************************
+     * Continue reading
+     * Edge read tracker is not triggered by old data, and read tracker is not
+     * triggered by data buffered in transport flow, so a read event is posted
+     * for them.
+     ********************************************************************************/
+    bool __continue_read();
+
+    /*********************************************************************************
+     * Resume reading
+     * If read limiter is exhausted, reading is resumed after it is refilled.
+     ********************************************************************************/
+    pump_inline bool __resume_read() {
+        if (pump_unlikely(__is_read_limited())) {
+            __wait_read_limiter();
+            return true;
+        }
+        return __continue_read();
+    }
+
+    /*********************************************************************************
+     * Resume reading after read limiter refilled
+     ********************************************************************************/
+    void __resume_limited_read();
+
+    /*********************************************************************************
+     * Check limited status
+     ********************************************************************************/
+    pump_inline bool __is_read_limited() const noexcept {
+        return read_limiter_ && read_limiter_->is_exhausted();
+    }
+    pump_inline bool __is_send_limited() const noexcept {
+        return send_limiter_ && send_limiter_->is_exhausted();
+    }
+
+    /*********************************************************************************
+     * Get limited send size
+     * It is tokens of send limiter clamped by max limited send size, and at least
+     * one byte is sent.
+     ********************************************************************************/
+    pump_inline int32_t __get_limited_send_size() const noexcept {
+        auto tokens = send_limiter_->get_tokens();
+        if (tokens > max_limited_send_size) {
+            return max_limited_send_size;
+        } else if (tokens < 1) {
+            return 1;
+        }
+        return (int32_t)tokens;
+    }
+
+    /*********************************************************************************
+     * Wait limiters refilled
+     ********************************************************************************/
+    void __wait_read_limiter();
+    void __wait_send_limiter();
+
+    /*********************************************************************************
+     * Async send
+     ********************************************************************************/
+    bool __async_send(toolkit::io_buffer *iob);
+
+    /*********************************************************************************
+     * Async flush
+     * Flushing takes one byte of pending send size, so it is done by the thread
+     * getting send chance like sending buffers.
+     ********************************************************************************/
+    bool __async_flush();
+
+    /*********************************************************************************
+     * Try sending
+     * If there are no more pending buffers, the send chance is got and buffers
+     * are sent at once.
+     ********************************************************************************/
+    bool __try_sending(int32_t size);
+
+    /*********************************************************************************
+     * Send once
+     * Buffers in sendlist are gathered and sent by transport flow together.
+     ********************************************************************************/
+    error_code __send_once();
+
+    /*********************************************************************************
+     * Flush once
+     * It is done when the pending send size has no buffer in sendlist.
+     ********************************************************************************/
+    error_code __flush_once();
+
+    /*********************************************************************************
+     * Clear sendlist
+     ********************************************************************************/
+    void __clear_sendlist();
+
+    /*********************************************************************************
+     * Add pending send size
+     * Return pending send size before adding.
+     ********************************************************************************/
+    pump_inline int32_t __add_pending_send_size(int32_t size) {
+        auto pending = pending_send_size_.fetch_add(size);
+        if (pump_unlikely(send_high_watermark_.load(std::memory_order_relaxed) > 0)) {
+            __check_send_high_watermark(pending + size);
+        }
+        return pending;
+    }
+
+    /*********************************************************************************
+     * Reduce pending send size
+     * Return pending send size before reducing.
+     ********************************************************************************/
+    pump_inline int32_t __reduce_pending_send_size(int32_t size) {
+        auto pending = pending_send_size_.fetch_sub(size);
+        if (pump_unlikely(send_paused_.load())) {
+            __check_send_low_watermark(pending - size);
+        }
+        return pending;
+    }
+
+    /*********************************************************************************
+     * Check send watermarks
+     ********************************************************************************/
+    void __check_send_high_watermark(int32_t pending_size);
+    void __check_send_low_watermark(int32_t pending_size);
+
+    /*********************************************************************************
+     * Trigger send paused or resumed callback
+     ********************************************************************************/
+    void __trigger_send_watermark_callback();
+    void __trigger_send_watermark_callback(bool paused);
+
+    /*********************************************************************************
+     * Batch sent buffer
+     ********************************************************************************/
+    pump_inline void __batch_sent_buffer(toolkit::io_buffer *iob) {
+        if (sent_batch_ == nullptr) {
+            sent_batch_ = __take_sent_batch();
+        }
+        sent_batch_->push_back(iob);
+    }
+
+    /*********************************************************************************
+     * Flush sent buffers
+     * Batched sent buffers are handed to sent batch callback in send poller.
+     * This should be called at the end of every sending pass.
+     ********************************************************************************/
+    pump_inline void __flush_sent_buffers() {
+        if (sent_batch_ != nullptr) {
+            __post_channel_event(
+                shared_from_this(),
+                channel_event_buffers_sent,
+                sent_batch_);
+            sent_batch_ = nullptr;
+        }
+    }
+
+    /*********************************************************************************
+     * Take sent batch
+     * The batch handed to callback is reused by next sending pass.
+     ********************************************************************************/
+    io_buffer_batch *__take_sent_batch();
+
+    /*********************************************************************************
+     * Trigger sent batch callback
+     ********************************************************************************/
+    void __trigger_sent_batch_callback(io_buffer_batch *batch);
+
+    /*********************************************************************************
+     * Create read io buffer with the adaptive size
+     ********************************************************************************/
+    pump_inline toolkit::io_buffer *__create_read_iob() {
+        return toolkit::io_buffer::create(read_iob_size_);
+    }
+
+    /*********************************************************************************
+     * Adapt read io buffer size by last read size
+     ********************************************************************************/
+    void __adapt_read_iob_size(int32_t read_size);
+
   protected:
     // Local address
     address local_address_;
@@ -296,9 +743,54 @@ class pump_lib base_transport
     read_mode rmode_;
     std::atomic<read_state> rstate_;
 
+    // Single registration
+    bool single_reg_;
+
+    // Edge triggered read
+    bool edge_read_;
+
+    // Read budget
+    int32_t read_budget_size_;
+    int32_t read_budget_count_;
+
+    // Read io buffer size
+    int32_t read_iob_size_;
+    int32_t read_iob_min_size_;
+    int32_t read_iob_max_size_;
+    // Count of continuous small reads
+    int32_t read_iob_idle_cnt_;
+
+    // Sending buffers gathered from sendlist
+    std::vector<toolkit::io_buffer *> send_iobs_;
+    // Data size of sending buffers
+    int32_t send_iobs_size_;
+    // Buffer popped from sendlist but not sent yet
+    toolkit::io_buffer *carried_iob_;
+    // Send buffer list
+    toolkit::freelock_m2m_queue<toolkit::io_buffer *, 8> sendlist_;
+
     // Pending send buffer size
     std::atomic_int32_t pending_send_size_;
 
+    // Send watermarks
+    std::atomic_int32_t send_high_watermark_;
+    std::atomic_int32_t send_low_watermark_;
+    // Send paused status and its change count
+    std::atomic_bool send_paused_;
+    std::atomic_uint32_t send_paused_changes_;
+    // Send paused status and its change count notified by callbacks
+    bool send_paused_notified_;
+    uint32_t send_paused_notified_changes_;
+
+    // Sent buffers batch of current sending pass
+    io_buffer_batch *sent_batch_;
+    // Spare sent buffers batch
+    std::atomic<io_buffer_batch *> spare_sent_batch_;
+
+    // Rate limiters
+    rate_limiter_sptr read_limiter_;
+    rate_limiter_sptr send_limiter_;
+
     // Transport callbacks
     transport_callbacks cbs_;
 };
@@ -17,6 +17,9 @@
 #ifndef pump_transport_callbacks_h
 #define pump_transport_callbacks_h
 
+#include <vector>
+
+#include <pump/toolkit/buffer.h>
 #include <pump/transport/address.h>
 
 namespace pump {
@@ -28,6 +31,8 @@ DEFINE_SMART_POINTERS(base_transport);
 struct acceptor_callbacks {
     // Accepted callback
     pump_function<void(base_transport_sptr &)> accepted_cb;
+    // Accepted batch callback for tcp, it replaces accepted callback if set
+    pump_function<void(std::vector<base_transport_sptr> &)> accepted_batch_cb;
     // Acceptor Stopped calloback
     pump_function<void()> stopped_cb;
 };
@@ -41,13 +46,39 @@ struct dialer_callbacks {
     pump_function<void()> stopped_cb;
 };
 
+struct udp_datagram {
+    // Peer address
+    address addr;
+    // Datagram data
+    const char *data;
+    // Datagram size
+    int32_t size;
+};
+
 struct transport_callbacks {
     // Read callback for tcp and tls
     pump_function<void(const char *, int32_t)> read_cb;
+    // Read io buffer callback for tcp and tls, it replaces read callback if set.
+    // The io buffer is unreferred after callback, refer it to keep the data.
+    pump_function<void(toolkit::io_buffer *)> read_iob_cb;
     // Read from callback for udp
     pump_function<void(const address &, const char *, int32_t)> read_from_cb;
+    // Read from batch callback for udp, it replaces read from callback if set.
+    // Datagrams read with one system call are handed to it together, and their
+    // data is invalid after callback.
+    pump_function<void(const udp_datagram *, int32_t)> read_from_batch_cb;
     // Sent callabck
     pump_function<void(toolkit::io_buffer *)> sent_cb;
+    // Sent batch callback for tcp and tls, it replaces sent callback if set.
+    // Buffers sent in a sending pass are handed to it together instead of one by
+    // one, and they are unreferred after callback.
+    pump_function<void(toolkit::io_buffer **, int32_t)> sent_batch_cb;
+    // Send paused callback for tcp and tls, pending send size reached the high
+    // watermark
+    pump_function<void()> send_paused_cb;
+    // Send resumed callback for tcp and tls, pending send size fell back to the
+    // low watermark
+    pump_function<void()> send_resumed_cb;
     // Transport disconnected callback for tcp and tls
     pump_function<void()> disconnected_cb;
     // Transport stopped callback
@@ -17,6 +17,8 @@
 #ifndef pump_transport_flow_tcp_h
 #define pump_transport_flow_tcp_h
 
+#include <map>
+
 #include <pump/transport/flow/flow.h>
 
 namespace pump {
@@ -40,6 +42,13 @@ class flow_tcp : public flow_base {
      ********************************************************************************/
     bool init(poll::channel_sptr &&ch, pump_socket fd) noexcept;
 
+    /*********************************************************************************
+     * Enable zero copy sending
+     * Single buffer not less than the threshold is sent with zero copy, and it
+     * must keep unchanged until kernel completes the sending.
+     ********************************************************************************/
+    bool enable_zerocopy(int32_t threshold);
+
     /*********************************************************************************
      * Read
      ********************************************************************************/
@@ -49,13 +58,20 @@ class flow_tcp : public flow_base {
 
     /*********************************************************************************
      * Want to send
-     * Try sending data as much as possible.
+     * Try sending data of buffers as much as possible. Buffers are gathered and
+     * sent by one system call, and they must keep valid until finished. File
+     * buffer is sent by sendfile, and it must be sent alone. If max file size is
+     * set, sending of file buffer finishes after the max size is sent, and the
+     * rest of it is left in the buffer.
      * Return results:
      *      error_none  => finish
      *      error_again => again
      *      error_fault => error
      ********************************************************************************/
-    error_code want_to_send(toolkit::io_buffer *iob);
+    error_code want_to_send(
+        toolkit::io_buffer **iobs,
+        int32_t count,
+        int32_t max_file_size = 0);
 
     /*********************************************************************************
      * Send
@@ -66,9 +82,62 @@ class flow_tcp : public flow_base {
      ********************************************************************************/
     error_code send();
 
+    /*********************************************************************************
+     * Check last buffer sent with zero copy or not
+     ********************************************************************************/
+    pump_inline bool is_zerocopy_sent() const noexcept {
+        return zc_sending_;
+    }
+
+    /*********************************************************************************
+     * Get zero copy counter
+     * Every zero copy sending is numbered by the counter in order.
+     ********************************************************************************/
+    pump_inline uint32_t get_zerocopy_counter() const noexcept {
+        return zc_counter_;
+    }
+
+    /*********************************************************************************
+     * Read zero copy completions
+     * Zero copy sendings numbered before the completed counter are completed.
+     * Return results:
+     *     error_none  => no more completion
+     *     error_fault => error
+     ********************************************************************************/
+    error_code read_zerocopy_completions();
+
+    /*********************************************************************************
+     * Get zero copy completed counter
+     ********************************************************************************/
+    pump_inline uint32_t get_zerocopy_completed() const noexcept {
+        return zc_completed_;
+    }
+
+  private:
+    /*********************************************************************************
+     * Complete zero copy sendings
+     ********************************************************************************/
+    void __complete_zerocopy(uint32_t lo, uint32_t hi);
+
   private:
-    // Send buffer
-    toolkit::io_buffer *send_iob_;
+    // Send buffers
+    toolkit::io_buffer **send_iobs_;
+    int32_t send_iob_count_;
+    // First unfinished send buffer index
+    int32_t send_iob_index_;
+    // Size of file buffer left to send
+    int32_t send_file_left_;
+
+    // Zero copy threshold
+    int32_t zc_threshold_;
+    // Sending with zero copy
+    bool zc_sending_;
+    // Zero copy counter
+    uint32_t zc_counter_;
+    // Zero copy completed counter
+    uint32_t zc_completed_;
+    // Zero copy completions out of order
+    std::map<uint32_t, uint32_t> zc_completions_;
 };
 DEFINE_SMART_POINTERS(flow_tcp);
 
@@ -38,7 +38,10 @@ class flow_tcp_acceptor : public flow_base {
     /*********************************************************************************
      * Init flow
      ********************************************************************************/
-    bool init(poll::channel_sptr &&ch, const address &listen_address);
+    bool init(
+        poll::channel_sptr &&ch,
+        const address &listen_address,
+        bool reuse_port = false);
 
     /*********************************************************************************
      * Accept
@@ -17,11 +17,22 @@
 #ifndef pump_transport_flow_tls_h
 #define pump_transport_flow_tls_h
 
+#include <mutex>
+#include <vector>
+
 #include <pump/transport/tls_utils.h>
 #include <pump/transport/flow/flow.h>
 
 namespace pump {
 namespace transport {
+
+// Max ciphertext size read from socket at once with memory bio
+const static int32_t max_tls_read_batch_size = 65536;  // 64KB
+// Max data size encrypted at once before sending with memory bio
+const static int32_t max_tls_send_batch_size = 262144;  // 256KB
+// Max ciphertext size of one record buffer with memory bio
+const static int32_t max_tls_record_iob_size = 65536;  // 64KB
+
 namespace flow {
 
 struct tls_session;
@@ -41,43 +52,81 @@ class flow_tls : public flow_base {
 
     /*********************************************************************************
      * Init
+     * With memory bio, ciphertext is read from socket in batches and fed to tls
+     * session, and records of tls session are collected to buffers which are
+     * gathered and sent by flow.
      ********************************************************************************/
     bool init(
         poll::channel_sptr &ch,
         bool client,
         pump_socket fd,
-        transport::tls_credentials xcred);
+        transport::tls_credentials xcred,
+        bool memory_bio = false);
 
     /*********************************************************************************
-     * Handshake
+     * Resume session
+     * Client flow resumes the session stored with the key, and new sessions are
+     * stored with the key. This should be called before handshake.
      ********************************************************************************/
-    pump_inline tls_handshake_phase handshake() {
-        return transport::tls_handshake(session_);
+    pump_inline bool resume_session(
+        transport::tls_session_store_sptr &store,
+        const std::string &key) {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        return transport::tls_resume_session(session_, store, key);
     }
 
     /*********************************************************************************
-     * Read
+     * Check session resumed or not
      ********************************************************************************/
-    pump_inline int32_t read(char *b, int32_t size) {
-        return transport::tls_read(session_, b, size);
+    pump_inline bool is_session_resumed() const {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        return transport::tls_is_session_resumed(session_);
     }
 
+    /*********************************************************************************
+     * Handshake
+     ********************************************************************************/
+    tls_handshake_phase handshake();
+
+    /*********************************************************************************
+     * Read
+     ********************************************************************************/
+    int32_t read(char *b, int32_t size);
+
     /*********************************************************************************
      * Check there are data to read or not
      ********************************************************************************/
     pump_inline bool has_unread_data() const {
+        std::lock_guard<std::mutex> lock(session_mx_);
         return transport::tls_has_unread_data(session_);
     }
 
+    /*********************************************************************************
+     * Check records generated on reading are pending or not
+     * With memory bio, records such as key update response are generated on
+     * reading, and they should be flushed.
+     ********************************************************************************/
+    pump_inline bool has_pending_records() const noexcept {
+        return pending_records_;
+    }
+
+    /*********************************************************************************
+     * Check using memory bio or not
+     ********************************************************************************/
+    pump_inline bool is_memory_bio() const noexcept {
+        return memory_bio_;
+    }
+
     /*********************************************************************************
      * Want to send
-     * Try sending data as much as possible.
+     * Try sending data of buffers as much as possible. Buffers must keep valid
+     * until finished.
      * Return results:
      *     error_none  => finish
      *     error_again => again
      *     error_fault => error
      ********************************************************************************/
-    error_code want_to_send(toolkit::io_buffer *iob);
+    error_code want_to_send(toolkit::io_buffer **iobs, int32_t count);
 
     /*********************************************************************************
      * Send
@@ -88,13 +137,83 @@ class flow_tls : public flow_base {
      ********************************************************************************/
     error_code send();
 
+    /*********************************************************************************
+     * Flush records
+     * Records pending in tls session are taken and sent. It must not be called
+     * when sending buffers.
+     * Return results:
+     *     error_none  => finish
+     *     error_again => again
+     *     error_fault => error
+     ********************************************************************************/
+    error_code flush_records();
+
+    /*********************************************************************************
+     * Shutdown
+     * Close notify is sent before shutting down sending of socket.
+     ********************************************************************************/
+    void shutdown(int32_t how);
+
+  private:
+    /*********************************************************************************
+     * Send by memory bio
+     * Data of buffers is encrypted in batches, and records of each batch are
+     * sent before encrypting next batch.
+     ********************************************************************************/
+    error_code __send_by_memory_bio();
+
+    /*********************************************************************************
+     * Read records
+     * Read ciphertext from socket and feed it to tls session. It returns read
+     * size like net read.
+     ********************************************************************************/
+    int32_t __read_records();
+
+    /*********************************************************************************
+     * Take records
+     * Take records from tls session to record buffers.
+     ********************************************************************************/
+    bool __take_records();
+
+    /*********************************************************************************
+     * Send records
+     * Record buffers are gathered and sent with one system call.
+     * Return results:
+     *     error_none  => finish
+     *     error_again => again
+     *     error_fault => error
+     ********************************************************************************/
+    error_code __send_records();
+
+    /*********************************************************************************
+     * Clear record buffers
+     ********************************************************************************/
+    void __clear_records();
+
   private:
     // Handshaked status
     bool is_handshaked_;
     // TLS session
     transport::tls_session *session_;
-    // Current sending io buffer
-    toolkit::io_buffer *send_iob_;
+    // Session locker
+    // Tls session is read by read event and written by sending in different
+    // threads, which must not use it at the same time.
+    mutable std::mutex session_mx_;
+    // Memory bio mode
+    bool memory_bio_;
+    // Send buffers
+    toolkit::io_buffer **send_iobs_;
+    int32_t send_iob_count_;
+    // First unfinished send buffer index
+    int32_t send_iob_index_;
+    // Ciphertext read buffer with memory bio
+    toolkit::io_buffer *read_iob_;
+    // Records generated on reading are pending with memory bio
+    bool pending_records_;
+    // Record buffers waiting to send with memory bio
+    std::vector<toolkit::io_buffer *> record_iobs_;
+    // Spare record buffer for reusing
+    toolkit::io_buffer *spare_record_iob_;
 };
 DEFINE_SMART_POINTERS(flow_tls);
 
@@ -17,10 +17,19 @@
 #ifndef pump_transport_flow_udp_h
 #define pump_transport_flow_udp_h
 
+#include <pump/transport/callbacks.h>
 #include <pump/transport/flow/flow.h>
 
 namespace pump {
 namespace transport {
+
+// Max segment count and data size of one udp sending with segment offload
+const static int32_t max_udp_gso_segments = 64;
+const static int32_t max_udp_gso_size = 65507;
+
+// Udp read buffer size for datagrams coalesced by gro
+const static int32_t max_udp_gro_buffer_size = 65536;  // 64KB
+
 namespace flow {
 
 class flow_udp : public flow_base {
@@ -40,6 +49,18 @@ class flow_udp : public flow_base {
      ********************************************************************************/
     bool init(poll::channel_sptr &&ch, const address &bind_address);
 
+    /*********************************************************************************
+     * Enable udp segment offload
+     * Datagram larger than the segment size is segmented by kernel.
+     ********************************************************************************/
+    bool enable_gso(int32_t segment_size);
+
+    /*********************************************************************************
+     * Enable udp receive offload
+     * Datagrams maybe coalesced by kernel, read them with read_from_gro.
+     ********************************************************************************/
+    bool enable_gro();
+
     /*********************************************************************************
      * Read from
      ********************************************************************************/
@@ -48,6 +69,28 @@ class flow_udp : public flow_base {
         int32_t size,
         address *from);
 
+    /*********************************************************************************
+     * Read from with gro
+     * Read datagram maybe coalesced, and set its segment size.
+     ********************************************************************************/
+    int32_t read_from_gro(
+        char *b,
+        int32_t size,
+        address *from,
+        int32_t *segment_size);
+
+    /*********************************************************************************
+     * Read from batch
+     * Datagrams are read to the buffer, every datagram owns a space of the size
+     * in the buffer. Return read datagram count, -1 if no datagram and 0 if
+     * failed.
+     ********************************************************************************/
+    int32_t read_from_batch(
+        char *b,
+        int32_t size,
+        udp_datagram *dgs,
+        int32_t count);
+
     /*********************************************************************************
      * Send to
      * Return sent size.
@@ -56,6 +99,13 @@ class flow_udp : public flow_base {
         const char *b,
         int32_t size,
         const address &to);
+
+    /*********************************************************************************
+     * Send batch
+     * Return sent datagram count, -1 if socket buffer is full and 0 if the first
+     * datagram failed.
+     ********************************************************************************/
+    int32_t send_batch(const udp_datagram *dgs, int32_t count);
 };
 DEFINE_SMART_POINTERS(flow_udp);
 
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_transport_rate_limiter_h
+#define pump_transport_rate_limiter_h
+
+#include <mutex>
+#include <vector>
+
+#include <pump/service.h>
+#include <pump/time/timer.h>
+#include <pump/toolkit/features.h>
+
+namespace pump {
+namespace transport {
+
+class rate_limiter;
+DEFINE_SMART_POINTERS(rate_limiter);
+
+/*********************************************************************************
+ * The rate_limiter is a token bucket which limits bytes per second. Tokens are
+ * refilled by a timer of service, and transports which use up tokens wait for
+ * next refilling. One limiter can be shared by transports as a group quota, and
+ * a parent limiter limits a group of limiters as well.
+ ********************************************************************************/
+class pump_lib rate_limiter
+  : public toolkit::noncopyable,
+    public std::enable_shared_from_this<rate_limiter> {
+  public:
+    // Waiter callback
+    typedef pump_function<void()> waiter_callback;
+
+  public:
+    /*********************************************************************************
+     * Create instance
+     * The rate is bytes per second, and the burst is max token count. Default
+     * burst is tokens of 100ms, and burst is at least tokens of one refilling.
+     ********************************************************************************/
+    pump_inline static rate_limiter_sptr create(
+        int64_t rate,
+        int64_t burst = 0,
+        const rate_limiter_sptr &parent = rate_limiter_sptr()) {
+        pump_object_create_inline(rate_limiter, obj, rate, burst, parent);
+        return rate_limiter_sptr(obj, pump_object_destroy<rate_limiter>);
+    }
+
+    /*********************************************************************************
+     * Deconstructor
+     ********************************************************************************/
+    ~rate_limiter();
+
+    /*********************************************************************************
+     * Start refilling with timer of service
+     ********************************************************************************/
+    bool start(service *sv);
+
+    /*********************************************************************************
+     * Stop refilling
+     * Limiter doesn't limit any more after stopped, and waiters are resumed.
+     ********************************************************************************/
+    void stop();
+
+    /*********************************************************************************
+     * Set rate and burst
+     ********************************************************************************/
+    void set_rate(int64_t rate, int64_t burst = 0);
+
+    /*********************************************************************************
+     * Get rate
+     ********************************************************************************/
+    pump_inline int64_t get_rate() const noexcept {
+        return rate_.load(std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Get started status
+     ********************************************************************************/
+    pump_inline bool is_started() const noexcept {
+        return started_.load(std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Get available tokens
+     * Tokens maybe negative after consuming more than available. If limiter is
+     * not started, tokens are unlimited.
+     ********************************************************************************/
+    int64_t get_tokens() const noexcept;
+
+    /*********************************************************************************
+     * Check exhausted status
+     * Limiter with waiters is exhausted as well, then new comers wait behind
+     * them and no one is starved.
+     ********************************************************************************/
+    bool is_exhausted() const noexcept;
+
+    /*********************************************************************************
+     * Consume tokens
+     * Tokens consumed more than available are paid back by next refilling.
+     ********************************************************************************/
+    void consume(int64_t size) noexcept;
+
+    /*********************************************************************************
+     * Wait tokens
+     * The callback is called in the timer thread after the exhausted limiter is
+     * refilled, and it is called only once.
+     ********************************************************************************/
+    void wait(const waiter_callback &cb);
+
+  protected:
+    /*********************************************************************************
+     * Refill timeout callback
+     ********************************************************************************/
+    static void on_refill_timeout(rate_limiter_wptr limiter);
+
+  private:
+    /*********************************************************************************
+     * Constructor
+     ********************************************************************************/
+    rate_limiter(
+        int64_t rate,
+        int64_t burst,
+        const rate_limiter_sptr &parent) noexcept;
+
+    /*********************************************************************************
+     * Refill tokens
+     ********************************************************************************/
+    void __refill();
+
+    /*********************************************************************************
+     * Wake up waiters
+     ********************************************************************************/
+    void __wake_waiters();
+
+  private:
+    // Started status
+    std::atomic_bool started_;
+
+    // Rate and burst
+    std::atomic_int64_t rate_;
+    std::atomic_int64_t burst_;
+
+    // Available tokens
+    std::atomic_int64_t tokens_;
+    // Last refilling time
+    uint64_t last_refill_ns_;
+
+    // Parent limiter
+    rate_limiter_sptr parent_;
+
+    // Refill timer
+    time::timer_sptr timer_;
+
+    // Waiters
+    std::mutex waiter_mx_;
+    std::atomic_int32_t waiter_cnt_;
+    std::vector<waiter_callback> waiters_;
+};
+
+}  // namespace transport
+}  // namespace pump
+
+#endif
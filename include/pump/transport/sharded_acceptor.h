@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_transport_sharded_acceptor_h
+#define pump_transport_sharded_acceptor_h
+
+#include <vector>
+
+#include <pump/transport/base_acceptor.h>
+
+namespace pump {
+namespace transport {
+
+class sharded_acceptor;
+DEFINE_SMART_POINTERS(sharded_acceptor);
+
+/*********************************************************************************
+ * The sharded_acceptor starts one acceptor for every poller shard of service.
+ * Acceptors listen on the same address with SO_REUSEPORT, so kernel spreads
+ * incoming connections among shards, and every shard serves the connections
+ * accepted by itself.
+ ********************************************************************************/
+class pump_lib sharded_acceptor
+  : public toolkit::noncopyable,
+    public std::enable_shared_from_this<sharded_acceptor> {
+  public:
+    // Acceptor creator
+    typedef pump_function<base_acceptor_sptr()> acceptor_creator;
+
+  public:
+    /*********************************************************************************
+     * Create instance
+     ********************************************************************************/
+    pump_inline static sharded_acceptor_sptr create(const acceptor_creator &creator) {
+        pump_object_create_inline(sharded_acceptor, obj, creator);
+        return sharded_acceptor_sptr(obj, pump_object_destroy<sharded_acceptor>);
+    }
+
+    /*********************************************************************************
+     * Deconstructor
+     ********************************************************************************/
+    ~sharded_acceptor() = default;
+
+    /*********************************************************************************
+     * Start
+     * Stopped callback is triggered after acceptors of all shards stopped. If an
+     * acceptor fails to start, acceptors started before are stopped and error is
+     * returned, then stopped callback is triggered after they stopped if acceptor
+     * count is not zero.
+     ********************************************************************************/
+    error_code start(service *sv, const acceptor_callbacks &cbs);
+
+    /*********************************************************************************
+     * Stop
+     ********************************************************************************/
+    void stop();
+
+    /*********************************************************************************
+     * Get acceptor count
+     ********************************************************************************/
+    pump_inline int32_t get_acceptor_count() const noexcept {
+        return (int32_t)acceptors_.size();
+    }
+
+  protected:
+    /*********************************************************************************
+     * Acceptor accepted callback
+     * Transports accepted by non tcp acceptors are handed to batch callback.
+     ********************************************************************************/
+    static void on_accepted(
+        sharded_acceptor_wptr acceptor,
+        base_transport_sptr &transp);
+
+    /*********************************************************************************
+     * Acceptor stopped callback
+     ********************************************************************************/
+    static void on_stopped(sharded_acceptor_wptr acceptor);
+
+  private:
+    /*********************************************************************************
+     * Constructor
+     ********************************************************************************/
+    sharded_acceptor(const acceptor_creator &creator) noexcept;
+
+  private:
+    // Acceptor creator
+    acceptor_creator creator_;
+
+    // Started status
+    std::atomic_bool started_;
+
+    // Running acceptor count
+    std::atomic_int32_t running_count_;
+
+    // Shard acceptors
+    std::vector<base_acceptor_sptr> acceptors_;
+
+    // Acceptor callbacks
+    acceptor_callbacks cbs_;
+};
+
+}  // namespace transport
+}  // namespace pump
+
+#endif
@@ -17,7 +17,10 @@
 #ifndef pump_transport_tcp_transport_h
 #define pump_transport_tcp_transport_h
 
-#include <pump/toolkit/freelock_m2m_queue.h>
+#include <deque>
+#include <mutex>
+#include <vector>
+
 #include <pump/transport/flow/flow_tcp.h>
 #include <pump/transport/base_transport.h>
 
@@ -50,6 +53,29 @@ class pump_lib tcp_transport : public base_transport {
         const address &local_address,
         const address &remote_address);
 
+    /*********************************************************************************
+     * Set edge triggered read
+     * Transport will read until no more data on every read event, and its read
+     * tracker needs no restarting syscall. It only works with read loop mode,
+     * and should be set before starting.
+     ********************************************************************************/
+    pump_inline void set_edge_triggered_read(bool on) noexcept {
+        edge_read_ = on;
+    }
+
+    /*********************************************************************************
+     * Set zero copy send
+     * Buffer not less than the threshold is sent alone with zero copy, and it is
+     * kept referenced until kernel completes the sending, then sent callback is
+     * triggered. Buffer data must keep unchanged before that. Completions are
+     * read from socket error queue on read or send events. It only works with
+     * read loop mode, and should be set before starting. If socket doesn't
+     * support zero copy, buffers are sent with copy.
+     ********************************************************************************/
+    pump_inline void set_zerocopy_send(int32_t threshold) noexcept {
+        zc_threshold_ = threshold > 0 ? threshold : 0;
+    }
+
     /*********************************************************************************
      * Start
      ********************************************************************************/
@@ -85,17 +111,14 @@ class pump_lib tcp_transport : public base_transport {
      ********************************************************************************/
     virtual error_code send(toolkit::io_buffer *iob) override;
 
-  protected:
     /*********************************************************************************
-     * Channel event callback
+     * Send file region
+     * The region is queued in sendlist with buffers, and it is sent by sendfile
+     * without copying data to user space.
      ********************************************************************************/
-    virtual void on_channel_event(int32_t ev, void *arg) override;
-
-    /*********************************************************************************
-     * Read event callback
-     ********************************************************************************/
-    virtual void on_read_event() override;
+    virtual error_code send_file(int32_t fd, int64_t offset, int32_t size) override;
 
+  protected:
     /*********************************************************************************
      * Send event callback
      ********************************************************************************/
@@ -123,39 +146,84 @@ class pump_lib tcp_transport : public base_transport {
     virtual void __close_transport_flow() override;
 
     /*********************************************************************************
-     * Async send
+     * Read from transport flow
      ********************************************************************************/
-    bool __async_send(toolkit::io_buffer *b);
+    virtual int32_t __read_from_flow(char *b, int32_t size) override {
+        return flow_->read(b, size);
+    }
 
     /*********************************************************************************
-     * Send once
+     * Handle no more data to read
+     * Zero copy completions in socket error queue wake up reading as well.
      ********************************************************************************/
-    error_code __send_once();
+    virtual void __handle_read_again() override {
+        if (zc_threshold_ > 0) {
+            __release_zerocopy_buffers();
+        }
+    }
 
     /*********************************************************************************
-     * Handle sent buffer
+     * Send buffers by transport flow
      ********************************************************************************/
-    void __handle_sent_buffer();
+    virtual error_code __send_to_flow(
+        toolkit::io_buffer **iobs,
+        int32_t count,
+        int32_t max_file_size) override {
+        return flow_->want_to_send(iobs, count, max_file_size);
+    }
 
     /*********************************************************************************
-     * Clear sendlist
+     * Continue sending buffers by transport flow
      ********************************************************************************/
-    void __clear_sendlist();
+    virtual error_code __resend_to_flow() override {
+        return flow_->send();
+    }
+
+    /*********************************************************************************
+     * Check buffer sent alone or not
+     * File buffer and zero copy buffer are sent alone.
+     ********************************************************************************/
+    virtual bool __is_sent_alone(toolkit::io_buffer *iob) const noexcept override {
+        return iob->is_file() ||
+               (zc_threshold_ > 0 && (int32_t)iob->size() >= zc_threshold_);
+    }
+
+    /*********************************************************************************
+     * Handle sent buffers
+     * Rest of file buffer sent in chunks is carried instead, and zero copy buffer
+     * is held until kernel completes the sending.
+     ********************************************************************************/
+    virtual void __handle_sent_buffers() override;
+
+    /*********************************************************************************
+     * Hold zero copy buffer until kernel completes the sending
+     ********************************************************************************/
+    void __hold_zerocopy_buffer(toolkit::io_buffer *iob);
+
+    /*********************************************************************************
+     * Release zero copy buffers
+     * Completions are read from socket error queue, and completed buffers are
+     * handed to sent callback.
+     ********************************************************************************/
+    void __release_zerocopy_buffers();
+
+    /*********************************************************************************
+     * Clear zero copy buffers
+     ********************************************************************************/
+    void __clear_zerocopy_buffers();
 
   private:
     // Transport flow
     flow::flow_tcp_sptr flow_;
 
-    // Last send buffer
-    volatile int32_t last_send_iob_size_;
-    toolkit::io_buffer *last_send_iob_;
-    // volatile toolkit::io_buffer *last_send_iob_;
+    // Zero copy threshold
+    int32_t zc_threshold_;
+    // Zero copy buffers waiting for completion with their counters
+    std::mutex zc_mx_;
+    std::deque<std::pair<toolkit::io_buffer *, uint32_t>> zc_iobs_;
 
     // Pending send/read opt count
     std::atomic_int32_t pending_opt_cnt_;
-
-    // Send buffer list
-    toolkit::freelock_m2m_queue<toolkit::io_buffer *, 8> sendlist_;
 };
 
 }  // namespace transport
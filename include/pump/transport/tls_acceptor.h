@@ -17,6 +17,7 @@
 #ifndef pump_transport_tls_acceptor_h
 #define pump_transport_tls_acceptor_h
 
+#include <deque>
 #include <unordered_map>
 
 #include <pump/transport/tls_utils.h>
@@ -66,6 +67,40 @@ class pump_lib tls_acceptor
      ********************************************************************************/
     virtual void stop() override;
 
+    /*********************************************************************************
+     * Set memory bio
+     * Tls sessions of accepted transports use memory bios instead of socket, so ciphertext
+     * is read in batches and records are gathered to send. This should be called
+     * before starting.
+     ********************************************************************************/
+    pump_inline void set_memory_bio(bool on) noexcept {
+        memory_bio_ = on;
+    }
+
+    /*********************************************************************************
+     * Set handshake pool
+     * Handshake steps run in the pool instead of the poller, so a burst of new
+     * connections doesn't block established transports. This should be called
+     * before starting.
+     ********************************************************************************/
+    pump_inline void set_handshake_pool(tls_handshake_pool_sptr &pool) noexcept {
+        handshake_pool_ = pool;
+    }
+
+    /*********************************************************************************
+     * Set max handshakes
+     * At most max count handshakes run at the same time, and accepted sockets
+     * beyond it are queued until running handshakes finish. If queued sockets
+     * reach the max queued count, accepting pauses and connections wait in the
+     * listen backlog. This should be called before starting.
+     ********************************************************************************/
+    pump_inline void set_max_handshakes(
+        int32_t max_count,
+        int32_t max_queued_count = 1024) noexcept {
+        max_handshakes_ = max_count;
+        max_queued_handshakes_ = max_queued_count > 0 ? max_queued_count : 1;
+    }
+
   protected:
     /*********************************************************************************
      * Read event callback
@@ -106,13 +141,39 @@ class pump_lib tls_acceptor
      ********************************************************************************/
     virtual void __close_accept_flow() override;
 
+    /*********************************************************************************
+     * Pause accepting if handshake queue is full
+     ********************************************************************************/
+    bool __pause_accepting_if_full();
+
+    /*********************************************************************************
+     * Handshake accepted socket
+     * If running handshakes reach the max count, the socket is queued.
+     ********************************************************************************/
+    void __handshake_accepted(
+        pump_socket fd,
+        const address &local_address,
+        const address &remote_address);
+
+    /*********************************************************************************
+     * Start handshaker
+     * If failed, the handshaker should be removed by caller.
+     ********************************************************************************/
+    bool __start_handshaker(
+        tls_handshaker *handshaker,
+        pump_socket fd,
+        const address &local_address,
+        const address &remote_address);
+
     /*********************************************************************************
      * Create handshaker
+     * This should be called with handshaker locker.
      ********************************************************************************/
     tls_handshaker *__create_handshaker();
 
     /*********************************************************************************
      * Remove handshaker
+     * A queued socket is handshaked after a handshaker removed.
      ********************************************************************************/
     bool __remove_handshaker(tls_handshaker *handshaker);
 
@@ -128,10 +189,30 @@ class pump_lib tls_acceptor
     // Handshake timeout
     uint64_t handshake_timeout_ns_;
 
+    // Memory bio mode
+    bool memory_bio_;
+
+    // Handshake pool
+    tls_handshake_pool_sptr handshake_pool_;
+
+    // Max running and queued handshakes
+    int32_t max_handshakes_;
+    int32_t max_queued_handshakes_;
+
     // Handshakers
     std::mutex handshaker_mx_;
     std::unordered_map<tls_handshaker *, tls_handshaker_sptr> handshakers_;
 
+    // Queued sockets waiting for handshaking
+    struct queued_socket {
+        pump_socket fd;
+        address local_address;
+        address remote_address;
+    };
+    std::deque<queued_socket> queued_sockets_;
+    // Accepting paused flag
+    bool accept_paused_;
+
     // Acceptor flow
     flow::flow_tls_acceptor_sptr flow_;
 };
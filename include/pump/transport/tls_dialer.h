@@ -86,6 +86,35 @@ class pump_lib tls_dialer
      ********************************************************************************/
     virtual void stop() override;
 
+    /*********************************************************************************
+     * Set memory bio
+     * Tls sessions of dialed transports use memory bios instead of socket, so ciphertext
+     * is read in batches and records are gathered to send. This should be called
+     * before starting.
+     ********************************************************************************/
+    pump_inline void set_memory_bio(bool on) noexcept {
+        memory_bio_ = on;
+    }
+
+    /*********************************************************************************
+     * Set session store
+     * Dialer resumes the session stored for the remote address, and stores new
+     * sessions for it. Dialers reconnecting to the same servers should share one
+     * store. This should be called before starting.
+     ********************************************************************************/
+    pump_inline void set_session_store(tls_session_store_sptr &store) noexcept {
+        session_store_ = store;
+    }
+
+    /*********************************************************************************
+     * Set handshake pool
+     * Handshake steps run in the pool instead of the poller. This should be called
+     * before starting.
+     ********************************************************************************/
+    pump_inline void set_handshake_pool(tls_handshake_pool_sptr &pool) noexcept {
+        handshake_pool_ = pool;
+    }
+
   protected:
     /*********************************************************************************
      * Send event callback
@@ -147,6 +176,15 @@ class pump_lib tls_dialer
     uint64_t handshake_timeout_ns_;
     tls_handshaker_sptr handshaker_;
 
+    // Memory bio mode
+    bool memory_bio_;
+
+    // Session store
+    tls_session_store_sptr session_store_;
+
+    // Handshake pool
+    tls_handshake_pool_sptr handshake_pool_;
+
     // Dialer flow
     flow::flow_tls_dialer_sptr flow_;
 };
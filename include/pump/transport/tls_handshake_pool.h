@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef pump_transport_tls_handshake_pool_h
+#define pump_transport_tls_handshake_pool_h
+
+#include <thread>
+#include <vector>
+
+#include <pump/memory.h>
+#include <pump/toolkit/semaphore.h>
+#include <pump/toolkit/freelock_m2m_queue.h>
+
+namespace pump {
+namespace transport {
+
+class tls_handshake_pool;
+DEFINE_SMART_POINTERS(tls_handshake_pool);
+
+/*********************************************************************************
+ * The tls_handshake_pool runs handshake steps of tls handshakers in its own
+ * workers, so private key operations of new tls connections don't block pollers
+ * serving established transports. Pending steps are bounded, and handshakers
+ * run steps on pollers if the pool is full.
+ ********************************************************************************/
+class pump_lib tls_handshake_pool : public toolkit::noncopyable {
+  public:
+    // Task callback
+    typedef pump_function<void()> task_callback;
+
+  public:
+    /*********************************************************************************
+     * Create instance
+     * If worker count is not positive, it will be the hardware concurrency.
+     ********************************************************************************/
+    pump_inline static tls_handshake_pool_sptr create(
+        int32_t worker_count = 0,
+        int32_t max_pending_count = 1024) {
+        pump_object_create_inline(
+            tls_handshake_pool,
+            obj,
+            worker_count,
+            max_pending_count);
+        return tls_handshake_pool_sptr(obj, pump_object_destroy<tls_handshake_pool>);
+    }
+
+    /*********************************************************************************
+     * Deconstructor
+     ********************************************************************************/
+    ~tls_handshake_pool();
+
+    /*********************************************************************************
+     * Start
+     ********************************************************************************/
+    bool start();
+
+    /*********************************************************************************
+     * Stop
+     * Workers exit after running pending tasks.
+     ********************************************************************************/
+    void stop();
+
+    /*********************************************************************************
+     * Post task
+     * It returns false if pool is not started or pending tasks reach the max count.
+     * If pool is stopped while posting, tasks left in queue are run by caller.
+     ********************************************************************************/
+    bool post(task_callback &&task);
+
+    /*********************************************************************************
+     * Get worker count
+     ********************************************************************************/
+    pump_inline int32_t get_worker_count() const noexcept {
+        return worker_count_;
+    }
+
+    /*********************************************************************************
+     * Get pending task count
+     ********************************************************************************/
+    pump_inline int32_t get_pending_count() const noexcept {
+        return pending_count_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    /*********************************************************************************
+     * Constructor
+     ********************************************************************************/
+    tls_handshake_pool(int32_t worker_count, int32_t max_pending_count);
+
+    /*********************************************************************************
+     * Run worker
+     ********************************************************************************/
+    void __run_worker();
+
+  private:
+    // Running status
+    std::atomic_bool running_;
+
+    // Workers
+    int32_t worker_count_;
+    std::vector<std::shared_ptr<std::thread>> workers_;
+
+    // Max pending task count
+    int32_t max_pending_count_;
+    // Pending task count
+    std::atomic_int32_t pending_count_;
+
+    // Pending tasks
+    toolkit::freelock_m2m_queue<task_callback> tasks_;
+    // Pending task count semaphore
+    toolkit::light_semaphore pending_tasks_;
+};
+
+}  // namespace transport
+}  // namespace pump
+
+#endif
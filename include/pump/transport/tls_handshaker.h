@@ -20,6 +20,7 @@
 #include <pump/time/timer.h>
 #include <pump/transport/flow/flow_tls.h>
 #include <pump/transport/base_transport.h>
+#include <pump/transport/tls_handshake_pool.h>
 
 namespace pump {
 namespace transport {
@@ -49,13 +50,32 @@ class tls_handshaker
 
     /*********************************************************************************
      * Init
+     * With memory bio, tls session is decoupled from the socket.
      ********************************************************************************/
     bool init(
         pump_socket fd,
         bool client,
         tls_credentials xcred,
         const address &local_address,
-        const address &remote_address);
+        const address &remote_address,
+        bool memory_bio = false);
+
+    /*********************************************************************************
+     * Resume session
+     * Client handshaker resumes the session stored for the remote address, and new
+     * sessions are stored for the remote address. This should be called before
+     * starting.
+     ********************************************************************************/
+    bool resume_session(tls_session_store_sptr &store);
+
+    /*********************************************************************************
+     * Set handshake pool
+     * Handshake steps run in the pool, and results are handled in the poller of
+     * the handshaker. This should be called before starting.
+     ********************************************************************************/
+    pump_inline void set_handshake_pool(tls_handshake_pool_sptr &pool) noexcept {
+        pool_ = pool;
+    }
 
     /*********************************************************************************
      * Start tls handshaker
@@ -112,6 +132,12 @@ class tls_handshaker
      ********************************************************************************/
     static void on_timeout(tls_handshaker_wptr wptr);
 
+    /*********************************************************************************
+     * Handshake task callback
+     * It runs a handshake step in handshake pool.
+     ********************************************************************************/
+    static void on_handshake_task(tls_handshaker_sptr handshaker);
+
   private:
     /*********************************************************************************
      * Open flow
@@ -119,13 +145,20 @@ class tls_handshaker
     bool __open_flow(
         bool client,
         pump_socket fd,
-        tls_credentials xcred);
+        tls_credentials xcred,
+        bool memory_bio);
 
     /*********************************************************************************
      * Process handshake
+     * If handshake pool is set, the handshake step is posted to the pool.
      ********************************************************************************/
     void __process_handshake();
 
+    /*********************************************************************************
+     * Handle handshake phase
+     ********************************************************************************/
+    void __handle_handshake_phase(tls_handshake_phase phase);
+
     /*********************************************************************************
      * Start handshake timer
      ********************************************************************************/
@@ -159,6 +192,9 @@ class tls_handshaker
     // TLS flow
     flow::flow_tls_sptr flow_;
 
+    // Handshake pool
+    tls_handshake_pool_wptr pool_;
+
     // TLS handshaker callbacks
     tls_handshaker_callbacks cbs_;
 };
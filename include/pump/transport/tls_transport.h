@@ -19,7 +19,6 @@
 
 #include <pump/transport/flow/flow_tls.h>
 #include <pump/transport/base_transport.h>
-#include <pump/toolkit/freelock_m2m_queue.h>
 
 namespace pump {
 namespace transport {
@@ -87,21 +86,19 @@ class pump_lib tls_transport : public base_transport {
      ********************************************************************************/
     virtual error_code send(toolkit::io_buffer *iob) override;
 
-  protected:
     /*********************************************************************************
-     * Channel event callback
+     * Send file region
+     * Data of the region is read to a buffer, because it must be encrypted in
+     * user space.
      ********************************************************************************/
-    virtual void on_channel_event(int32_t ev, void *arg) override;
+    virtual error_code send_file(int32_t fd, int64_t offset, int32_t size) override;
 
     /*********************************************************************************
-     * Read event callback
+     * Check tls session resumed or not
      ********************************************************************************/
-    virtual void on_read_event() override;
-
-    /*********************************************************************************
-     * Send event callback
-     ********************************************************************************/
-    virtual void on_send_event() override;
+    pump_inline bool is_session_resumed() const {
+        return flow_ && flow_->is_session_resumed();
+    }
 
   private:
     /*********************************************************************************
@@ -120,38 +117,48 @@ class pump_lib tls_transport : public base_transport {
     virtual void __close_transport_flow() override;
 
     /*********************************************************************************
-     * Async send
+     * Read from transport flow
+     * Records generated on reading are flushed at once.
      ********************************************************************************/
-    bool __async_send(toolkit::io_buffer *iob);
+    virtual int32_t __read_from_flow(char *b, int32_t size) override;
 
     /*********************************************************************************
-     * Send once
+     * Check transport flow has buffered data to read or not
      ********************************************************************************/
-    error_code __send_once();
+    virtual bool __has_buffered_read_data() override {
+        return flow_->has_unread_data();
+    }
 
     /*********************************************************************************
-     * Handle sent buffer
+     * Send buffers by transport flow
      ********************************************************************************/
-    void __handle_sent_buffer();
+    virtual error_code __send_to_flow(
+        toolkit::io_buffer **iobs,
+        int32_t count,
+        int32_t max_file_size) override {
+        return flow_->want_to_send(iobs, count);
+    }
 
     /*********************************************************************************
-     * Clear send pockets
+     * Continue sending buffers by transport flow
      ********************************************************************************/
-    void __clear_send_pockets();
+    virtual error_code __resend_to_flow() override {
+        return flow_->send();
+    }
+
+    /*********************************************************************************
+     * Flush records generated by tls flow itself
+     ********************************************************************************/
+    virtual error_code __flush_flow() override {
+        return flow_->flush_records();
+    }
 
   private:
     // TLS flow
     flow::flow_tls_sptr flow_;
 
-    // Last send buffer
-    volatile int32_t last_send_iob_size_;
-    toolkit::io_buffer *last_send_iob_;
-
     // Pending send count
     std::atomic_int32_t pending_opt_cnt_;
-
-    // Send buffer list
-    toolkit::freelock_m2m_queue<toolkit::io_buffer *, 8> sendlist_;
 };
 
 }  // namespace transport
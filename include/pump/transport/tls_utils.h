@@ -17,6 +17,12 @@
 #ifndef pump_transport_tls_utils_h
 #define pump_transport_tls_utils_h
 
+#include <deque>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <pump/memory.h>
 #include <pump/net/socket.h>
 #include <pump/transport/types.h>
 
@@ -35,6 +41,109 @@ struct tls_session {
     void *ssl_ctx;
 };
 
+class tls_session_store;
+DEFINE_SMART_POINTERS(tls_session_store);
+
+/*********************************************************************************
+ * TLS session store
+ * Sessions are stored by key in shards locked separately, and the oldest session
+ * of the least recently stored key is evicted if the shard is full. Tls servers
+ * store sessions by session id, and tls clients store sessions by remote address
+ * to resume them on reconnecting. One key keeps several sessions, because tls
+ * 1.3 tickets should be used once and connections to one peer are resumed in
+ * parallel.
+ ********************************************************************************/
+class pump_lib tls_session_store {
+  public:
+    // Shard count
+    constexpr static int32_t shard_count = 16;
+
+  public:
+    /*********************************************************************************
+     * Create instance
+     ********************************************************************************/
+    pump_inline static tls_session_store_sptr create(
+        int32_t max_count = 10240,
+        int32_t max_key_count = 8) {
+        pump_object_create_inline(tls_session_store, obj, max_count, max_key_count);
+        return tls_session_store_sptr(obj, pump_object_destroy<tls_session_store>);
+    }
+
+    /*********************************************************************************
+     * Deconstructor
+     ********************************************************************************/
+    ~tls_session_store();
+
+    /*********************************************************************************
+     * Put session
+     * Store takes the reference of the session. If the key has max sessions, the
+     * oldest session of the key is dropped.
+     ********************************************************************************/
+    void put(const std::string &key, void *session);
+
+    /*********************************************************************************
+     * Get session
+     * It returns a new reference of the newest session of the key, or nullptr if
+     * not found.
+     ********************************************************************************/
+    void *get(const std::string &key);
+
+    /*********************************************************************************
+     * Take session
+     * The newest session of the key is removed from store, and its reference is
+     * returned.
+     ********************************************************************************/
+    void *take(const std::string &key);
+
+    /*********************************************************************************
+     * Remove sessions of the key
+     ********************************************************************************/
+    void remove(const std::string &key);
+
+    /*********************************************************************************
+     * Get session count
+     ********************************************************************************/
+    int32_t size();
+
+  private:
+    /*********************************************************************************
+     * Constructor
+     ********************************************************************************/
+    tls_session_store(int32_t max_count, int32_t max_key_count);
+
+    /*********************************************************************************
+     * Get shard of the key
+     ********************************************************************************/
+    pump_inline int32_t __get_shard(const std::string &key) const {
+        return int32_t(std::hash<std::string>()(key) % shard_count);
+    }
+
+  private:
+    struct session_node {
+        // Sessions in stored order
+        std::deque<void *> sessions;
+        std::list<std::string>::iterator it;
+    };
+    struct shard {
+        shard()
+          : count(0) {
+        }
+        std::mutex mx;
+        // Session nodes by key
+        std::unordered_map<std::string, session_node> nodes;
+        // Keys in stored order
+        std::list<std::string> keys;
+        // Session count
+        int32_t count;
+    };
+    // Max session count of one shard
+    int32_t max_shard_size_;
+    // Max session count of one key
+    int32_t max_key_size_;
+    // Shards
+    shard shards_[shard_count];
+};
+
 /*********************************************************************************
  * New tls client credentials.
  ********************************************************************************/
@@ -57,6 +166,23 @@ tls_credentials load_tls_credentials_from_memory(
  ********************************************************************************/
 void delete_tls_credentials(tls_credentials xcred);
 
+/*********************************************************************************
+ * Set tls session cache
+ * Tls server stores sessions to the sharded cache, then clients resume sessions
+ * by session ids or stateful tickets referring to cached sessions. This should
+ * be called on server credentials before creating tls acceptor.
+ ********************************************************************************/
+bool set_tls_session_cache(tls_credentials xcred, int32_t max_count);
+
+/*********************************************************************************
+ * Set tls session tickets
+ * Tls server issues stateless tickets encrypted by ticket key, which rotates at
+ * the interval. Tickets encrypted by the previous key are still accepted and
+ * renewed. Tickets are preferred to the session cache if both are set. This
+ * should be called on server credentials before creating tls acceptor.
+ ********************************************************************************/
+bool set_tls_session_tickets(tls_credentials xcred, uint64_t rotate_interval_ns);
+
 /*********************************************************************************
  * New tls session
  * This will new ssl context, net read buffer and net send buffer.
@@ -66,6 +192,16 @@ tls_session *new_tls_session(
     pump_socket fd,
     tls_credentials xcred);
 
+/*********************************************************************************
+ * New tls memory session
+ * Ssl context of the session is bound to memory bios instead of socket. Read
+ * ciphertext is fed to the session, and ciphertext to send is taken from the
+ * session, so tls can run over any byte transport.
+ ********************************************************************************/
+tls_session *new_tls_memory_session(
+    bool client,
+    tls_credentials xcred);
+
 /*********************************************************************************
  * Delete tls session
  * This will delete ssl context, net read buffer and net send buffer.
@@ -77,6 +213,22 @@ void delete_tls_session(tls_session *session);
  ********************************************************************************/
 tls_handshake_phase tls_handshake(tls_session *session);
 
+/*********************************************************************************
+ * Resume session
+ * Tls client session resumes the session stored with the key if exists, and new
+ * sessions from server are stored with the key. This should be called before
+ * handshake.
+ ********************************************************************************/
+bool tls_resume_session(
+    tls_session *session,
+    tls_session_store_sptr &store,
+    const std::string &key);
+
+/*********************************************************************************
+ * Check session resumed or not
+ ********************************************************************************/
+bool tls_is_session_resumed(tls_session *session);
+
 /*********************************************************************************
  * Check has unread data or not
  ********************************************************************************/
@@ -100,6 +252,39 @@ int32_t tls_send(
     const char *b,
     int32_t size);
 
+/*********************************************************************************
+ * Shutdown
+ * Send close notify if handshake finished. Peer reading eof without close
+ * notify treats it as a fatal error, which removes the session from cache.
+ ********************************************************************************/
+void tls_shutdown(tls_session *session);
+
+/*********************************************************************************
+ * Feed read data
+ * Feed ciphertext read from transport to tls memory session.
+ * If success return fed size, else return 0.
+ ********************************************************************************/
+int32_t tls_feed_read_data(
+    tls_session *session,
+    const char *b,
+    int32_t size);
+
+/*********************************************************************************
+ * Get send data size
+ * Get size of ciphertext waiting to be taken from tls memory session.
+ ********************************************************************************/
+int32_t tls_get_send_data_size(tls_session *session);
+
+/*********************************************************************************
+ * Take send data
+ * Take ciphertext to send from tls memory session.
+ * If success return taken size, else return 0.
+ ********************************************************************************/
+int32_t tls_take_send_data(
+    tls_session *session,
+    char *b,
+    int32_t size);
+
 }  // namespace transport
 }  // namespace pump
 
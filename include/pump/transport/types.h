@@ -77,6 +77,14 @@ const read_state read_none = 0;
 const read_state read_pending = 1;
 const read_state read_invalid = 2;
 
+/*********************************************************************************
+ * Udp send queue policy when the queue is full
+ ********************************************************************************/
+typedef int32_t udp_send_policy;
+const udp_send_policy udp_send_drop_newest = 0;
+const udp_send_policy udp_send_drop_oldest = 1;
+const udp_send_policy udp_send_block = 2;
+
 /*********************************************************************************
  * Transport error
  ********************************************************************************/
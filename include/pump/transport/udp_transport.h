@@ -17,6 +17,11 @@
 #ifndef pump_transport_udp_transport_h
 #define pump_transport_udp_transport_h
 
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <condition_variable>
+
 #include <pump/transport/flow/flow_udp.h>
 #include <pump/transport/base_transport.h>
 
@@ -26,6 +31,19 @@ namespace transport {
 class udp_transport;
 DEFINE_SMART_POINTERS(udp_transport);
 
+struct udp_send_queue_stats {
+    // Datagrams queued for full socket buffer
+    uint64_t queued;
+    // Queued datagrams sent
+    uint64_t sent;
+    // Datagrams dropped for full queue
+    uint64_t dropped;
+    // Sendings blocked for full queue
+    uint64_t blocked;
+    // Datagrams in queue
+    int32_t pending;
+};
+
 class pump_lib udp_transport : public base_transport {
   public:
     /*********************************************************************************
@@ -39,11 +57,54 @@ class pump_lib udp_transport : public base_transport {
     /*********************************************************************************
      * Deconstructor
      ********************************************************************************/
-    virtual ~udp_transport() = default;
+    virtual ~udp_transport();
+
+    /*********************************************************************************
+     * Set segment offload
+     * Buffer larger than the segment size is sent as datagrams of the segment
+     * size, which are segmented by kernel with UDP_SEGMENT in one system call,
+     * and the last datagram maybe shorter. Datagrams coalesced by UDP_GRO are
+     * split back before read callbacks. If socket doesn't support them, buffer
+     * is segmented in user space and datagrams are read one by one. If socket
+     * buffer becomes full after some segments of a buffer are sent, remaining
+     * segments are sent by send tracker, and sending buffers larger than the
+     * segment size returns error_again until they are sent. It should be set
+     * before starting.
+     ********************************************************************************/
+    pump_inline void set_segment_offload(int32_t segment_size) noexcept {
+        if (segment_size > 0 && segment_size <= max_udp_gso_size) {
+            segment_size_ = segment_size;
+        }
+    }
+
+    /*********************************************************************************
+     * Set send queue
+     * Datagrams are queued instead of failing with error_again when socket buffer
+     * is full, and the queue is drained by send tracker in order. If the queue
+     * reaches the max count, the policy drops the newest or the oldest datagram,
+     * or blocks sending until the queue has space. Remaining segments of data
+     * partially sent are queued even if the queue is full, so such sending never
+     * fails with error_again. Don't send with block policy in callbacks, which
+     * maybe blocks the poller. It should be set before starting.
+     ********************************************************************************/
+    pump_inline void set_send_queue(int32_t max_count, udp_send_policy policy) noexcept {
+        if (max_count > 0 &&
+            policy >= udp_send_drop_newest &&
+            policy <= udp_send_block) {
+            send_queue_max_ = max_count;
+            send_queue_policy_ = policy;
+        }
+    }
+
+    /*********************************************************************************
+     * Get send queue stats
+     ********************************************************************************/
+    udp_send_queue_stats get_send_queue_stats();
 
     /*********************************************************************************
      * Start
-     * max_pending_send_size is ignore on udp transport.
+     * max_pending_send_size is ignore on udp transport. If read from batch
+     * callback is set, datagrams are read in batch by recvmmsg.
      ********************************************************************************/
     virtual error_code start(
         service *sv,
@@ -84,18 +145,105 @@ class pump_lib udp_transport : public base_transport {
         toolkit::io_buffer *iob,
         const address &address) override;
 
+    /*********************************************************************************
+     * Send datagrams to their peer addresses in batch
+     * Datagrams are sent by sendmmsg with fewer system calls. If socket buffer
+     * becomes full, it returns error_again, and sent count tells how many
+     * datagrams are sent. If a datagram fails, it returns error_fault, and sent
+     * count is the index of it. With send queue, datagrams not sent are queued,
+     * and sent count includes them. If a datagram is dropped by drop newest
+     * policy, it returns error_again, and sent count is the index of it.
+     ********************************************************************************/
+    virtual error_code send_batch(
+        const udp_datagram *dgs,
+        int32_t count,
+        int32_t *sent_count = nullptr) override;
+
   protected:
     /*********************************************************************************
      * Read event callback
      ********************************************************************************/
     virtual void on_read_event() override;
 
+    /*********************************************************************************
+     * Send event callback
+     ********************************************************************************/
+    virtual void on_send_event() override;
+
   private:
     /*********************************************************************************
      * Constructor
      ********************************************************************************/
     udp_transport(const address &bind_address) noexcept;
 
+    /*********************************************************************************
+     * Read in batch
+     ********************************************************************************/
+    void __read_batch();
+
+    /*********************************************************************************
+     * Read with gro
+     ********************************************************************************/
+    void __read_gro();
+
+    /*********************************************************************************
+     * Callback read datagrams split from coalesced data
+     ********************************************************************************/
+    void __callback_read_segments(
+        const address &from,
+        const char *b,
+        int32_t size,
+        int32_t segment_size);
+
+    /*********************************************************************************
+     * Send until socket buffer is full
+     * Data larger than the segment size is sent as datagrams of the segment size.
+     * Return sent size.
+     ********************************************************************************/
+    int32_t __send_until_again(
+        const char *b,
+        int32_t size,
+        const address &address);
+
+    /*********************************************************************************
+     * Send segments without send queue
+     * Remaining segments of partially sent data are queued and sent by send
+     * tracker, so data is never sent again partially by retrying.
+     ********************************************************************************/
+    error_code __send_segments(
+        const char *b,
+        int32_t size,
+        const address &address);
+
+    /*********************************************************************************
+     * Send with send queue
+     * Data is sent directly if the queue is empty, and data not sent is queued.
+     * Remaining data of partially sent data is always queued.
+     ********************************************************************************/
+    error_code __queue_send(
+        const char *b,
+        int32_t size,
+        const address &address);
+
+    /*********************************************************************************
+     * Push data to send queue
+     * Send queue locker must be locked.
+     ********************************************************************************/
+    error_code __push_send_queue(
+        std::unique_lock<std::mutex> &lock,
+        const char *b,
+        int32_t size,
+        const address &address);
+
+    /*********************************************************************************
+     * Append data to send queue without limit
+     * Send queue locker must be locked.
+     ********************************************************************************/
+    error_code __append_send_queue(
+        const char *b,
+        int32_t size,
+        const address &address);
+
     /*********************************************************************************
      * Open transport flow
      ********************************************************************************/
@@ -114,6 +262,28 @@ class pump_lib udp_transport : public base_transport {
   private:
     // Udp flow
     flow::flow_udp_sptr flow_;
+
+    // Read buffer of batch or gro reading
+    char *read_buffer_;
+    // Batch read datagrams
+    std::vector<udp_datagram> read_batch_;
+
+    // Segment size
+    int32_t segment_size_;
+    // Segment offload enabled
+    bool gso_;
+    // Receive offload enabled
+    bool gro_;
+
+    // Send queue max datagram count and full policy
+    int32_t send_queue_max_;
+    udp_send_policy send_queue_policy_;
+    // Send queue of datagrams waiting for socket buffer
+    std::mutex send_queue_mx_;
+    std::condition_variable send_queue_cond_;
+    std::deque<std::pair<toolkit::io_buffer *, address>> send_queue_;
+    // Send queue stats
+    udp_send_queue_stats send_queue_stats_;
 };
 
 }  // namespace transport
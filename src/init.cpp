@@ -37,7 +37,7 @@ namespace pump {
 #if defined(OS_LINUX)
 typedef void (*sighandler_t)(int32_t);
 static bool setup_signal(int32_t sig, sighandler_t handler) {
-    if (signal(sig, NULL) != 0) {
+    if (signal(sig, handler) == SIG_ERR) {
         pump_debug_log("setup signal %d failed", sig);
         return false;
     }
@@ -19,6 +19,12 @@
 #include "pump/net/error.h"
 #include "pump/net/socket.h"
 
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <netinet/udp.h>
+#include <linux/errqueue.h>
+#endif
+
 namespace pump {
 namespace net {
 
@@ -168,6 +174,23 @@ bool set_reuse(pump_socket fd, int32_t reuse) {
     return false;
 }
 
+bool set_reuse_port(pump_socket fd, int32_t reuse) {
+#if defined(SO_REUSEPORT)
+    if (setsockopt(
+            fd,
+            SOL_SOCKET,
+            SO_REUSEPORT,
+            (const char*)&reuse,
+            sizeof(reuse)) == 0) {
+        return true;
+    }
+    pump_warn_log("socket set reuse port mode failed %d", last_errno());
+#else
+    pump_warn_log("socket reuse port mode not supported");
+#endif
+    return false;
+}
+
 bool set_nodelay(pump_socket fd, int32_t nodelay) {
     if (setsockopt(
             fd,
@@ -181,6 +204,57 @@ bool set_nodelay(pump_socket fd, int32_t nodelay) {
     return false;
 }
 
+bool set_zerocopy(pump_socket fd, int32_t zerocopy) {
+#if defined(__linux__) && defined(SO_ZEROCOPY)
+    if (setsockopt(
+            fd,
+            SOL_SOCKET,
+            SO_ZEROCOPY,
+            (const char*)&zerocopy,
+            sizeof(zerocopy)) == 0) {
+        return true;
+    }
+    pump_warn_log("socket set zero copy mode failed %d", last_errno());
+#else
+    pump_warn_log("socket zero copy mode not supported");
+#endif
+    return false;
+}
+
+bool set_udp_segment(pump_socket fd, int32_t size) {
+#if defined(__linux__) && defined(UDP_SEGMENT)
+    if (setsockopt(
+            fd,
+            SOL_UDP,
+            UDP_SEGMENT,
+            (const char*)&size,
+            sizeof(size)) == 0) {
+        return true;
+    }
+    pump_warn_log("socket set udp segment failed %d", last_errno());
+#else
+    pump_warn_log("socket udp segment not supported");
+#endif
+    return false;
+}
+
+bool set_udp_gro(pump_socket fd, int32_t gro) {
+#if defined(__linux__) && defined(UDP_GRO)
+    if (setsockopt(
+            fd,
+            SOL_UDP,
+            UDP_GRO,
+            (const char*)&gro,
+            sizeof(gro)) == 0) {
+        return true;
+    }
+    pump_warn_log("socket set udp gro failed %d", last_errno());
+#else
+    pump_warn_log("socket udp gro not supported");
+#endif
+    return false;
+}
+
 bool update_connect_context(pump_socket fd) {
 #if defined(PUMP_HAVE_WINSOCK)
     if (setsockopt(
@@ -243,8 +317,20 @@ pump_socket accept(
     pump_socket fd,
     struct sockaddr *addr,
     int32_t *addrlen) {
+#if defined(OS_LINUX)
+    pump_socket client = ::accept4(
+        fd,
+        addr,
+        (socklen_t *)addrlen,
+        SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
     pump_socket client = ::accept(fd, addr, (socklen_t *)addrlen);
-    if (client < 0) {
+    if (client != invalid_socket && !set_noblock(client, 1)) {
+        close(client);
+        client = invalid_socket;
+    }
+#endif
+    if (client == invalid_socket && last_errno() != LANE_EWOULDBLOCK) {
         pump_warn_log("socket accept failed %d", last_errno());
     }
     return client;
@@ -308,6 +394,106 @@ int32_t read_from(
     return size;
 }
 
+int32_t read_from_gro(
+    pump_socket fd,
+    char *b,
+    int32_t size,
+    struct sockaddr *addr,
+    int32_t *addrlen,
+    int32_t *segment_size) {
+#if defined(__linux__) && defined(UDP_GRO)
+    char control[CMSG_SPACE(sizeof(int32_t))];
+    struct iovec iov;
+    iov.iov_base = b;
+    iov.iov_len = (size_t)size;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = addr;
+    msg.msg_namelen = (socklen_t)*addrlen;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    size = (int32_t)::recvmsg(fd, &msg, 0);
+    if (size < 0) {
+        int32_t ec = net::last_errno();
+        if (ec == LANE_EINPROGRESS || ec == LANE_EWOULDBLOCK) {
+            return -1;
+        }
+        return 0;
+    }
+    *addrlen = (int32_t)msg.msg_namelen;
+    *segment_size = size;
+    for (auto cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO) {
+            memcpy(segment_size, CMSG_DATA(cm), sizeof(int32_t));
+            break;
+        }
+    }
+    return size;
+#else
+    size = read_from(fd, b, size, addr, addrlen);
+    *segment_size = size;
+    return size;
+#endif
+}
+
+int32_t read_from_batch(
+    pump_socket fd,
+    pump_iovec *iovs,
+    struct sockaddr **addrs,
+    int32_t *addrlens,
+    int32_t *sizes,
+    int32_t count) {
+#if defined(__linux__)
+    struct mmsghdr msgs[max_batch_count];
+    if (count > max_batch_count) {
+        count = max_batch_count;
+    }
+    memset(msgs, 0, sizeof(struct mmsghdr) * count);
+    for (int32_t i = 0; i < count; i++) {
+        msgs[i].msg_hdr.msg_name = addrs[i];
+        msgs[i].msg_hdr.msg_namelen = (socklen_t)addrlens[i];
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    count = ::recvmmsg(fd, msgs, count, 0, nullptr);
+    if (count > 0) {
+        for (int32_t i = 0; i < count; i++) {
+            addrlens[i] = (int32_t)msgs[i].msg_hdr.msg_namelen;
+            sizes[i] = (int32_t)msgs[i].msg_len;
+        }
+        return count;
+    }
+    int32_t ec = net::last_errno();
+    if (ec == LANE_EINPROGRESS || ec == LANE_EWOULDBLOCK) {
+        return -1;
+    }
+    return 0;
+#else
+    // Read datagrams one by one until no more.
+    int32_t i = 0;
+    for (; i < count; i++) {
+#if defined(PUMP_HAVE_WINSOCK)
+        auto b = iovs[i].buf;
+        auto size = (int32_t)iovs[i].len;
+#else
+        auto b = (char *)iovs[i].iov_base;
+        auto size = (int32_t)iovs[i].iov_len;
+#endif
+        size = read_from(fd, b, size, addrs[i], &addrlens[i]);
+        if (size <= 0) {
+            if (i == 0) {
+                return size;
+            }
+            break;
+        }
+        sizes[i] = size;
+    }
+    return i;
+#endif
+}
+
 int32_t send(
     pump_socket fd,
     const char *b,
@@ -326,6 +512,121 @@ int32_t send(
     return size;
 }
 
+int32_t send_vector(
+    pump_socket fd,
+    pump_iovec *iovs,
+    int32_t count) {
+#if defined(PUMP_HAVE_WINSOCK)
+    DWORD sent = 0;
+    int32_t size = -1;
+    if (::WSASend(fd, iovs, count, &sent, 0, nullptr, nullptr) == 0) {
+        size = (int32_t)sent;
+    }
+#else
+    auto size = (int32_t)::writev(fd, iovs, count);
+#endif
+    if (pump_likely(size > 0)) {
+        return size;
+    } else if (size < 0) {
+        int32_t ec = net::last_errno();
+        if (ec == LANE_EINPROGRESS || ec == LANE_EWOULDBLOCK) {
+            size = -1;
+        } else {
+            size = 0;
+        }
+    }
+    return size;
+}
+
+int32_t send_zerocopy(
+    pump_socket fd,
+    const char *b,
+    int32_t size) {
+#if defined(__linux__) && defined(MSG_ZEROCOPY)
+    size = ::send(fd, b, size, MSG_ZEROCOPY);
+    if (pump_likely(size > 0)) {
+        return size;
+    } else if (size < 0) {
+        int32_t ec = net::last_errno();
+        if (ec == LANE_EINPROGRESS || ec == LANE_EWOULDBLOCK) {
+            size = -1;
+        } else {
+            size = 0;
+        }
+    }
+    return size;
+#else
+    return send(fd, b, size);
+#endif
+}
+
+int32_t read_zerocopy_completion(
+    pump_socket fd,
+    uint32_t *lo,
+    uint32_t *hi) {
+#if defined(__linux__) && defined(MSG_ZEROCOPY)
+    char control[128];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (::recvmsg(fd, &msg, MSG_ERRQUEUE) < 0) {
+        int32_t ec = net::last_errno();
+        if (ec == LANE_EINPROGRESS || ec == LANE_EWOULDBLOCK) {
+            return -1;
+        }
+        return 0;
+    }
+    for (auto cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+        auto ee = (struct sock_extended_err *)CMSG_DATA(cm);
+        if (ee->ee_errno == 0 && ee->ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+            *lo = ee->ee_info;
+            *hi = ee->ee_data;
+            return 1;
+        }
+    }
+    pump_debug_log("socket error queue message is not zero copy completion");
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int32_t send_file(
+    pump_socket fd,
+    int32_t file_fd,
+    int64_t offset,
+    int32_t size) {
+#if defined(__linux__)
+    off_t off = (off_t)offset;
+    size = (int32_t)::sendfile(fd, file_fd, &off, size);
+#elif !defined(PUMP_HAVE_WINSOCK)
+    char b[16384];
+    if (size > (int32_t)sizeof(b)) {
+        size = (int32_t)sizeof(b);
+    }
+    // Data not sent is read again by next sending.
+    size = (int32_t)::pread(file_fd, b, size, (off_t)offset);
+    if (size > 0) {
+        size = (int32_t)::send(fd, b, size, 0);
+    }
+#else
+    pump_warn_log("socket send file not supported");
+    return 0;
+#endif
+    if (pump_likely(size > 0)) {
+        return size;
+    } else if (size < 0) {
+        int32_t ec = net::last_errno();
+        if (ec == LANE_EINPROGRESS || ec == LANE_EWOULDBLOCK) {
+            size = -1;
+        } else {
+            size = 0;
+        }
+    }
+    return size;
+}
+
 int32_t send_to(
     pump_socket fd,
     const char *b,
@@ -345,6 +646,56 @@ int32_t send_to(
     return size;
 }
 
+int32_t send_to_batch(
+    pump_socket fd,
+    pump_iovec *iovs,
+    struct sockaddr **addrs,
+    int32_t *addrlens,
+    int32_t count) {
+#if defined(__linux__)
+    struct mmsghdr msgs[max_batch_count];
+    if (count > max_batch_count) {
+        count = max_batch_count;
+    }
+    memset(msgs, 0, sizeof(struct mmsghdr) * count);
+    for (int32_t i = 0; i < count; i++) {
+        msgs[i].msg_hdr.msg_name = addrs[i];
+        msgs[i].msg_hdr.msg_namelen = (socklen_t)addrlens[i];
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    count = ::sendmmsg(fd, msgs, count, 0);
+    if (count > 0) {
+        return count;
+    }
+    int32_t ec = net::last_errno();
+    if (ec == LANE_EINPROGRESS || ec == LANE_EWOULDBLOCK) {
+        return -1;
+    }
+    return 0;
+#else
+    // Send datagrams one by one until socket buffer is full.
+    int32_t i = 0;
+    for (; i < count; i++) {
+#if defined(PUMP_HAVE_WINSOCK)
+        auto b = (const char *)iovs[i].buf;
+        auto size = (int32_t)iovs[i].len;
+#else
+        auto b = (const char *)iovs[i].iov_base;
+        auto size = (int32_t)iovs[i].iov_len;
+#endif
+        size = send_to(fd, b, size, addrs[i], addrlens[i]);
+        if (size <= 0) {
+            if (i == 0) {
+                return size;
+            }
+            break;
+        }
+    }
+    return i;
+#endif
+}
+
 void shutdown(pump_socket fd, int32_t how) {
     ::shutdown(fd, how);
 }
@@ -148,6 +148,9 @@ afd_poller::afd_poller() noexcept
     if (events_ == nullptr) {
         pump_abort_with_log("allocate afd events memory failed");
     }
+
+    // Poller can be waked up, so it can wait events without timeout.
+    parked_timeout_ = -1;
 #else
     pump_abort_with_log("unsupport afd poller");
 #endif
@@ -262,6 +265,8 @@ void afd_poller::__poll(int32_t timeout) {
             FALSE) == FALSE) {
         return;
     }
+    // Poller is not parked when dispatching events.
+    parked_.store(false, std::memory_order_relaxed);
 
     if (completion_count > 0) {
         __dispatch_pending_event(completion_count);
@@ -269,13 +274,26 @@ void afd_poller::__poll(int32_t timeout) {
 #endif
 }
 
+void afd_poller::__wakeup() {
+#if defined(PUMP_HAVE_IOCP)
+    // Wakeup completion is posted with null overlapped.
+    if (PostQueuedCompletionStatus(iocp_handler_, 0, 0, nullptr) == FALSE) {
+        pump_debug_log("post wakeup completion failed %d", net::last_errno());
+    }
+#endif
+}
+
 void afd_poller::__dispatch_pending_event(int32_t count) {
 #if defined(PUMP_HAVE_IOCP)
     auto ev_beg = (LPOVERLAPPED_ENTRY)events_;
     auto ev_end = (LPOVERLAPPED_ENTRY)events_ + count;
     for (auto ev = ev_beg; ev != ev_end; ++ev) {
-        // If channel is invalid, tracker should be removed.
+        // Skip wakeup completion.
         auto tracker = (channel_tracker *)ev->lpOverlapped;
+        if (pump_unlikely(tracker == nullptr)) {
+            continue;
+        }
+        // If channel is invalid, tracker should be removed.
         if (tracker->untrack()) {
             auto ch = tracker->get_channel();
             if (ch) {
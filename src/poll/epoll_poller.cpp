@@ -14,10 +14,13 @@
  * limitations under the License.
  */
 
+#include <mutex>
+
 #include "pump/poll/epoll_poller.h"
 
 #if defined(PUMP_HAVE_EPOLL)
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #endif
 
 namespace pump {
@@ -27,11 +30,13 @@ namespace poll {
 // const static uint32_t EL_TRI_TYPE = 0;  // (EPOLLET)
 const static uint32_t epoll_read = (EPOLLONESHOT | EPOLLIN | EPOLLPRI | EPOLLRDHUP);
 const static uint32_t epoll_send = (EPOLLONESHOT | EPOLLOUT);
+const static uint32_t epoll_edge_read = (EPOLLET | EPOLLIN | EPOLLPRI | EPOLLRDHUP);
 const static uint32_t epoll_error = (EPOLLERR | EPOLLHUP);
 #endif
 
 epoll_poller::epoll_poller() noexcept
   : fd_(-1),
+    wakeup_fd_(-1),
     events_(nullptr),
     max_event_count_(1024),
     cur_event_count_(0) {
@@ -44,6 +49,20 @@ epoll_poller::epoll_poller() noexcept
     if (events_ == nullptr) {
         pump_abort_with_log("allocate epoll events memory failed");
     }
+
+    // Wakeup event fd is installed with null data pointer.
+    if ((wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0) {
+        pump_abort_with_log("create wakeup event fd failed %d", net::last_errno());
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(fd_, EPOLL_CTL_ADD, wakeup_fd_, &event) != 0) {
+        pump_abort_with_log("install wakeup event fd failed %d", net::last_errno());
+    }
+
+    // Poller can be waked up, so it can wait events without timeout.
+    parked_timeout_ = -1;
 #else
     pump_abort();
 #endif
@@ -54,6 +73,9 @@ epoll_poller::~epoll_poller() {
     if (fd_ != -1) {
         close(fd_);
     }
+    if (wakeup_fd_ != -1) {
+        close(wakeup_fd_);
+    }
     if (events_ != nullptr) {
         pump_free(events_);
     }
@@ -62,6 +84,19 @@ epoll_poller::~epoll_poller() {
 
 bool epoll_poller::__install_channel_tracker(channel_tracker *tracker) {
 #if defined(PUMP_HAVE_EPOLL)
+    auto host = tracker->get_host();
+    if (host != nullptr && host->get_poller() == this) {
+        // Guest tracker is not registered, it shares the registration of host.
+        std::lock_guard<toolkit::spin_mutex> lock(host->get_locker());
+        host->set_guest(tracker);
+        if (__arm_shared_registration(host)) {
+            return true;
+        }
+        host->set_guest(nullptr);
+        pump_debug_log("install channel tracker failed %d", net::last_errno());
+        return false;
+    }
+
     auto expected_event = tracker->get_expected_event();
     auto event = tracker->get_event();
     event->data.ptr = tracker;
@@ -85,6 +120,16 @@ bool epoll_poller::__install_channel_tracker(channel_tracker *tracker) {
 
 bool epoll_poller::__uninstall_channel_tracker(channel_tracker *tracker) {
 #if defined(PUMP_HAVE_EPOLL)
+    auto host = tracker->get_host();
+    if (host != nullptr && host->get_poller() == this) {
+        // Armed send interest of guest will be ignored when event comes.
+        std::lock_guard<toolkit::spin_mutex> lock(host->get_locker());
+        if (host->get_guest() == tracker) {
+            host->set_guest(nullptr);
+        }
+        return true;
+    }
+
     auto event = tracker->get_event();
     if (epoll_ctl(
             fd_,
@@ -105,11 +150,43 @@ bool epoll_poller::__uninstall_channel_tracker(channel_tracker *tracker) {
 }
 
 bool epoll_poller::__start_channel_tracker(channel_tracker *tracker) {
+#if defined(PUMP_HAVE_EPOLL)
+    auto host = tracker->get_host();
+    if (host == nullptr || host->get_poller() != this) {
+        host = tracker;
+    }
+    if (host->is_shareable()) {
+        std::lock_guard<toolkit::spin_mutex> lock(host->get_locker());
+        if (host->get_guest() != nullptr) {
+            if (__arm_shared_registration(host)) {
+                return true;
+            }
+            pump_debug_log(
+                "start channel tracker failed %d %d",
+                (int32_t)tracker->get_fd(),
+                net::last_errno());
+            return false;
+        }
+        return __start_channel_registration(tracker);
+    }
+    return __start_channel_registration(tracker);
+#else
+    return false;
+#endif
+}
+
+bool epoll_poller::__start_channel_registration(channel_tracker *tracker) {
 #if defined(PUMP_HAVE_EPOLL)
     auto expected_event = tracker->get_expected_event();
     auto event = tracker->get_event();
     event->data.ptr = tracker;
-    if (expected_event & io_read) {
+    if (tracker->get_mode() == tracker_mode_edge && (expected_event & io_read)) {
+        // Edge tracker keeps registered after the first starting.
+        if (event->events == epoll_edge_read) {
+            return true;
+        }
+        event->events = epoll_edge_read;
+    } else if (expected_event & io_read) {
         event->events = epoll_read;
     } else if (expected_event & io_send) {
         event->events = epoll_send;
@@ -145,28 +222,122 @@ void epoll_poller::__poll(int32_t timeout) {
         (struct epoll_event *)events_,
         max_event_count_,
         timeout);
+    // Poller is not parked when dispatching events.
+    parked_.store(false, std::memory_order_relaxed);
     if (count > 0) {
         __dispatch_pending_event(count);
     }
 #endif
 }
 
+void epoll_poller::__wakeup() {
+#if defined(PUMP_HAVE_EPOLL)
+    uint64_t val = 1;
+    if (::write(wakeup_fd_, &val, sizeof(val)) < 0 && errno != EAGAIN) {
+        pump_debug_log("write wakeup event fd failed %d", net::last_errno());
+    }
+#endif
+}
+
 void epoll_poller::__dispatch_pending_event(int32_t count) {
 #if defined(PUMP_HAVE_EPOLL)
     auto ev_beg = (epoll_event *)events_;
     auto ev_end = (epoll_event *)events_ + count;
     for (auto ev = ev_beg; ev != ev_end; ++ev) {
-        // If channel is invalid, tracker should be removed.
+        // Drain wakeup event fd.
         auto tracker = (channel_tracker *)ev->data.ptr;
+        if (pump_unlikely(tracker == nullptr)) {
+            uint64_t val = 0;
+            if (::read(wakeup_fd_, &val, sizeof(val)) < 0 && errno != EAGAIN) {
+                pump_debug_log("read wakeup event fd failed %d", net::last_errno());
+            }
+            continue;
+        }
+        // Oneshot registration is disabled after event coming. Only shareable
+        // registration is locked, as a guest maybe installed at the same time.
+        if (tracker->is_shareable()) {
+            tracker->get_locker().lock();
+            auto guest = tracker->get_guest();
+            if (tracker->get_mode() == tracker_mode_oneshot) {
+                tracker->get_event()->events = 0;
+            }
+            tracker->get_locker().unlock();
+            if (guest != nullptr) {
+                __dispatch_shared_event(tracker, guest, ev->events);
+                continue;
+            }
+        } else if (tracker->get_mode() == tracker_mode_oneshot) {
+            tracker->get_event()->events = 0;
+        }
+        // If channel is invalid, tracker should be removed.
         if (tracker->untrack()) {
             auto ch = tracker->get_channel();
             if (ch) {
                 ch->handle_io_event(tracker->get_expected_event());
             }
+        } else if (tracker->get_mode() == tracker_mode_edge) {
+            __pend_edge_event(tracker);
         }
     }
 #endif
 }
 
+bool epoll_poller::__arm_shared_registration(channel_tracker *host) {
+#if defined(PUMP_HAVE_EPOLL)
+    uint32_t events = 0;
+    if (host->is_tracked() && (host->get_expected_event() & io_read)) {
+        events |= epoll_read;
+    }
+    auto guest = host->get_guest();
+    if (guest != nullptr && guest->is_tracked() && (guest->get_expected_event() & io_send)) {
+        events |= epoll_send;
+    }
+    // Interests are armed already, no need to modify registration.
+    auto event = host->get_event();
+    if ((events & ~event->events) == 0) {
+        return true;
+    }
+    event->events |= events;
+    if (epoll_ctl(
+            fd_,
+            EPOLL_CTL_MOD,
+            host->get_fd(),
+            event) == 0) {
+        return true;
+    }
+    event->events = 0;
+#endif
+    return false;
+}
+
+void epoll_poller::__dispatch_shared_event(
+    channel_tracker *host,
+    channel_tracker *guest,
+    uint32_t events) {
+#if defined(PUMP_HAVE_EPOLL)
+    if ((events & ~EPOLLOUT) != 0 && host->untrack()) {
+        auto ch = host->get_channel();
+        if (ch) {
+            ch->handle_io_event(host->get_expected_event());
+        }
+    }
+    if ((events & (EPOLLOUT | epoll_error)) != 0 && guest->untrack()) {
+        auto ch = guest->get_channel();
+        if (ch) {
+            ch->handle_io_event(guest->get_expected_event());
+        }
+    }
+
+    // Rearm interests which are still tracking but not rearmed by channels.
+    std::lock_guard<toolkit::spin_mutex> lock(host->get_locker());
+    if (!__arm_shared_registration(host)) {
+        pump_debug_log(
+            "rearm shared registration failed %d %d",
+            (int32_t)host->get_fd(),
+            net::last_errno());
+    }
+#endif
+}
+
 }  // namespace poll
 }  // namespace pump
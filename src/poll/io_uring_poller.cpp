@@ -0,0 +1,482 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+
+#include "pump/poll/io_uring_poller.h"
+
+#if defined(PUMP_HAVE_IO_URING)
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+namespace pump {
+namespace poll {
+
+#if defined(PUMP_HAVE_IO_URING)
+const static uint32_t uring_read = (POLLIN | POLLPRI | POLLRDHUP);
+const static uint32_t uring_send = (POLLOUT);
+const static uint32_t uring_entries = 1024;
+
+// Poller which is polling in current thread
+static thread_local io_uring_poller *polling_poller = nullptr;
+
+static int32_t io_uring_setup_syscall(
+    uint32_t entries,
+    struct io_uring_params *params) {
+    return (int32_t)::syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int32_t io_uring_enter_syscall(
+    int32_t fd,
+    uint32_t to_submit,
+    uint32_t min_complete,
+    uint32_t flags,
+    void *arg,
+    size_t arg_size) {
+    return (int32_t)::syscall(
+        __NR_io_uring_enter,
+        fd,
+        to_submit,
+        min_complete,
+        flags,
+        arg,
+        arg_size);
+}
+#endif
+
+io_uring_poller::io_uring_poller() noexcept
+  : fd_(-1),
+    sq_ring_(nullptr),
+    sq_ring_size_(0),
+    sq_head_(nullptr),
+    sq_tail_(nullptr),
+    sq_mask_(nullptr),
+    sq_array_(nullptr),
+    sq_entries_(0),
+    sqes_(nullptr),
+    cq_ring_(nullptr),
+    cq_ring_size_(0),
+    cq_head_(nullptr),
+    cq_tail_(nullptr),
+    cq_mask_(nullptr),
+    cqes_(nullptr) {
+#if defined(PUMP_HAVE_IO_URING)
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if ((fd_ = io_uring_setup_syscall(uring_entries, &params)) < 0) {
+        pump_abort_with_log("create io_uring fd failed %d", net::last_errno());
+    }
+
+    sq_entries_ = params.sq_entries;
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (cq_ring_size_ > sq_ring_size_) {
+            sq_ring_size_ = cq_ring_size_;
+        }
+        cq_ring_size_ = sq_ring_size_;
+    }
+
+    sq_ring_ = ::mmap(
+        nullptr,
+        sq_ring_size_,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        fd_,
+        IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+        pump_abort_with_log("map io_uring submission ring failed %d", net::last_errno());
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cq_ring_ = sq_ring_;
+    } else {
+        cq_ring_ = ::mmap(
+            nullptr,
+            cq_ring_size_,
+            PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE,
+            fd_,
+            IORING_OFF_CQ_RING);
+        if (cq_ring_ == MAP_FAILED) {
+            pump_abort_with_log("map io_uring completion ring failed %d", net::last_errno());
+        }
+    }
+    sqes_ = ::mmap(
+        nullptr,
+        sq_entries_ * sizeof(struct io_uring_sqe),
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        fd_,
+        IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) {
+        pump_abort_with_log("map io_uring submission entries failed %d", net::last_errno());
+    }
+
+    auto sq_ring = (uint8_t *)sq_ring_;
+    sq_head_ = (uint32_t *)(sq_ring + params.sq_off.head);
+    sq_tail_ = (uint32_t *)(sq_ring + params.sq_off.tail);
+    sq_mask_ = (uint32_t *)(sq_ring + params.sq_off.ring_mask);
+    sq_array_ = (uint32_t *)(sq_ring + params.sq_off.array);
+
+    auto cq_ring = (uint8_t *)cq_ring_;
+    cq_head_ = (uint32_t *)(cq_ring + params.cq_off.head);
+    cq_tail_ = (uint32_t *)(cq_ring + params.cq_off.tail);
+    cq_mask_ = (uint32_t *)(cq_ring + params.cq_off.ring_mask);
+    cqes_ = cq_ring + params.cq_off.cqes;
+
+    // Poller can be waked up, so it can wait events without timeout.
+    parked_timeout_ = -1;
+#else
+    pump_abort();
+#endif
+}
+
+io_uring_poller::~io_uring_poller() {
+#if defined(PUMP_HAVE_IO_URING)
+    if (sqes_ != nullptr && sqes_ != MAP_FAILED) {
+        ::munmap(sqes_, sq_entries_ * sizeof(struct io_uring_sqe));
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+        ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr && sq_ring_ != MAP_FAILED) {
+        ::munmap(sq_ring_, sq_ring_size_);
+    }
+    if (fd_ != -1) {
+        close(fd_);
+    }
+#endif
+}
+
+bool io_uring_poller::is_supported() {
+#if defined(PUMP_HAVE_IO_URING)
+    static const bool supported = []() {
+        struct io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        auto fd = io_uring_setup_syscall(2, &params);
+        if (fd < 0) {
+            pump_debug_log("io_uring not supported %d", net::last_errno());
+            return false;
+        }
+        close(fd);
+        // Resource tags feature comes with multishot poll in the same kernel
+        // version, so it is used for checking multishot poll.
+        if ((params.features & IORING_FEAT_RSRC_TAGS) == 0) {
+            pump_debug_log("io_uring multishot poll not supported");
+            return false;
+        }
+        return true;
+    }();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+bool io_uring_poller::__install_channel_tracker(channel_tracker *tracker) {
+#if defined(PUMP_HAVE_IO_URING)
+    std::lock_guard<toolkit::spin_mutex> lock(mx_);
+
+    // Allocate tracker slot.
+    uint32_t index = 0;
+    if (free_slots_.empty()) {
+        index = (uint32_t)slots_.size();
+        slots_.emplace_back();
+    } else {
+        index = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    auto &slot = slots_[index];
+    if (++slot.gen == 0) {
+        slot.gen = 1;
+    }
+    slot.tracker = tracker;
+
+    auto event = tracker->get_event();
+    event->data.u64 = ((uint64_t)index << 32) | slot.gen;
+    event->events = 0;
+    if (!tracker->is_tracked() || __arm_poll_request(tracker)) {
+        return true;
+    }
+
+    slot.tracker = nullptr;
+    free_slots_.push_back(index);
+#endif
+    pump_debug_log("install channel tracker failed %d", net::last_errno());
+    return false;
+}
+
+bool io_uring_poller::__uninstall_channel_tracker(channel_tracker *tracker) {
+#if defined(PUMP_HAVE_IO_URING)
+    std::lock_guard<toolkit::spin_mutex> lock(mx_);
+
+    auto event = tracker->get_event();
+    auto index = (uint32_t)(event->data.u64 >> 32);
+    if (index >= slots_.size() || slots_[index].tracker != tracker) {
+        return true;
+    }
+
+    // Cancel armed poll request, completion entries of the tracker are dropped
+    // after the slot freed, because the slot generation is changed.
+    if (!__queue_sqe(IORING_OP_POLL_REMOVE, -1, 0, 0, event->data.u64, 0)) {
+        pump_debug_log(
+            "uninstall channel tracker failed %d %d",
+            (int32_t)tracker->get_fd(),
+            net::last_errno());
+    }
+    event->events = 0;
+
+    slots_[index].tracker = nullptr;
+    free_slots_.push_back(index);
+#endif
+    return true;
+}
+
+bool io_uring_poller::__start_channel_tracker(channel_tracker *tracker) {
+#if defined(PUMP_HAVE_IO_URING)
+    std::lock_guard<toolkit::spin_mutex> lock(mx_);
+    if (__arm_poll_request(tracker)) {
+        return true;
+    }
+#endif
+    pump_debug_log(
+        "start channel tracker failed %d %d",
+        (int32_t)tracker->get_fd(),
+        net::last_errno());
+    return false;
+}
+
+void io_uring_poller::__poll(int32_t timeout) {
+#if defined(PUMP_HAVE_IO_URING)
+    polling_poller = this;
+
+    // Queued entries are submitted with waiting. Other threads maybe submit
+    // some of them at the same time, kernel only submits queued ones.
+    mx_.lock();
+    auto to_submit = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    mx_.unlock();
+
+    if (to_submit > 0 || timeout != 0) {
+        uint32_t flags = IORING_ENTER_GETEVENTS;
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        void *argp = nullptr;
+        size_t arg_size = 0;
+        if (timeout > 0) {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+            memset(&arg, 0, sizeof(arg));
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            argp = &arg;
+            arg_size = sizeof(arg);
+        }
+        auto ret = io_uring_enter_syscall(
+            fd_,
+            to_submit,
+            timeout != 0 ? 1 : 0,
+            flags,
+            argp,
+            arg_size);
+        // Poller is not parked when dispatching events. Not submitted entries
+        // will be submitted at next polling.
+        parked_.store(false, std::memory_order_relaxed);
+        if (pump_unlikely(ret < 0 && errno != EINTR && errno != ETIME)) {
+            pump_debug_log("enter io_uring failed %d", net::last_errno());
+        }
+    }
+
+    __reap_cqes();
+    if (!ready_trackers_.empty()) {
+        __dispatch_pending_event();
+    }
+#endif
+}
+
+void io_uring_poller::__wakeup() {
+#if defined(PUMP_HAVE_IO_URING)
+    std::lock_guard<toolkit::spin_mutex> lock(mx_);
+    if (!__queue_sqe(IORING_OP_NOP, -1, 0, 0, 0, 0)) {
+        pump_debug_log("submit wakeup entry failed %d", net::last_errno());
+    }
+#endif
+}
+
+bool io_uring_poller::__arm_poll_request(channel_tracker *tracker) {
+#if defined(PUMP_HAVE_IO_URING)
+    auto expected_event = tracker->get_expected_event();
+    auto event = tracker->get_event();
+    uint32_t poll_events = 0;
+    uint32_t len = 0;
+    if (tracker->get_mode() == tracker_mode_edge && (expected_event & io_read)) {
+        // Edge tracker keeps armed after the first starting.
+        if (event->events == uring_read) {
+            return true;
+        }
+        event->events = uring_read;
+        poll_events = uring_read;
+        len = IORING_POLL_ADD_MULTI;
+    } else if (expected_event & io_read) {
+        poll_events = uring_read;
+    } else if (expected_event & io_send) {
+        poll_events = uring_send;
+    }
+    if (__queue_sqe(
+            IORING_OP_POLL_ADD,
+            tracker->get_fd(),
+            poll_events,
+            len,
+            0,
+            event->data.u64)) {
+        return true;
+    }
+    event->events = 0;
+#endif
+    return false;
+}
+
+bool io_uring_poller::__queue_sqe(
+    uint8_t opcode,
+    int32_t fd,
+    uint32_t poll_events,
+    uint32_t len,
+    uint64_t addr,
+    uint64_t user_data) {
+#if defined(PUMP_HAVE_IO_URING)
+    auto tail = *sq_tail_;
+    if (pump_unlikely(tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_)) {
+        // Submission ring is full, submit queued entries at first.
+        if (!__submit_sqes() ||
+            tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            return false;
+        }
+    }
+
+    auto index = tail & *sq_mask_;
+    auto sqe = (struct io_uring_sqe *)sqes_ + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+#if defined(PUMP_HAVE_BIG_ENDIAN)
+    sqe->poll32_events = (poll_events << 16) | (poll_events >> 16);
+#else
+    sqe->poll32_events = poll_events;
+#endif
+    sqe->len = len;
+    sqe->addr = addr;
+    sqe->user_data = user_data;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    if (polling_poller == this) {
+        return true;
+    }
+    return __submit_sqes();
+#else
+    return false;
+#endif
+}
+
+bool io_uring_poller::__submit_sqes() {
+#if defined(PUMP_HAVE_IO_URING)
+    uint32_t to_submit = 0;
+    while ((to_submit = *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE)) > 0) {
+        auto ret = io_uring_enter_syscall(fd_, to_submit, 0, 0, nullptr, 0);
+        if (ret > 0) {
+            continue;
+        } else if (ret == 0) {
+            // Queued entries are submitted by polling thread.
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EBUSY) {
+            // Completion ring is overflowed, queued entries will be submitted
+            // at next polling.
+            return true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void io_uring_poller::__reap_cqes() {
+#if defined(PUMP_HAVE_IO_URING)
+    ready_trackers_.clear();
+
+    auto head = *cq_head_;
+    auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return;
+    }
+
+    mx_.lock();
+    for (; head != tail; ++head) {
+        auto cqe = (struct io_uring_cqe *)cqes_ + (head & *cq_mask_);
+        // Wakeup and cancel entries have no user data.
+        if (cqe->user_data == 0) {
+            continue;
+        }
+        // Entries of uninstalled tracker are dropped.
+        auto index = (uint32_t)(cqe->user_data >> 32);
+        if (index >= slots_.size() ||
+            slots_[index].gen != (uint32_t)cqe->user_data ||
+            slots_[index].tracker == nullptr) {
+            continue;
+        }
+        auto tracker = slots_[index].tracker;
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+            // Poll request is finished, it will be armed at next starting.
+            tracker->get_event()->events = 0;
+        }
+        if (cqe->res == -ECANCELED) {
+            continue;
+        }
+        ready_trackers_.push_back(tracker);
+    }
+    mx_.unlock();
+
+    __atomic_store_n(cq_head_, tail, __ATOMIC_RELEASE);
+#endif
+}
+
+void io_uring_poller::__dispatch_pending_event() {
+#if defined(PUMP_HAVE_IO_URING)
+    for (auto tracker : ready_trackers_) {
+        // If channel is invalid, tracker should be removed.
+        if (tracker->untrack()) {
+            auto ch = tracker->get_channel();
+            if (ch) {
+                ch->handle_io_event(tracker->get_expected_event());
+            }
+        } else if (tracker->get_mode() == tracker_mode_edge) {
+            __pend_edge_event(tracker);
+        }
+    }
+#endif
+}
+
+}  // namespace poll
+}  // namespace pump
@@ -21,6 +21,8 @@ namespace poll {
 
 poller::poller() noexcept
   : started_(false),
+    parked_(false),
+    parked_timeout_(3),
     cev_cnt_(0),
     cevents_(1024),
     tev_cnt_(0),
@@ -40,8 +42,17 @@ bool poller::start() {
                 if (cev_cnt_.load(std::memory_order_acquire) > 0 ||
                     tev_cnt_.load(std::memory_order_acquire) > 0) {
                     __poll(0);
+                    continue;
+                }
+                // Park poller, and then producers will wake it up after pushing
+                // events. Events must be checked again after parked.
+                parked_.store(true);
+                if (!started_.load() || cev_cnt_.load() > 0 || tev_cnt_.load() > 0) {
+                    parked_.store(false);
+                    __poll(0);
                 } else {
-                    __poll(3);
+                    __poll(parked_timeout_);
+                    parked_.store(false);
                 }
             }
         }),
@@ -52,6 +63,7 @@ bool poller::start() {
 
 void poller::stop() {
     started_.store(false);
+    __wakeup_if_parked();
 }
 
 void poller::wait_stopped() {
@@ -74,29 +86,24 @@ bool poller::install_channel_tracker(channel_tracker_sptr &tracker) {
         }
     }
 
-    // Create tracker event
-    auto ev = pump_object_create<tracker_event>(tracker, tracker_append);
-    if (ev == nullptr) {
-        pump_warn_log("new tracker event object failed");
-        return false;
-    }
-
     // Install channel tracker
     tracker->set_poller(this);
     if (!__install_channel_tracker(tracker.get())) {
         pump_debug_log("install tracker failed");
         tracker->set_poller(nullptr);
-        pump_object_destroy(ev);
         return false;
     }
 
     // Queue tracker event
-    if (pump_unlikely(!tevents_.push(ev))) {
+    if (pump_unlikely(!tevents_.emplace(tracker, tracker_append))) {
         pump_abort_with_log("push tracker event to queue failed");
     }
 
     // Add pending trakcer event count
-    tev_cnt_.fetch_add(1, std::memory_order_release);
+    tev_cnt_.fetch_add(1);
+
+    // Wakeup poller
+    __wakeup_if_parked();
 
     return true;
 }
@@ -112,20 +119,16 @@ void poller::uninstall_channel_tracker(channel_tracker_sptr &tracker) {
     // Uninstall channel tracker.
     __uninstall_channel_tracker(tracker.get());
 
-    // Create tracker event
-    auto ev = pump_object_create<tracker_event>(tracker, tracker_remove);
-    if (ev == nullptr) {
-        pump_warn_log("new tracker event object failed");
-        return;
-    }
-
     // Queue tracker event
-    if (pump_unlikely(!tevents_.push(ev))) {
+    if (pump_unlikely(!tevents_.emplace(tracker, tracker_remove))) {
         pump_abort_with_log("push tracker event to queue failed");
     }
 
     // Add pending trakcer event count
-    tev_cnt_.fetch_add(1, std::memory_order_relaxed);
+    tev_cnt_.fetch_add(1);
+
+    // Wakeup poller
+    __wakeup_if_parked();
 }
 
 bool poller::start_channel_tracker(channel_tracker_sptr &tracker) {
@@ -145,58 +148,70 @@ bool poller::push_channel_event(
         return false;
     }
 
-    // Create channel event
-    auto ev = pump_object_create<channel_event>(c, event, arg);
-    if (ev == nullptr) {
-        pump_warn_log("new channel event object failed");
-        return false;
-    }
-
     // Push channel event to queue.
-    if (pump_unlikely(!cevents_.push(ev))) {
+    if (pump_unlikely(!cevents_.emplace(c, event, arg))) {
         pump_abort_with_log("push channel event to queue failed");
     }
 
     // Add pending channel event count
-    cev_cnt_.fetch_add(1, std::memory_order_relaxed);
+    cev_cnt_.fetch_add(1);
+
+    // Wakeup poller
+    __wakeup_if_parked();
 
     return true;
 }
 
 void poller::__handle_channel_events() {
-    channel_event *ev = nullptr;
+    channel_event ev;
     auto cnt = cev_cnt_.exchange(0, std::memory_order_relaxed);
     for (; cnt > 0; cnt--) {
-        if (pump_unlikely(!cevents_.pop(ev))) {
-            pump_abort_with_log("pop channel event from queue failed");
+        // Event maybe not ready yet, because an earlier producer hasn't
+        // finished pushing.
+        while (!cevents_.pop(ev)) {
+            continue;
         }
 
-        auto ch = ev->ch.lock();
+        auto ch = ev.ch.lock();
         if (ch) {
-            ch->handle_channel_event(ev->event, ev->arg);
+            ch->handle_channel_event(ev.event, ev.arg);
         }
-
-        pump_object_destroy(ev);
     }
+    ev.ch.reset();
 }
 
 void poller::__handle_channel_tracker_events() {
-    tracker_event *ev = nullptr;
+    tracker_event ev;
     auto cnt = tev_cnt_.exchange(0, std::memory_order_relaxed);
     for (; cnt > 0; cnt--) {
-        if (pump_unlikely(!tevents_.pop(ev))) {
-            pump_abort_with_log("pop tracker event from queue failed");
+        // Event maybe not ready yet, because an earlier producer hasn't
+        // finished pushing.
+        while (!tevents_.pop(ev)) {
+            continue;
         }
 
-        if (ev->event == tracker_append) {
-            // Apeend to tracker list
-            trackers_[ev->tracker.get()] = std::move(ev->tracker);
-        } else if (ev->event == tracker_remove) {
-            // Delete from tracker list
-            trackers_.erase(ev->tracker.get());
+        if (ev.event == tracker_append) {
+            // Apeend to tracker table
+            trackers_.insert(std::move(ev.tracker));
+        } else if (ev.event == tracker_remove) {
+            // Delete from tracker table
+            trackers_.remove(ev.tracker.get());
         }
+    }
+    ev.tracker.reset();
+}
 
-        pump_object_destroy(ev);
+void poller::__pend_edge_event(channel_tracker *tracker) {
+    // Edge event comes when tracker is not tracking, it should be marked
+    // pending or dispatched if tracker is started at the moment.
+    while (!tracker->mark_pending() && !tracker->is_pending()) {
+        if (tracker->untrack()) {
+            auto ch = tracker->get_channel();
+            if (ch) {
+                ch->handle_io_event(tracker->get_expected_event());
+            }
+            break;
+        }
     }
 }
 
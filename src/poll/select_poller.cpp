@@ -63,17 +63,15 @@ void select_poller::__poll(int32_t timeout) {
     FD_ZERO(&read_fds_);
     FD_ZERO(&write_fds_);
 
-    pump_socket fd = -1;
     pump_socket maxfd = -1;
-    for (auto &item : trackers_) {
-        auto tracker = item.second.get();
+    trackers_.for_each([&](channel_tracker *tracker) {
         if (!tracker->is_tracked()) {
-            continue;
+            return;
         }
 
-        fd = tracker->get_fd();
+        auto fd = tracker->get_fd();
         if (!__is_selectable(fd)) {
-            continue;
+            return;
         }
 
         if (maxfd < fd) {
@@ -86,7 +84,7 @@ void select_poller::__poll(int32_t timeout) {
         } else if (listen_event & io_send) {
             FD_SET(fd, &write_fds_);
         }
-    }
+    });
 
     tv_.tv_sec = timeout / 1000;
     tv_.tv_usec = (timeout % 1000) * 1000;
@@ -111,29 +109,27 @@ void select_poller::__dispatch_pending_event(
     const fd_set *rfds,
     const fd_set *wfds) {
 #if defined(PUMP_HAVE_SELECT)
-    auto beg = trackers_.begin();
-    while (beg != trackers_.end()) {
+    trackers_.for_each([&](channel_tracker *tracker) {
         // If channel is invalid, channel tracker should be removed.
-        auto tracker = beg->second.get();
         auto ch = tracker->get_channel();
         if (pump_unlikely(!ch)) {
-            trackers_.erase(beg++);
-            continue;
+            trackers_.remove(tracker);
+            return;
         }
 
+        // Read and send trackers of one fd maybe in the same poller.
         pump_socket fd = tracker->get_fd();
-        if (FD_ISSET(fd, rfds)) {
+        auto expected_event = tracker->get_expected_event();
+        if ((expected_event & io_read) && FD_ISSET(fd, rfds)) {
             if (tracker->untrack()) {
                 ch->handle_io_event(io_read);
             }
-        } else if (FD_ISSET(fd, wfds)) {
+        } else if ((expected_event & io_send) && FD_ISSET(fd, wfds)) {
             if (tracker->untrack()) {
                 ch->handle_io_event(io_send);
             }
         }
-
-        beg++;
-    }
+    });
 #endif
 }
 
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <utility>
+
+#include "pump/poll/tracker_table.h"
+
+namespace pump {
+namespace poll {
+
+// Trackers whose slot index exceeds the limit are held in overflow list.
+const static size_t max_slot_count = 1 << 24;
+
+tracker_table::tracker_table(int32_t size) noexcept
+  : count_(0),
+    slots_(size > 0 ? size : 1) {}
+
+void tracker_table::insert(channel_tracker_sptr &&tracker) {
+    auto index = __get_index(tracker->get_fd());
+    if (index < max_slot_count) {
+        if (pump_unlikely(index >= slots_.size())) {
+            auto size = slots_.size();
+            while (size <= index) {
+                size <<= 1;
+            }
+            slots_.resize(size < max_slot_count ? size : max_slot_count);
+        }
+        auto &slot = slots_[index];
+        for (int32_t i = 0; i < slot_way_count; i++) {
+            if (!slot.ways[i]) {
+                slot.ways[i] = std::move(tracker);
+                count_++;
+                return;
+            }
+        }
+    }
+
+    overflow_.push_back(std::move(tracker));
+    count_++;
+}
+
+bool tracker_table::remove(channel_tracker *tracker) {
+    auto index = __get_index(tracker->get_fd());
+    if (index < slots_.size()) {
+        auto &slot = slots_[index];
+        for (int32_t i = 0; i < slot_way_count; i++) {
+            if (slot.ways[i].get() == tracker) {
+                slot.ways[i].reset();
+                count_--;
+                return true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < overflow_.size(); i++) {
+        if (overflow_[i].get() == tracker) {
+            std::swap(overflow_[i], overflow_.back());
+            overflow_.pop_back();
+            count_--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+}  // namespace poll
+}  // namespace pump
@@ -83,9 +83,11 @@ bool connection::start_http(service *sv, const http_callbacks &cbs) {
 
     transport_callbacks tcbs;
     connection_wptr wptr = shared_from_this();
-    tcbs.read_cb = pump_bind(&connection::on_read, wptr, _1, _2);
+    tcbs.read_iob_cb = pump_bind(&connection::on_read, wptr, _1);
     tcbs.stopped_cb = pump_bind(&connection::on_stopped, wptr);
     tcbs.disconnected_cb = pump_bind(&connection::on_disconnected, wptr);
+    tcbs.send_paused_cb = pump_bind(&connection::on_send_watermark, wptr, true);
+    tcbs.send_resumed_cb = pump_bind(&connection::on_send_watermark, wptr, false);
     if (transp_->start(sv, read_mode_once, tcbs) != error_none) {
         pump_debug_log("start connection transport failed");
         state_.store(state_error);
@@ -111,6 +113,37 @@ bool connection::send(packet *pk) {
     return true;
 }
 
+bool connection::send_file(packet *pk, int32_t fd, int64_t offset, int32_t size) {
+    if (!transp_ || !transp_->is_started()) {
+        pump_debug_log("connection transport invalid");
+        return false;
+    }
+
+    if (fd < 0 || offset < 0 || size < 0) {
+        pump_debug_log("file region invalid");
+        return false;
+    }
+
+    if (pk->get_body()) {
+        pump_debug_log("http packet with file region has body");
+        return false;
+    }
+
+    std::string data;
+    pk->set_unique_head("Content-Length", size);
+    pk->serialize(data);
+    if (transp_->send(data.data(), (uint32_t)data.size()) != error_none) {
+        pump_debug_log("connection transport send http packet failed");
+        return false;
+    }
+    if (size > 0 && transp_->send_file(fd, offset, size) != error_none) {
+        pump_debug_log("connection transport send file region failed");
+        return false;
+    }
+
+    return true;
+}
+
 bool connection::start_websocket(const websocket_callbacks &cbs) {
     auto st = state_started;
     if (!state_.compare_exchange_strong(st, state_upgraded)) {
@@ -180,31 +213,29 @@ bool connection::send(const char *b, int32_t size, bool text) {
 
 void connection::on_read(
     connection_wptr conn,
-    const char *b,
-    int32_t size) {
+    toolkit::io_buffer *iob) {
     auto conn_locker = conn.lock();
     if (conn_locker) {
         int32_t parse_size = -1;
         do {
-            if (conn_locker->cache_ == nullptr) {
-                conn_locker->cache_ = toolkit::io_buffer::create();
-                if (conn_locker->cache_ == nullptr) {
-                    pump_warn_log("create cache failed");
-                    break;
-                }
-            }
-
-            bool cached = false;
-            if (conn_locker->cache_->size() > 0) {
-                cached = true;
-                if (!conn_locker->cache_->write(b, size)) {
+            // If there is no cached data, parse the read buffer directly, else
+            // append read data to the cache.
+            auto &cache = conn_locker->cache_;
+            if (cache != nullptr && cache->size() > 0) {
+                if (!cache->write(iob->data(), iob->size())) {
                     pump_debug_log("write data to cache failed");
                     break;
                 }
-                b = conn_locker->cache_->data();
-                size = conn_locker->cache_->size();
+            } else {
+                if (cache != nullptr) {
+                    cache->unrefer();
+                }
+                cache = iob;
+                cache->refer();
             }
 
+            auto b = cache->data();
+            auto size = (int32_t)cache->size();
             switch (conn_locker->state_.load()) {
             case state_started:
                 parse_size = conn_locker->__handle_http_packet(b, size);
@@ -221,11 +252,8 @@ void connection::on_read(
                 break;
             }
 
-            if (cached) {
-                conn_locker->cache_->shift(parse_size);
-            } else if (parse_size < size) {
-                conn_locker->cache_->write(b + parse_size, size - parse_size);
-            }
+            // Left data is kept in the cache.
+            cache->shift(parse_size);
         } while (false);
 
         if (parse_size == -1) {
@@ -296,6 +324,26 @@ void connection::on_stopped(connection_wptr conn) {
     }
 }
 
+void connection::on_send_watermark(connection_wptr conn, bool paused) {
+    auto conn_locker = conn.lock();
+    if (conn_locker) {
+        int32_t st = conn_locker->state_.load();
+        if (st == state_started) {
+            auto &cb = paused ? conn_locker->http_cbs_.send_paused_cb
+                              : conn_locker->http_cbs_.send_resumed_cb;
+            if (cb) {
+                cb();
+            }
+        } else if (st == state_upgraded) {
+            auto &cb = paused ? conn_locker->ws_cbs_.send_paused_cb
+                              : conn_locker->ws_cbs_.send_resumed_cb;
+            if (cb) {
+                cb();
+            }
+        }
+    }
+}
+
 bool connection::__async_read_http_packet() {
     if (state_ != state_started) {
         pump_debug_log("http connection in wrong state");
@@ -26,9 +26,11 @@ using transport::acceptor_callbacks;
 using transport::error_none;
 using transport::tcp_acceptor;
 using transport::tls_acceptor;
+using transport::sharded_acceptor;
 
 server::server() noexcept
-  : sv_(nullptr) {
+  : sv_(nullptr),
+    sharded_(false) {
 }
 
 bool server::start(
@@ -46,7 +48,7 @@ bool server::start(
         return false;
     }
 
-    if (acceptor_) {
+    if (acceptor_ || sharded_acceptor_) {
         pump_debug_log("server's acceptor alread exists");
         return false;
     }
@@ -59,6 +61,17 @@ bool server::start(
     acbs.stopped_cb = pump_bind(&server::on_stopped, svr);
     acbs.accepted_cb = pump_bind(&server::on_accepted, svr, _1);
 
+    if (sharded_) {
+        auto acceptor = sharded_acceptor::create(
+            pump_bind(&tcp_acceptor::create, listen_address));
+        if (acceptor->start(sv, acbs) != error_none) {
+            pump_debug_log("start sharded tcp acceptor failed");
+            return false;
+        }
+        sharded_acceptor_ = acceptor;
+        return true;
+    }
+
     auto acceptor = tcp_acceptor::create(listen_address);
     if (acceptor->start(sv, acbs) != error_none) {
         pump_debug_log("start tcp acceptor failed");
@@ -84,7 +97,7 @@ bool server::start(
         return false;
     }
 
-    if (!acceptor_) {
+    if (acceptor_ || sharded_acceptor_) {
         pump_debug_log("server's acceptor already exists");
         return false;
     }
@@ -97,6 +110,17 @@ bool server::start(
     acbs.stopped_cb = pump_bind(&server::on_stopped, wptr);
     acbs.accepted_cb = pump_bind(&server::on_accepted, wptr, _1);
 
+    if (sharded_) {
+        auto acceptor = sharded_acceptor::create(
+            pump_bind(&tls_acceptor::create, xcred, listen_address, 1000));
+        if (acceptor->start(sv, acbs) != error_none) {
+            pump_debug_log("start sharded tls acceptor failed");
+            return false;
+        }
+        sharded_acceptor_ = acceptor;
+        return true;
+    }
+
     auto acceptor = tls_acceptor::create(xcred, listen_address, 1000);
     if (acceptor->start(sv, acbs) != error_none) {
         pump_debug_log("start tls acceptor failed");
@@ -111,6 +135,9 @@ void server::stop() {
     if (acceptor_) {
         acceptor_->stop();
     }
+    if (sharded_acceptor_) {
+        sharded_acceptor_->stop();
+    }
 }
 
 void server::on_accepted(
@@ -131,6 +158,11 @@ void server::on_accepted(
             pump_debug_log("start http connection failed");
             std::unique_lock<std::mutex> lock(svr_locker->conn_mx_);
             svr_locker->conns_.erase(conn.get());
+        } else if (!conn->__async_read_http_packet()) {
+            pump_debug_log("read first http request failed");
+            conn->stop();
+            std::unique_lock<std::mutex> lock(svr_locker->conn_mx_);
+            svr_locker->conns_.erase(conn.get());
         }
     }
 }
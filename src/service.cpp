@@ -17,35 +17,74 @@
 #include "pump/service.h"
 #include "pump/poll/afd_poller.h"
 #include "pump/poll/epoll_poller.h"
+#include "pump/poll/io_uring_poller.h"
 #include "pump/poll/select_poller.h"
 
 namespace pump {
 
-service::service(bool enable_poll)
-  : running_(false) {
-    memset(pollers_, 0, sizeof(pollers_));
+/*********************************************************************************
+ * Current task worker
+ ********************************************************************************/
+struct task_worker_info {
+    service *sv;
+    int32_t id;
+};
+static thread_local task_worker_info current_task_worker = {nullptr, -1};
+
+service::service(
+    bool enable_poll,
+    int32_t shard_count,
+    int32_t task_worker_count)
+  : running_(false),
+    shard_count_(0),
+    next_shard_(0),
+    task_worker_count_(task_worker_count > 0 ? task_worker_count : 1),
+    posted_tasks_(1024) {
     if (enable_poll) {
+        if (shard_count <= 0) {
+            shard_count = (int32_t)std::thread::hardware_concurrency();
+            if (shard_count <= 0) {
+                shard_count = 1;
+            }
+        }
+        for (int32_t i = 0; i < shard_count * 2; i++) {
 #if defined(PUMP_HAVE_IOCP)
-        pollers_[read_pid] = pump_object_create<poll::afd_poller>();
-        pollers_[send_pid] = pump_object_create<poll::afd_poller>();
+            pollers_.push_back(pump_object_create<poll::afd_poller>());
 #elif defined(PUMP_HAVE_SELECT)
-        pollers_[read_pid] = pump_object_create<poll::select_poller>();
-        pollers_[send_pid] = pump_object_create<poll::select_poller>();
+            pollers_.push_back(pump_object_create<poll::select_poller>());
+#elif defined(PUMP_HAVE_IO_URING)
+            // Fall back to epoll if kernel doesn't support io_uring.
+            if (poll::io_uring_poller::is_supported()) {
+                pollers_.push_back(pump_object_create<poll::io_uring_poller>());
+            } else {
+                pollers_.push_back(pump_object_create<poll::epoll_poller>());
+            }
 #elif defined(PUMP_HAVE_EPOLL)
-        pollers_[read_pid] = pump_object_create<poll::epoll_poller>();
-        pollers_[send_pid] = pump_object_create<poll::epoll_poller>();
+            pollers_.push_back(pump_object_create<poll::epoll_poller>());
 #endif
+        }
+        shard_count_ = shard_count;
+    }
+
+    for (int32_t i = 0; i < task_worker_count_; i++) {
+        worker_tasks_.push_back(pump_object_create<task_deque>(1024));
     }
 
     timers_ = time::engine::create();
 }
 
 service::~service() {
-    if (pollers_[read_pid]) {
-        delete pollers_[read_pid];
+    for (auto pr : pollers_) {
+        if (pr != nullptr) {
+            delete pr;
+        }
     }
-    if (pollers_[send_pid]) {
-        delete pollers_[send_pid];
+    for (auto tasks : worker_tasks_) {
+        task_callback *task = nullptr;
+        while (tasks->pop(task)) {
+            pump_object_destroy(task);
+        }
+        pump_object_destroy(tasks);
     }
 }
 
@@ -60,14 +99,13 @@ bool service::start() {
     if (timers_) {
         timers_->start(pump_bind(&service::__post_triggered_timers, this, _1));
     }
-    if (pollers_[read_pid]) {
-        pollers_[read_pid]->start();
-    }
-    if (pollers_[send_pid]) {
-        pollers_[send_pid]->start();
+    for (auto pr : pollers_) {
+        if (pr != nullptr) {
+            pr->start();
+        }
     }
 
-    __start_task_worker();
+    __start_task_workers();
 
     __start_timer_callback_worker();
 
@@ -80,27 +118,26 @@ void service::stop() {
     if (timers_) {
         timers_->stop();
     }
-    if (pollers_[read_pid]) {
-        pollers_[read_pid]->stop();
-    }
-    if (pollers_[send_pid]) {
-        pollers_[send_pid]->stop();
+    for (auto pr : pollers_) {
+        if (pr != nullptr) {
+            pr->stop();
+        }
     }
 }
 
 void service::wait_stopped() {
-    if (pollers_[read_pid]) {
-        pollers_[read_pid]->wait_stopped();
-    }
-    if (pollers_[send_pid]) {
-        pollers_[send_pid]->wait_stopped();
+    for (auto pr : pollers_) {
+        if (pr != nullptr) {
+            pr->wait_stopped();
+        }
     }
     if (timers_) {
         timers_->wait_stopped();
     }
-    if (task_worker_) {
-        task_worker_->join();
+    for (auto &worker : task_workers_) {
+        worker->join();
     }
+    task_workers_.clear();
     if (timer_worker_) {
         timer_worker_->join();
     }
@@ -110,18 +147,68 @@ void service::__post_triggered_timers(time::timer_list_sptr &tl) {
     triggered_timers_.enqueue(tl);
 }
 
-void service::__start_task_worker() {
-    auto func = [&]() {
-        task_callback task;
-        while (running_) {
-            if (posted_tasks_.dequeue(task, 1000000000)) {
+void service::__post_task(task_callback &&task) {
+    // With only one task worker, tasks are always pushed to the shared queue to
+    // keep them in order.
+    auto &worker = current_task_worker;
+    if (task_worker_count_ > 1 && worker.sv == this) {
+        auto ptask = pump_object_create<task_callback>(std::move(task));
+        if (pump_unlikely(ptask == nullptr)) {
+            pump_abort_with_log("new task object failed");
+        }
+        worker_tasks_[worker.id]->push(ptask);
+    } else if (pump_unlikely(!posted_tasks_.push(std::move(task)))) {
+        pump_abort_with_log("push task to queue failed");
+    }
+    pending_tasks_.signal();
+}
+
+void service::__start_task_workers() {
+    for (int32_t i = 0; i < task_worker_count_; i++) {
+        task_workers_.push_back(std::shared_ptr<std::thread>(
+            pump_object_create<std::thread>(
+                pump_bind(&service::__run_task_worker, this, i)),
+            pump_object_destroy<std::thread>));
+    }
+}
+
+void service::__run_task_worker(int32_t id) {
+    current_task_worker.sv = this;
+    current_task_worker.id = id;
+
+    task_callback task;
+    task_callback *ptask = nullptr;
+    auto tasks = worker_tasks_[id];
+    while (running_) {
+        // Every pending count means a task is posted, so there must be a task
+        // for the worker after waiting pending count successfully.
+        if (!pending_tasks_.wait(1000000000)) {
+            continue;
+        }
+        while (true) {
+            if (tasks->pop(ptask) || __steal_task(id, ptask)) {
+                (*ptask)();
+                pump_object_destroy(ptask);
+                break;
+            }
+            if (posted_tasks_.pop(task)) {
                 task();
+                break;
             }
         }
-    };
-    task_worker_.reset(
-        pump_object_create<std::thread>(func),
-        pump_object_destroy<std::thread>);
+    }
+
+    current_task_worker.sv = nullptr;
+    current_task_worker.id = -1;
+}
+
+bool service::__steal_task(int32_t id, task_callback *&task) {
+    for (int32_t i = 1; i < task_worker_count_; i++) {
+        if (worker_tasks_[(id + i) % task_worker_count_]->steal(task)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void service::__start_timer_callback_worker() {
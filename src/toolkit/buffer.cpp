@@ -4,18 +4,26 @@
 #include "pump/memory.h"
 #include "pump/toolkit/buffer.h"
 
+// Import close function
+#if defined(OS_WINDOWS)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace pump {
 namespace toolkit {
 
-base_buffer::base_buffer(bool alloced) noexcept
+base_buffer::base_buffer(bool alloced, bool pooled) noexcept
   : alloced_(alloced),
+    pooled_(alloced && pooled),
     raw_(nullptr),
     raw_size_(0) {
 }
 
 base_buffer::~base_buffer() {
     if (alloced_ && raw_ != nullptr) {
-        pump_free(raw_);
+        __free_raw(raw_, raw_size_);
     }
 }
 
@@ -26,16 +34,10 @@ bool base_buffer::__init_by_alloc(uint32_t size) noexcept {
         pump_abort();
     }
 
-    try {
-        if ((raw_ = (char *)pump_malloc(size)) == nullptr) {
-            return true;
-        }
-    } catch (const std::exception &) {
+    if ((raw_ = __alloc_raw(size, &raw_size_)) == nullptr) {
         return false;
     }
 
-    raw_size_ = size;
-
     return true;
 }
 
@@ -46,16 +48,11 @@ bool base_buffer::__init_by_copy(const char *b, uint32_t size) noexcept {
         pump_abort();
     }
 
-    try {
-        if ((raw_ = (char *)pump_malloc(size)) == nullptr) {
-            return false;
-        }
-    } catch (const std::exception &) {
+    if ((raw_ = __alloc_raw(size, &raw_size_)) == nullptr) {
         return false;
     }
 
     memcpy(raw_, b, size);
-    raw_size_ = size;
 
     return true;
 }
@@ -74,57 +71,119 @@ bool base_buffer::__init_by_reference(const char *b, uint32_t size) noexcept {
     return true;
 }
 
-io_buffer::io_buffer(bool free) noexcept
-  : base_buffer(free),
+char *base_buffer::__alloc_raw(uint32_t size, uint32_t *capacity) noexcept {
+    if (pooled_) {
+        return (char *)slab_pool::alloc(size, capacity);
+    }
+
+    char *raw = nullptr;
+    try {
+        raw = (char *)pump_malloc(size);
+    } catch (const std::exception &) {
+        return nullptr;
+    }
+    if (raw != nullptr) {
+        *capacity = size;
+    }
+    return raw;
+}
+
+void base_buffer::__free_raw(char *raw, uint32_t capacity) noexcept {
+    if (pooled_) {
+        slab_pool::dealloc(raw, capacity);
+    } else {
+        pump_free(raw);
+    }
+}
+
+io_buffer::io_buffer(bool alloced, bool pooled) noexcept
+  : base_buffer(alloced, pooled),
     size_(0),
     rpos_(0),
-    count_(1) {
+    count_(1),
+    file_fd_(-1),
+    file_offset_(0) {
 }
 
-bool io_buffer::write(const char *b, uint32_t size) {
-    if (!alloced_) {
-        pump_abort();
+io_buffer::~io_buffer() {
+    if (file_fd_ >= 0) {
+#if defined(OS_WINDOWS)
+        ::_close(file_fd_);
+#else
+        ::close(file_fd_);
+#endif
     }
+}
 
-    if (b == nullptr || size == 0) {
-        return false;
+io_buffer *io_buffer::__create(bool alloced) noexcept {
+    void *obj = nullptr;
+    bool pooled = alloced && slab_pool::is_enabled();
+    if (pooled) {
+        obj = slab_pool::alloc(sizeof(io_buffer));
+    } else {
+        obj = pump_malloc(sizeof(io_buffer));
     }
+    if (pump_unlikely(obj == nullptr)) {
+        return nullptr;
+    }
+    return new (obj) io_buffer(alloced, pooled);
+}
 
-    if (raw_ == nullptr) {
-        if (!__init_by_alloc(size)) {
-            return false;
-        }
+void io_buffer::__destroy() noexcept {
+    bool pooled = pooled_;
+    this->~io_buffer();
+    if (pooled) {
+        slab_pool::dealloc(this, slab_pool::get_block_capacity(sizeof(io_buffer)));
+    } else {
+        pump_free(this);
     }
+}
 
-    if (rpos_ == raw_size_) {
-        clear();
+bool io_buffer::__expand(uint32_t size) noexcept {
+    if (pooled_) {
+        uint32_t capacity = 0;
+        auto new_raw = __alloc_raw(size, &capacity);
+        if (new_raw == nullptr) {
+            return false;
+        }
+        memcpy(new_raw, raw_ + rpos_, size_);
+        __free_raw(raw_, raw_size_);
+        raw_ = new_raw;
+        raw_size_ = capacity;
+        rpos_ = 0;
+        return true;
     }
 
-    if (size > raw_size_ - rpos_ - size_) {
-        if (size + size_ < raw_size_) {
-            memmove(raw_, raw_ + rpos_, size_);
+    char *new_raw = nullptr;
+    try {
+        new_raw = (char *)pump_realloc(raw_, size);
+    } catch (const std::exception &) {
+        if ((new_raw = (char *)pump_malloc(size)) != nullptr) {
+            memcpy(new_raw, raw_ + rpos_, size_);
+            pump_free(raw_);
             rpos_ = 0;
-        } else {
-            char *new_raw = nullptr;
-            auto new_size = (raw_size_ + size) / 2 * 3;
-            try {
-                new_raw = (char *)pump_realloc(raw_, new_size);
-            } catch (const std::exception &) {
-                if ((new_raw = (char *)pump_malloc(new_size)) != nullptr) {
-                    memcpy(new_raw, raw_ + rpos_, size_);
-                    pump_free(raw_);
-                    rpos_ = 0;
-                }
-            }
-            if (new_raw == nullptr) {
-                return false;
-            }
-            raw_ = new_raw;
-            raw_size_ = new_size;
         }
     }
+    if (new_raw == nullptr) {
+        return false;
+    }
+    raw_ = new_raw;
+    raw_size_ = size;
+
+    return true;
+}
+
+bool io_buffer::write(const char *b, uint32_t size) {
+    if (b == nullptr || size == 0) {
+        return false;
+    }
+
+    auto space = prepare_write(size);
+    if (space == nullptr) {
+        return false;
+    }
 
-    memcpy(raw_ + rpos_ + size_, b, size);
+    memcpy(space, b, size);
 
     size_ += size;
 
@@ -153,23 +212,8 @@ bool io_buffer::write(char b, uint32_t count) {
             if (count + size_ < raw_size_) {
                 memmove(raw_, raw_ + rpos_, size_);
                 rpos_ = 0;
-            } else {
-                char *new_raw = nullptr;
-                auto new_size = (raw_size_ + count) / 2 * 3;
-                try {
-                    new_raw = (char *)pump_realloc(raw_, new_size);
-                } catch (const std::exception &) {
-                    if ((new_raw = (char *)pump_malloc(new_size)) != nullptr) {
-                        memcpy(new_raw, raw_ + rpos_, size_);
-                        pump_free(raw_);
-                        rpos_ = 0;
-                    }
-                }
-                if (new_raw == nullptr) {
-                    return false;
-                }
-                raw_ = new_raw;
-                raw_size_ = new_size;
+            } else if (!__expand((raw_size_ + count) / 2 * 3)) {
+                return false;
             }
         }
     }
@@ -181,6 +225,45 @@ bool io_buffer::write(char b, uint32_t count) {
     return true;
 }
 
+char *io_buffer::prepare_write(uint32_t size) {
+    if (!alloced_) {
+        pump_abort();
+    }
+
+    if (size == 0) {
+        return nullptr;
+    }
+
+    if (raw_ == nullptr) {
+        if (!__init_by_alloc(size)) {
+            return nullptr;
+        }
+    }
+
+    if (rpos_ == raw_size_) {
+        clear();
+    }
+
+    if (size > raw_size_ - rpos_ - size_) {
+        if (size + size_ < raw_size_) {
+            memmove(raw_, raw_ + rpos_, size_);
+            rpos_ = 0;
+        } else if (!__expand((raw_size_ + size) / 2 * 3)) {
+            return nullptr;
+        }
+    }
+
+    return raw_ + rpos_ + size_;
+}
+
+bool io_buffer::commit_write(uint32_t size) {
+    if (raw_ == nullptr || size > raw_size_ - rpos_ - size_) {
+        return false;
+    }
+    size_ += size;
+    return true;
+}
+
 bool io_buffer::read(char *b, uint32_t size) {
     if (size_ < size) {
         return false;
@@ -260,7 +343,7 @@ void io_buffer::refer() noexcept {
 void io_buffer::unrefer() {
     auto c = count_.fetch_sub(1);
     if (c == 1) {
-        pump_object_destroy_inline(this, io_buffer);
+        __destroy();
     } else if (c <= 0) {
         pump_abort();
     }
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mutex>
+#include <vector>
+
+#include "pump/toolkit/slab_pool.h"
+#include "pump/toolkit/spin_mutex.h"
+
+namespace pump {
+namespace toolkit {
+
+// Size class count from min block size to max block size
+const static int32_t size_class_count = 11;
+// Max cached block count of one magazine
+const static int32_t magazine_capacity = 64;
+// Min cached block count of one magazine
+const static int32_t min_magazine_capacity = 4;
+// Slab size, also the max cached bytes of one magazine
+const static uint32_t slab_size = 256 * 1024;
+
+// Magazine states of thread
+const static int32_t magazines_none = 0;
+const static int32_t magazines_alive = 1;
+const static int32_t magazines_dead = 2;
+
+// Pool enabled status
+static std::atomic_bool pool_enabled(true);
+
+struct depot {
+    spin_mutex mx;
+    std::vector<void *> blocks;
+};
+
+struct magazine {
+    int32_t count;
+    void *blocks[magazine_capacity];
+};
+
+// Magazines are plain data, so they can still be touched after the magazines
+// guard destroyed at thread exiting.
+static thread_local magazine magazines[size_class_count];
+static thread_local int32_t magazines_state = magazines_none;
+
+static pump_inline depot *__get_depots() {
+    // Depots are never destroyed, blocks maybe freed at process exiting.
+    static depot *depots = new depot[size_class_count];
+    return depots;
+}
+
+static pump_inline int32_t __get_class_index(uint32_t size) {
+    int32_t index = 0;
+    uint32_t capacity = slab_pool::min_block_size;
+    while (capacity < size) {
+        capacity <<= 1;
+        index++;
+    }
+    return index;
+}
+
+static pump_inline uint32_t __get_class_capacity(int32_t index) {
+    return slab_pool::min_block_size << index;
+}
+
+static pump_inline int32_t __get_magazine_capacity(int32_t index) {
+    auto count = int32_t(slab_size / __get_class_capacity(index));
+    if (count > magazine_capacity) {
+        return magazine_capacity;
+    } else if (count < min_magazine_capacity) {
+        return min_magazine_capacity;
+    }
+    return count;
+}
+
+class magazines_guard {
+  public:
+    magazines_guard() noexcept {
+        magazines_state = magazines_alive;
+    }
+
+    ~magazines_guard() {
+        magazines_state = magazines_dead;
+        auto depots = __get_depots();
+        for (int32_t i = 0; i < size_class_count; i++) {
+            auto &mag = magazines[i];
+            if (mag.count > 0) {
+                std::lock_guard<spin_mutex> lock(depots[i].mx);
+                depots[i].blocks.insert(
+                    depots[i].blocks.end(),
+                    mag.blocks,
+                    mag.blocks + mag.count);
+                mag.count = 0;
+            }
+        }
+    }
+};
+
+static pump_inline bool __check_magazines() {
+    if (pump_unlikely(magazines_state == magazines_none)) {
+        static thread_local magazines_guard guard;
+        (void)guard;
+    }
+    return magazines_state == magazines_alive;
+}
+
+static bool __carve_slab(int32_t index, depot &dp) {
+    auto capacity = __get_class_capacity(index);
+    auto slab = (char *)pump_malloc(slab_size);
+    if (slab == nullptr) {
+        return false;
+    }
+    for (uint32_t off = 0; off + capacity <= slab_size; off += capacity) {
+        dp.blocks.push_back(slab + off);
+    }
+    return true;
+}
+
+static void *__alloc_from_depot(int32_t index) {
+    auto &dp = __get_depots()[index];
+    std::lock_guard<spin_mutex> lock(dp.mx);
+    if (dp.blocks.empty() && !__carve_slab(index, dp)) {
+        return nullptr;
+    }
+    auto block = dp.blocks.back();
+    dp.blocks.pop_back();
+    return block;
+}
+
+static bool __refill_magazine(int32_t index, magazine &mag) {
+    auto &dp = __get_depots()[index];
+    std::lock_guard<spin_mutex> lock(dp.mx);
+    if (dp.blocks.empty() && !__carve_slab(index, dp)) {
+        return false;
+    }
+    auto count = __get_magazine_capacity(index) / 2;
+    while (mag.count < count && !dp.blocks.empty()) {
+        mag.blocks[mag.count++] = dp.blocks.back();
+        dp.blocks.pop_back();
+    }
+    return true;
+}
+
+static void __flush_magazine(int32_t index, magazine &mag) {
+    auto count = __get_magazine_capacity(index) / 2;
+    auto &dp = __get_depots()[index];
+    std::lock_guard<spin_mutex> lock(dp.mx);
+    mag.count -= count;
+    dp.blocks.insert(
+        dp.blocks.end(),
+        mag.blocks + mag.count,
+        mag.blocks + mag.count + count);
+}
+
+void *slab_pool::alloc(uint32_t size, uint32_t *capacity) noexcept {
+    if (pump_unlikely(size > max_block_size)) {
+        if (capacity != nullptr) {
+            *capacity = size;
+        }
+        return pump_malloc(size);
+    }
+
+    auto index = __get_class_index(size);
+    if (capacity != nullptr) {
+        *capacity = __get_class_capacity(index);
+    }
+
+    try {
+        if (pump_unlikely(!__check_magazines())) {
+            // Thread is exiting, allocate the block from depot directly.
+            return __alloc_from_depot(index);
+        }
+        auto &mag = magazines[index];
+        if (mag.count == 0 && !__refill_magazine(index, mag)) {
+            return nullptr;
+        }
+        return mag.blocks[--mag.count];
+    } catch (const std::exception &) {
+        return nullptr;
+    }
+}
+
+void slab_pool::dealloc(void *block, uint32_t capacity) noexcept {
+    if (pump_unlikely(capacity > max_block_size)) {
+        pump_free(block);
+        return;
+    }
+
+    auto index = __get_class_index(capacity);
+    if (pump_unlikely(!__check_magazines())) {
+        // Thread is exiting, return the block to depot directly.
+        auto &dp = __get_depots()[index];
+        std::lock_guard<spin_mutex> lock(dp.mx);
+        dp.blocks.push_back(block);
+        return;
+    }
+
+    auto &mag = magazines[index];
+    if (mag.count == __get_magazine_capacity(index)) {
+        __flush_magazine(index, mag);
+    }
+    mag.blocks[mag.count++] = block;
+}
+
+uint32_t slab_pool::get_block_capacity(uint32_t size) noexcept {
+    if (size > max_block_size) {
+        return size;
+    }
+    return __get_class_capacity(__get_class_index(size));
+}
+
+void slab_pool::set_enabled(bool on) noexcept {
+    pool_enabled.store(on);
+}
+
+bool slab_pool::is_enabled() noexcept {
+    return pool_enabled.load(std::memory_order_relaxed);
+}
+
+}  // namespace toolkit
+}  // namespace pump
@@ -28,10 +28,9 @@ void spin_mutex::lock() noexcept {
     int32_t loop = 0;
     bool exp = false;
 
-    while (1) {
-        if (!locked_.compare_exchange_strong(exp, true)) {
-            break;
-        }
+    while (!locked_.compare_exchange_weak(exp, true)) {
+        // Failed exchanging stores current locked status to exp, so reset it.
+        exp = false;
 
         if (loop++ > per_loop_) {
             loop = 0;
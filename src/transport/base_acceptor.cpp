@@ -42,7 +42,7 @@ bool base_acceptor::__install_accept_tracker(poll::channel_sptr &&ch) {
         return false;
     }
 
-    auto poller = get_service()->get_poller(read_pid);
+    auto poller = __get_poller(read_pid);
     if (poller == nullptr) {
         pump_debug_log("acceptor got invalid read poller");
         return false;
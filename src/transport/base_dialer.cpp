@@ -42,7 +42,7 @@ bool base_dialer::__install_dial_tracker(poll::channel_sptr &&ch) {
         return false;
     }
 
-    auto poller = get_service()->get_poller(send_pid);
+    auto poller = __get_poller(send_pid);
     if (poller == nullptr) {
         pump_debug_log("dialer got invalid send poller");
         return false;
@@ -58,6 +58,9 @@ bool base_dialer::__install_dial_tracker(poll::channel_sptr &&ch) {
 void base_dialer::__uninstall_dial_tracker() {
     if (tracker_ && tracker_->get_poller() != nullptr) {
         tracker_->get_poller()->uninstall_channel_tracker(tracker_);
+        // The dialed socket maybe is tracked by transport later, so clear
+        // poller to avoid uninstalling it again.
+        tracker_->set_poller(nullptr);
     }
 }
 
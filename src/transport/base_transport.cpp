@@ -20,17 +20,513 @@ namespace pump {
 namespace transport {
 
 base_transport::~base_transport() {
-    __uninstall_read_tracker();
-    __uninstall_send_tracker();
+    __uninstall_trackers();
     __close_transport_flow();
+
+    __clear_sendlist();
+
+    if (sent_batch_ != nullptr) {
+        for (auto iob : *sent_batch_) {
+            iob->unrefer();
+        }
+        pump_object_destroy(sent_batch_);
+    }
+    auto spare_batch = spare_sent_batch_.load();
+    if (spare_batch != nullptr) {
+        pump_object_destroy(spare_batch);
+    }
+}
+
+// Read io buffer shrinks after the count of continuous small reads.
+const static int32_t read_iob_shrink_count = 4;
+
+void base_transport::set_read_iob_size_range(int32_t min_size, int32_t max_size) {
+    if (min_size <= 0 || min_size > max_size) {
+        return;
+    }
+    read_iob_min_size_ = min_size;
+    read_iob_max_size_ = max_size;
+    if (read_iob_size_ < min_size) {
+        read_iob_size_ = min_size;
+    } else if (read_iob_size_ > max_size) {
+        read_iob_size_ = max_size;
+    }
+}
+
+void base_transport::set_send_watermark(int32_t high, int32_t low) {
+    if (high < 0 || low < 0 || (high > 0 && low >= high)) {
+        return;
+    }
+    send_low_watermark_.store(low, std::memory_order_relaxed);
+    send_high_watermark_.store(high, std::memory_order_relaxed);
 }
 
 void base_transport::on_channel_event(int32_t ev, void *arg) {
+    if (ev == channel_event_send_watermark) {
+        __trigger_send_watermark_callback();
+        return;
+    } else if (ev == channel_event_buffers_sent) {
+        __trigger_sent_batch_callback((io_buffer_batch *)arg);
+        return;
+    } else if (ev == channel_event_buffer_sent) {
+        auto iob = (toolkit::io_buffer *)arg;
+        cbs_.sent_cb(iob);
+        iob->unrefer();
+        return;
+    } else if (ev == channel_event_read) {
+        on_read_event();
+        return;
+    } else if (ev == channel_event_send) {
+        on_send_event();
+        return;
+    }
     if (__trigger_disconnected_callback() ||
         __trigger_stopped_callback()) {
     }
 }
 
+void base_transport::on_read_event() {
+    // Wait transport starting end
+    while (__is_state(state_starting, std::memory_order_relaxed)) {
+        // pump_debug_log("transport starting, wait");
+    }
+
+    if (rmode_ == read_mode_loop) {
+        __read_until_again();
+        return;
+    }
+
+    bool disconnected = false;
+    char data[max_tcp_buffer_size];
+    toolkit::io_buffer *iob = nullptr;
+    auto size = __read(data, &iob);
+    if (size > 0) {
+        // Free read state.
+        if (!__change_read_state(read_pending, read_none)) {
+            pump_debug_log("free transport's read state failed");
+            disconnected = true;
+        }
+        // Callback data.
+        __callback_read(data, size, iob);
+    } else if (size < 0) {
+        __handle_read_again();
+        if (!__start_read_tracker()) {
+            pump_debug_log("start transport's read tracker failed");
+            disconnected = true;
+        }
+    } else {
+        pump_debug_log("transport read zero size and already disconnected");
+        disconnected = true;
+    }
+
+    if (disconnected) {
+        __try_triggering_disconnected_callback();
+    }
+}
+
+void base_transport::on_send_event() {
+    if (!send_iobs_.empty()) {
+        switch (__resend_to_flow()) {
+        case error_none:
+            __handle_sent_buffers();
+            // Sent buffers must be flushed before reducing pending send size,
+            // after that other thread maybe get the send chance.
+            __flush_sent_buffers();
+            if (__reduce_pending_send_size(send_iobs_size_) > send_iobs_size_) {
+                goto continue_send;
+            }
+            goto end;
+        case error_again:
+            if (!__start_send_tracker()) {
+                pump_debug_log("start transport's send tracker failed");
+                goto disconnected;
+            }
+            return;
+        default:
+            pump_debug_log("transport's flow send data failed");
+            goto disconnected;
+        }
+    }
+
+continue_send:
+    if (pump_unlikely(__is_send_limited())) {
+        // Hold buffers in sendlist until send limiter is refilled.
+        __wait_send_limiter();
+        return;
+    }
+    switch (__send_once()) {
+    case error_none:
+        goto end;
+    case error_again:
+        if (!__start_send_tracker()) {
+            pump_debug_log("start transport's send tracker failed");
+            goto disconnected;
+        }
+        return;
+    default:
+        pump_debug_log("transport send once failed");
+        goto disconnected;
+    }
+
+disconnected:
+    if (__try_triggering_disconnected_callback()) {
+        return;
+    }
+
+end:
+    __trigger_stopped_callback();
+}
+
+void base_transport::on_read_limiter_refilled(base_transport_wptr transp) {
+    auto transp_locker = transp.lock();
+    if (transp_locker && transp_locker->is_started()) {
+        transp_locker->__resume_limited_read();
+    }
+}
+
+void base_transport::on_send_limiter_refilled(base_transport_wptr transp) {
+    // Buffers in sendlist are still sent after stopping, so don't check state.
+    auto transp_locker = transp.lock();
+    if (transp_locker) {
+        transp_locker->__post_channel_event(transp_locker, channel_event_send);
+    }
+}
+
+void base_transport::__read_until_again() {
+    char data[max_tcp_buffer_size];
+    toolkit::io_buffer *iob = nullptr;
+    int32_t read_size = 0;
+    int32_t read_count = 0;
+    while (true) {
+        if (pump_unlikely(__is_read_limited())) {
+            if (iob != nullptr) {
+                __callback_read(data, 0, iob);
+                iob = nullptr;
+            }
+            // Stop reading until read limiter is refilled.
+            __wait_read_limiter();
+            return;
+        }
+
+        if (__is_read_budget_used(read_size, read_count)) {
+            if (iob != nullptr) {
+                __callback_read(data, 0, iob);
+                iob = nullptr;
+            }
+            // Yield to other channels and continue reading later.
+            if (__continue_read()) {
+                return;
+            }
+            pump_debug_log("continue reading transport failed");
+            break;
+        }
+
+        auto size = __read(data, &iob);
+        if (size > 0) {
+            read_size += size;
+            read_count++;
+            // Coalesced io buffer is handed to callback when it is full.
+            if (iob == nullptr || iob->size() == iob->capacity()) {
+                __callback_read(data, size, iob);
+                iob = nullptr;
+            }
+            if (edge_read_ || __has_read_budget() || __has_buffered_read_data()) {
+                continue;
+            }
+            if (iob != nullptr) {
+                __callback_read(data, 0, iob);
+                iob = nullptr;
+            }
+            if (__resume_read()) {
+                return;
+            }
+            pump_debug_log("resume transport's reading failed");
+            break;
+        }
+
+        if (iob != nullptr) {
+            __callback_read(data, 0, iob);
+            iob = nullptr;
+        }
+
+        if (size < 0) {
+            __handle_read_again();
+            if (!edge_read_) {
+                if (__start_read_tracker()) {
+                    return;
+                }
+                pump_debug_log("start transport's read tracker failed");
+                break;
+            }
+            // No more data to read. If edge event comes after reading, read
+            // tracker will be pending, and we should read again.
+            if (r_tracker_->clear_pending()) {
+                continue;
+            }
+            if (__start_read_tracker()) {
+                return;
+            }
+            if (r_tracker_->clear_pending()) {
+                continue;
+            }
+            pump_debug_log("start transport's read tracker failed");
+        } else {
+            pump_debug_log("transport read zero size and already disconnected");
+        }
+        break;
+    }
+
+    __try_triggering_disconnected_callback();
+}
+
+int32_t base_transport::__read(char *b, toolkit::io_buffer **iob) {
+    if (!cbs_.read_iob_cb) {
+        auto size = __read_from_flow(b, max_tcp_buffer_size);
+        if (read_limiter_ && size > 0) {
+            read_limiter_->consume(size);
+        }
+        return size;
+    }
+
+    // Read to the io buffer directly, which is handed to callback without copy.
+    if (*iob == nullptr) {
+        *iob = __create_read_iob();
+        if (pump_unlikely(*iob == nullptr)) {
+            pump_warn_log("new read iob object failed");
+            return 0;
+        }
+    }
+    auto space = int32_t((*iob)->capacity() - (*iob)->size());
+    auto size = __read_from_flow((*iob)->prepare_write(space), space);
+    if (size > 0) {
+        (*iob)->commit_write(size);
+        if (read_limiter_) {
+            read_limiter_->consume(size);
+        }
+    } else if ((*iob)->size() == 0) {
+        (*iob)->unrefer();
+        *iob = nullptr;
+    }
+    return size;
+}
+
+void base_transport::__callback_read(
+    const char *b,
+    int32_t size,
+    toolkit::io_buffer *iob) {
+    if (iob != nullptr) {
+        __adapt_read_iob_size(iob->size());
+        cbs_.read_iob_cb(iob);
+        iob->unrefer();
+    } else {
+        cbs_.read_cb(b, size);
+    }
+}
+
+bool base_transport::__continue_read() {
+    if (edge_read_ || __has_buffered_read_data()) {
+        return __post_channel_event(
+            shared_from_this(),
+            channel_event_read,
+            nullptr,
+            read_pid);
+    }
+    return __start_read_tracker();
+}
+
+void base_transport::__resume_limited_read() {
+    if (!__resume_read()) {
+        pump_debug_log("resume transport's reading failed");
+        __try_triggering_disconnected_callback();
+    }
+}
+
+void base_transport::__wait_read_limiter() {
+    base_transport_wptr wptr = shared_from_this();
+    read_limiter_->wait(pump_bind(&base_transport::on_read_limiter_refilled, wptr));
+}
+
+void base_transport::__wait_send_limiter() {
+    base_transport_wptr wptr = shared_from_this();
+    send_limiter_->wait(pump_bind(&base_transport::on_send_limiter_refilled, wptr));
+}
+
+void base_transport::__handle_sent_buffers() {
+    if (cbs_.sent_batch_cb) {
+        for (auto iob : send_iobs_) {
+            __batch_sent_buffer(iob);
+        }
+    } else if (cbs_.sent_cb) {
+        for (auto iob : send_iobs_) {
+            __post_channel_event(
+                shared_from_this(),
+                channel_event_buffer_sent,
+                iob);
+        }
+    } else {
+        for (auto iob : send_iobs_) {
+            iob->unrefer();
+        }
+    }
+    send_iobs_.clear();
+}
+
+bool base_transport::__async_send(toolkit::io_buffer *iob) {
+    // Push buffer to sendlist.
+    if (pump_unlikely(!sendlist_.push(iob))) {
+        pump_abort_with_log("push iob to queue failed");
+    }
+    return __try_sending(iob->size());
+}
+
+bool base_transport::__async_flush() {
+    return __try_sending(1);
+}
+
+bool base_transport::__try_sending(int32_t size) {
+    // If there are no more buffers, we try to get next send chance.
+    if (__add_pending_send_size(size) > 0) {
+        return true;
+    }
+
+    // Hold buffers in sendlist until send limiter is refilled.
+    if (pump_unlikely(__is_send_limited())) {
+        __wait_send_limiter();
+        return true;
+    }
+
+    switch (__send_once()) {
+    case error_none:
+        return true;
+    case error_again:
+        if (!__start_send_tracker()) {
+            pump_debug_log("start transport's send tracker failed");
+            break;
+        }
+        return true;
+    default:
+        pump_debug_log("transport send once failed");
+        break;
+    }
+
+    if (__set_state(state_started, state_disconnecting)) {
+        __post_channel_event(shared_from_this(), channel_event_disconnected);
+    }
+
+    return false;
+}
+
+error_code base_transport::__send_once() {
+    pump_assert(send_iobs_.empty());
+
+    // Carried buffer is sent before buffers in sendlist.
+    toolkit::io_buffer *iob = carried_iob_;
+    if (iob != nullptr) {
+        carried_iob_ = nullptr;
+    } else if (!sendlist_.pop(iob)) {
+        return __flush_once();
+    }
+    send_iobs_.push_back(iob);
+    send_iobs_size_ = iob->size();
+
+    // Gather more buffers whose size is already added to pending send size. A
+    // buffer pushed to sendlist is added to pending send size later, so gathered
+    // size must not exceed pending send size, or pending send size maybe drops
+    // to zero with buffers left in sendlist. The buffer exceeding is carried to
+    // next sending, and so is the buffer sent alone.
+    int32_t pending_size = pending_send_size_.load(std::memory_order_acquire);
+    int32_t max_file_size = 0;
+    if (__is_sent_alone(iob)) {
+        pending_size = 0;
+        if (iob->is_file() && send_limiter_) {
+            // File buffer is sent in chunks limited by tokens of send limiter,
+            // and the rest of it is carried to next sending.
+            max_file_size = __get_limited_send_size();
+            if (max_file_size < send_iobs_size_) {
+                send_iobs_size_ = max_file_size;
+            }
+        }
+    } else if (send_limiter_) {
+        // Gathered size is limited by tokens of send limiter as well.
+        auto limited_size = __get_limited_send_size();
+        if (limited_size < pending_size) {
+            pending_size = limited_size;
+        }
+    }
+    while (send_iobs_size_ < pending_size &&
+           (int32_t)send_iobs_.size() < pump_iovec_max &&
+           sendlist_.pop(iob)) {
+        if ((int32_t)iob->size() > pending_size - send_iobs_size_ ||
+            __is_sent_alone(iob)) {
+            carried_iob_ = iob;
+            break;
+        }
+        send_iobs_.push_back(iob);
+        send_iobs_size_ += iob->size();
+    }
+
+    if (send_limiter_) {
+        send_limiter_->consume(send_iobs_size_);
+    }
+
+    // Try to send the buffers.
+    auto ret = __send_to_flow(
+        send_iobs_.data(),
+        (int32_t)send_iobs_.size(),
+        max_file_size);
+    if (ret == error_none) {
+        // Handle sent buffers.
+        __handle_sent_buffers();
+    }
+    // Sent buffers must be flushed before reducing pending send size.
+    __flush_sent_buffers();
+
+    if (ret == error_none) {
+        // Reduce pending send size.
+        if (__reduce_pending_send_size(send_iobs_size_) > send_iobs_size_) {
+            return error_again;
+        }
+        return error_none;
+    } else if (ret == error_again) {
+        return error_again;
+    }
+
+    return error_fault;
+}
+
+error_code base_transport::__flush_once() {
+    auto ret = __flush_flow();
+    if (ret == error_none) {
+        // Reduce pending send size taken by flushing.
+        if (__reduce_pending_send_size(1) > 1) {
+            return error_again;
+        }
+        return error_none;
+    } else if (ret == error_again) {
+        return error_again;
+    }
+
+    pump_debug_log("transport flush flow failed");
+    return error_fault;
+}
+
+void base_transport::__clear_sendlist() {
+    for (auto iob : send_iobs_) {
+        iob->unrefer();
+    }
+    send_iobs_.clear();
+
+    if (carried_iob_ != nullptr) {
+        carried_iob_->unrefer();
+        carried_iob_ = nullptr;
+    }
+
+    toolkit::io_buffer *iob;
+    while (sendlist_.pop(iob)) {
+        iob->unrefer();
+    }
+}
+
 bool base_transport::__try_triggering_disconnected_callback() {
     if (__set_state(state_started, state_disconnecting)) {
         return __trigger_disconnected_callback();
@@ -56,7 +552,108 @@ bool base_transport::__trigger_stopped_callback() {
     return false;
 }
 
-bool base_transport::__install_read_tracker() {
+void base_transport::__check_send_high_watermark(int32_t pending_size) {
+    if (pending_size < send_high_watermark_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    bool paused = false;
+    if (send_paused_.compare_exchange_strong(paused, true)) {
+        send_paused_changes_.fetch_add(1);
+        __post_channel_event(shared_from_this(), channel_event_send_watermark);
+        // Pending send size maybe already reduced to the low watermark before
+        // pausing, and no more reducing will resume sending, so check it again.
+        __check_send_low_watermark(pending_send_size_.load());
+    }
+}
+
+void base_transport::__check_send_low_watermark(int32_t pending_size) {
+    if (pending_size > send_low_watermark_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    bool paused = true;
+    if (send_paused_.compare_exchange_strong(paused, false)) {
+        send_paused_changes_.fetch_add(1);
+        __post_channel_event(shared_from_this(), channel_event_send_watermark);
+    }
+}
+
+void base_transport::__trigger_send_watermark_callback() {
+    // Pausing and resuming maybe happen in different threads and their events
+    // maybe out of order, so the status is reloaded here to keep paused and
+    // resumed callbacks in turn.
+    bool paused = send_paused_.load();
+    uint32_t changes = send_paused_changes_.load();
+    if (changes == send_paused_notified_changes_ || !is_started()) {
+        return;
+    }
+    send_paused_notified_changes_ = changes;
+    if (paused == send_paused_notified_) {
+        // Sending was paused and resumed, or resumed and paused since last
+        // notifying, and the status maybe seen by user, so notify both.
+        __trigger_send_watermark_callback(!paused);
+    }
+    __trigger_send_watermark_callback(paused);
+}
+
+void base_transport::__trigger_send_watermark_callback(bool paused) {
+    send_paused_notified_ = paused;
+    if (paused) {
+        if (cbs_.send_paused_cb) {
+            cbs_.send_paused_cb();
+        }
+    } else if (cbs_.send_resumed_cb) {
+        cbs_.send_resumed_cb();
+    }
+}
+
+io_buffer_batch *base_transport::__take_sent_batch() {
+    auto batch = spare_sent_batch_.exchange(nullptr);
+    if (batch == nullptr) {
+        batch = pump_object_create<io_buffer_batch>();
+        if (pump_unlikely(batch == nullptr)) {
+            pump_abort_with_log("new sent batch object failed");
+        }
+    }
+    return batch;
+}
+
+void base_transport::__trigger_sent_batch_callback(io_buffer_batch *batch) {
+    cbs_.sent_batch_cb(batch->data(), (int32_t)batch->size());
+    for (auto iob : *batch) {
+        iob->unrefer();
+    }
+    batch->clear();
+
+    // Keep the batch for reusing.
+    io_buffer_batch *spare_batch = nullptr;
+    if (!spare_sent_batch_.compare_exchange_strong(spare_batch, batch)) {
+        pump_object_destroy(batch);
+    }
+}
+
+void base_transport::__adapt_read_iob_size(int32_t read_size) {
+    if (read_size >= read_iob_size_) {
+        // Read filled the buffer, grow it.
+        read_iob_idle_cnt_ = 0;
+        if (read_iob_size_ < read_iob_max_size_) {
+            read_iob_size_ = read_iob_size_ * 2 < read_iob_max_size_
+                                 ? read_iob_size_ * 2
+                                 : read_iob_max_size_;
+        }
+    } else if (read_size <= read_iob_size_ / 4) {
+        // Shrink the buffer after reads keep much smaller.
+        if (++read_iob_idle_cnt_ >= read_iob_shrink_count) {
+            read_iob_idle_cnt_ = 0;
+            read_iob_size_ = read_iob_size_ / 2 > read_iob_min_size_
+                                 ? read_iob_size_ / 2
+                                 : read_iob_min_size_;
+        }
+    } else {
+        read_iob_idle_cnt_ = 0;
+    }
+}
+
+bool base_transport::__install_read_tracker(int32_t mode) {
     if (r_tracker_) {
         return false;
     }
@@ -70,8 +667,11 @@ bool base_transport::__install_read_tracker() {
         pump_debug_log("new transport's read tracker object failed");
         return false;
     }
+    r_tracker_->set_mode(mode);
+    // Send tracker shares the registration of read tracker if single registration.
+    r_tracker_->set_shareable(single_reg_);
 
-    auto poller = get_service()->get_poller(read_pid);
+    auto poller = __get_poller(read_pid);
     if (poller == nullptr) {
         pump_debug_log("transport got invalid send poller");
         return false;
@@ -101,7 +701,14 @@ bool base_transport::__install_send_tracker() {
         return false;
     }
 
-    auto poller = get_service()->get_poller(send_pid);
+    poll::poller *poller = nullptr;
+    if (single_reg_ && r_tracker_ && r_tracker_->get_poller() != nullptr) {
+        // Send tracker shares the registration of read tracker.
+        s_tracker_->set_host(r_tracker_);
+        poller = r_tracker_->get_poller();
+    } else {
+        poller = __get_poller(send_pid);
+    }
     if (poller == nullptr) {
         pump_debug_log("transport got invalid send poller");
         return false;
@@ -119,12 +726,14 @@ bool base_transport::__install_send_tracker() {
 void base_transport::__uninstall_read_tracker() {
     if (r_tracker_ && r_tracker_->get_poller() != nullptr) {
         r_tracker_->get_poller()->uninstall_channel_tracker(r_tracker_);
+        r_tracker_->set_poller(nullptr);
     }
 }
 
 void base_transport::__uninstall_send_tracker() {
     if (s_tracker_ && s_tracker_->get_poller() != nullptr) {
         s_tracker_->get_poller()->uninstall_channel_tracker(s_tracker_);
+        s_tracker_->set_poller(nullptr);
     }
 }
 
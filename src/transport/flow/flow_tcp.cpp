@@ -21,7 +21,14 @@ namespace transport {
 namespace flow {
 
 flow_tcp::flow_tcp() noexcept
-  : send_iob_(nullptr) {
+  : send_iobs_(nullptr),
+    send_iob_count_(0),
+    send_iob_index_(0),
+    send_file_left_(0),
+    zc_threshold_(0),
+    zc_sending_(false),
+    zc_counter_(0),
+    zc_completed_(0) {
 }
 
 flow_tcp::~flow_tcp() {
@@ -45,30 +52,122 @@ bool flow_tcp::init(
     return true;
 }
 
-error_code flow_tcp::want_to_send(toolkit::io_buffer *iob) {
-    if (iob == nullptr || send_iob_ != nullptr) {
+bool flow_tcp::enable_zerocopy(int32_t threshold) {
+    if (threshold <= 0 || !net::set_zerocopy(fd_, 1)) {
+        return false;
+    }
+    zc_threshold_ = threshold;
+    return true;
+}
+
+error_code flow_tcp::want_to_send(
+    toolkit::io_buffer **iobs,
+    int32_t count,
+    int32_t max_file_size) {
+    if (iobs == nullptr || count <= 0 || count > pump_iovec_max ||
+        send_iobs_ != nullptr) {
         return error_fault;
     }
-    send_iob_ = iob;
+    send_iobs_ = iobs;
+    send_iob_count_ = count;
+    send_iob_index_ = 0;
+    send_file_left_ = iobs[0]->is_file() ? max_file_size : 0;
+    zc_sending_ = zc_threshold_ > 0 &&
+                  count == 1 &&
+                  !iobs[0]->is_file() &&
+                  (int32_t)iobs[0]->size() >= zc_threshold_;
     return send();
 }
 
 error_code flow_tcp::send() {
-    auto size = net::send(fd_, send_iob_->data(), send_iob_->size());
+    int32_t size = 0;
+    if (send_iob_count_ - send_iob_index_ == 1) {
+        auto iob = send_iobs_[send_iob_index_];
+        if (iob->is_file()) {
+            size = (int32_t)iob->size();
+            if (send_file_left_ > 0 && send_file_left_ < size) {
+                size = send_file_left_;
+            }
+            size = net::send_file(fd_, iob->file_fd(), iob->file_offset(), size);
+        } else if (zc_sending_) {
+            size = net::send_zerocopy(fd_, iob->data(), iob->size());
+            if (size > 0) {
+                zc_counter_++;
+            }
+        } else {
+            size = net::send(fd_, iob->data(), iob->size());
+        }
+    } else {
+        pump_iovec iovs[pump_iovec_max];
+        int32_t count = 0;
+        for (int32_t i = send_iob_index_; i < send_iob_count_; i++) {
+            auto iob = send_iobs_[i];
+            net::set_iovec(iovs[count++], iob->data(), iob->size());
+        }
+        size = net::send_vector(fd_, iovs, count);
+    }
     if (size == 0) {
         return error_fault;
     } else if (size < 0) {
         return error_again;
     }
 
-    if (send_iob_->shift(size) == 0) {
-        send_iob_ = nullptr;
+    // Sending of file buffer finishes as well when the max size is sent, and
+    // the rest of the file buffer is left to next sending.
+    bool file_sent = false;
+    if (send_file_left_ > 0) {
+        send_file_left_ -= size;
+        file_sent = send_file_left_ <= 0;
+    }
+
+    // Shift sent data, sent size maybe spans several buffers.
+    while (size > 0) {
+        auto iob = send_iobs_[send_iob_index_];
+        auto shift_size = size < (int32_t)iob->size() ? size : (int32_t)iob->size();
+        if (iob->shift(shift_size) == 0) {
+            send_iob_index_++;
+        }
+        size -= shift_size;
+    }
+
+    if (send_iob_index_ == send_iob_count_ || file_sent) {
+        send_iobs_ = nullptr;
+        send_iob_count_ = 0;
+        send_iob_index_ = 0;
         return error_none;
     }
 
     return error_again;
 }
 
+error_code flow_tcp::read_zerocopy_completions() {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    while (true) {
+        auto ret = net::read_zerocopy_completion(fd_, &lo, &hi);
+        if (ret < 0) {
+            return error_none;
+        } else if (ret == 0) {
+            return error_fault;
+        }
+        __complete_zerocopy(lo, hi);
+    }
+}
+
+void flow_tcp::__complete_zerocopy(uint32_t lo, uint32_t hi) {
+    // Completions maybe come out of order, keep them until previous ones come.
+    if (lo != zc_completed_) {
+        zc_completions_[lo] = hi;
+        return;
+    }
+    zc_completed_ = hi + 1;
+    auto it = zc_completions_.begin();
+    while (it != zc_completions_.end() && it->first == zc_completed_) {
+        zc_completed_ = it->second + 1;
+        it = zc_completions_.erase(it);
+    }
+}
+
 }  // namespace flow
 }  // namespace transport
 }  // namespace pump
@@ -33,7 +33,8 @@ flow_tcp_acceptor::~flow_tcp_acceptor() {
 
 bool flow_tcp_acceptor::init(
     poll::channel_sptr &&ch,
-    const address &listen_address) {
+    const address &listen_address,
+    bool reuse_port) {
     if (!ch) {
         pump_debug_log("channel invalid");
         return false;
@@ -54,6 +55,10 @@ bool flow_tcp_acceptor::init(
         pump_debug_log("set socket address reuse failed %d", net::last_errno());
         return false;
     }
+    if (reuse_port && !net::set_reuse_port(fd_, 1)) {
+        pump_debug_log("set socket port reuse failed %d", net::last_errno());
+        return false;
+    }
     if (!net::set_noblock(fd_, 1)) {
         pump_debug_log("set socket noblock failed %d", net::last_errno());
         return false;
@@ -82,30 +87,32 @@ bool flow_tcp_acceptor::init(
 pump_socket flow_tcp_acceptor::accept(
     address *local_address,
     address *remote_address) {
-    int32_t addrlen = max_address_len;
-    auto client_fd = net::accept(
-        fd_,
-        (struct sockaddr *)iob_->raw(),
-        &addrlen);
-    if (client_fd == invalid_socket) {
-        pump_debug_log("accept socket failed %d", net::last_errno());
-        return invalid_socket;
-    }
+    while (true) {
+        int32_t addrlen = max_address_len;
+        auto client_fd = net::accept(
+            fd_,
+            (struct sockaddr *)iob_->raw(),
+            &addrlen);
+        if (client_fd == invalid_socket) {
+            return invalid_socket;
+        }
 
-    remote_address->set((sockaddr *)iob_->raw(), addrlen);
+        // Socket maybe reset by peer before setting, then only the socket is
+        // closed and next socket is accepted.
+        if (!net::set_nodelay(client_fd, 1)) {
+            pump_debug_log("set socket nodelay failed %d", net::last_errno());
+            net::close(client_fd);
+            continue;
+        }
 
-    addrlen = max_address_len;
-    net::local_address(client_fd, (sockaddr *)iob_->raw(), &addrlen);
-    local_address->set((sockaddr *)iob_->raw(), addrlen);
+        remote_address->set((sockaddr *)iob_->raw(), addrlen);
 
-    if (!net::set_noblock(client_fd, 1) ||
-        !net::set_nodelay(client_fd, 1)) {
-        pump_debug_log("set socket noblock or nodelay failed %d", net::last_errno());
-        net::close(client_fd);
-        return invalid_socket;
-    }
+        addrlen = max_address_len;
+        net::local_address(client_fd, (sockaddr *)iob_->raw(), &addrlen);
+        local_address->set((sockaddr *)iob_->raw(), addrlen);
 
-    return client_fd;
+        return client_fd;
+    }
 }
 
 }  // namespace flow
@@ -23,18 +23,29 @@ namespace flow {
 flow_tls::flow_tls() noexcept
   : is_handshaked_(false),
     session_(nullptr),
-    send_iob_(nullptr) {
+    memory_bio_(false),
+    send_iobs_(nullptr),
+    send_iob_count_(0),
+    send_iob_index_(0),
+    read_iob_(nullptr),
+    pending_records_(false),
+    spare_record_iob_(nullptr) {
 }
 
 flow_tls::~flow_tls() {
     transport::delete_tls_session(session_);
+    if (read_iob_ != nullptr) {
+        read_iob_->unrefer();
+    }
+    __clear_records();
 }
 
 bool flow_tls::init(
     poll::channel_sptr &ch,
     bool client,
     pump_socket fd,
-    transport::tls_credentials xcred) {
+    transport::tls_credentials xcred,
+    bool memory_bio) {
     if (!ch) {
         pump_debug_log("channel invalid");
         return false;
@@ -44,7 +55,16 @@ bool flow_tls::init(
         return false;
     }
 
-    session_ = transport::new_tls_session(client, fd, xcred);
+    if (memory_bio) {
+        read_iob_ = toolkit::io_buffer::create(max_tls_read_batch_size);
+        if (read_iob_ == nullptr) {
+            pump_warn_log("new tls read iob object failed");
+            return false;
+        }
+        session_ = transport::new_tls_memory_session(client, xcred);
+    } else {
+        session_ = transport::new_tls_session(client, fd, xcred);
+    }
     if (session_ == nullptr) {
         pump_debug_log("create tls session object failed ");
         return false;
@@ -52,37 +72,273 @@ bool flow_tls::init(
 
     ch_ = ch;
     fd_ = fd;
+    memory_bio_ = memory_bio;
 
     return true;
 }
 
-error_code flow_tls::want_to_send(toolkit::io_buffer *iob) {
-    if (iob == nullptr || send_iob_ != nullptr) {
+tls_handshake_phase flow_tls::handshake() {
+    if (!memory_bio_) {
+        return transport::tls_handshake(session_);
+    }
+
+    while (true) {
+        auto phase = transport::tls_handshake(session_);
+        if (phase == tls_handshake_error) {
+            return tls_handshake_error;
+        }
+
+        // Handshake records must be sent before reading records of peer.
+        if (!__take_records()) {
+            return tls_handshake_error;
+        }
+        auto ec = __send_records();
+        if (ec == error_again) {
+            return tls_handshake_send;
+        } else if (ec != error_none) {
+            return tls_handshake_error;
+        }
+
+        if (phase == tls_handshake_ok) {
+            return tls_handshake_ok;
+        }
+
+        auto size = __read_records();
+        if (size < 0) {
+            return tls_handshake_read;
+        } else if (size == 0) {
+            return tls_handshake_error;
+        }
+    }
+}
+
+int32_t flow_tls::read(char *b, int32_t size) {
+    if (!memory_bio_) {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        return transport::tls_read(session_, b, size);
+    }
+
+    while (true) {
+        int32_t ret = 0;
+        {
+            std::lock_guard<std::mutex> lock(session_mx_);
+            ret = transport::tls_read(session_, b, size);
+            pending_records_ = transport::tls_get_send_data_size(session_) > 0;
+        }
+        if (ret >= 0) {
+            return ret;
+        }
+        // Records fed before are used up, read more from socket.
+        ret = __read_records();
+        if (ret <= 0) {
+            return ret;
+        }
+    }
+}
+
+error_code flow_tls::want_to_send(toolkit::io_buffer **iobs, int32_t count) {
+    if (iobs == nullptr || count <= 0 || send_iobs_ != nullptr) {
         return error_fault;
     }
-    send_iob_ = iob;
+    send_iobs_ = iobs;
+    send_iob_count_ = count;
+    send_iob_index_ = 0;
     return send();
 }
 
 error_code flow_tls::send() {
-    auto size = transport::tls_send(
-        session_,
-        send_iob_->data(),
-        send_iob_->size());
-    if (size == 0) {
-        return error_fault;
-    } else if (size < 0) {
-        return error_again;
+    if (memory_bio_) {
+        return __send_by_memory_bio();
+    }
+
+    std::lock_guard<std::mutex> lock(session_mx_);
+    while (send_iob_index_ < send_iob_count_) {
+        auto iob = send_iobs_[send_iob_index_];
+        auto size = transport::tls_send(session_, iob->data(), iob->size());
+        if (size == 0) {
+            return error_fault;
+        } else if (size < 0) {
+            return error_again;
+        }
+        if (iob->shift(size) == 0) {
+            send_iob_index_++;
+        }
+    }
+
+    send_iobs_ = nullptr;
+    send_iob_count_ = 0;
+    send_iob_index_ = 0;
+
+    return error_none;
+}
+
+error_code flow_tls::flush_records() {
+    if (!memory_bio_) {
+        return error_none;
+    }
+    {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        if (!__take_records()) {
+            return error_fault;
+        }
     }
+    return __send_records();
+}
+
+void flow_tls::shutdown(int32_t how) {
+    // Records of memory session are sent by send tracker, and memory session
+    // never reads eof from socket. So close notify is only sent by socket
+    // session, which writes it under the session lock as sending data.
+    if (how != SHUT_RD && !memory_bio_) {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        transport::tls_shutdown(session_);
+    }
+    flow_base::shutdown(how);
+}
+
+error_code flow_tls::__send_by_memory_bio() {
+    while (true) {
+        // Records of last batch are sent before encrypting next batch.
+        auto ec = __send_records();
+        if (ec != error_none) {
+            return ec;
+        }
+
+        if (send_iob_index_ == send_iob_count_) {
+            break;
+        }
+
+        // Encrypt a batch of data, writing to memory bio never blocks.
+        std::lock_guard<std::mutex> lock(session_mx_);
+        int32_t batch_size = 0;
+        while (send_iob_index_ < send_iob_count_ &&
+               batch_size < max_tls_send_batch_size) {
+            auto iob = send_iobs_[send_iob_index_];
+            auto size = (int32_t)iob->size();
+            if (size > max_tls_send_batch_size - batch_size) {
+                size = max_tls_send_batch_size - batch_size;
+            }
+            size = transport::tls_send(session_, iob->data(), size);
+            if (size <= 0) {
+                return error_fault;
+            }
+            if (iob->shift(size) == 0) {
+                send_iob_index_++;
+            }
+            batch_size += size;
+        }
 
-    if (send_iob_->shift(size) > 0) {
-        return error_again;
+        if (!__take_records()) {
+            return error_fault;
+        }
     }
-    send_iob_ = nullptr;
+
+    send_iobs_ = nullptr;
+    send_iob_count_ = 0;
+    send_iob_index_ = 0;
 
     return error_none;
 }
 
+int32_t flow_tls::__read_records() {
+    auto b = read_iob_->prepare_write(max_tls_read_batch_size);
+    auto size = net::read(fd_, b, max_tls_read_batch_size);
+    if (size > 0) {
+        std::lock_guard<std::mutex> lock(session_mx_);
+        if (transport::tls_feed_read_data(session_, b, size) != size) {
+            return 0;
+        }
+    }
+    return size;
+}
+
+bool flow_tls::__take_records() {
+    // Records generated on reading maybe taken here as well, such as key update,
+    // if they are not flushed yet.
+    auto pending_size = transport::tls_get_send_data_size(session_);
+    while (pending_size > 0) {
+        auto size = pending_size;
+        if (size > max_tls_record_iob_size) {
+            size = max_tls_record_iob_size;
+        }
+        // Spare record buffer is reused to avoid allocating for every batch.
+        auto iob = spare_record_iob_;
+        if (iob != nullptr) {
+            spare_record_iob_ = nullptr;
+        } else {
+            iob = toolkit::io_buffer::create(size);
+        }
+        if (pump_unlikely(iob == nullptr)) {
+            pump_warn_log("new tls record iob object failed");
+            return false;
+        }
+        if (transport::tls_take_send_data(session_, iob->prepare_write(size), size) != size) {
+            iob->unrefer();
+            return false;
+        }
+        iob->commit_write(size);
+        record_iobs_.push_back(iob);
+        pending_size -= size;
+    }
+    return true;
+}
+
+error_code flow_tls::__send_records() {
+    while (!record_iobs_.empty()) {
+        int32_t size = 0;
+        if (record_iobs_.size() == 1) {
+            auto iob = record_iobs_[0];
+            size = net::send(fd_, iob->data(), iob->size());
+        } else {
+            pump_iovec iovs[pump_iovec_max];
+            int32_t count = 0;
+            for (auto iob : record_iobs_) {
+                if (count == pump_iovec_max) {
+                    break;
+                }
+                net::set_iovec(iovs[count++], iob->data(), iob->size());
+            }
+            size = net::send_vector(fd_, iovs, count);
+        }
+        if (size == 0) {
+            return error_fault;
+        } else if (size < 0) {
+            return error_again;
+        }
+
+        // Shift sent data, sent size maybe spans several buffers.
+        int32_t sent_count = 0;
+        while (size > 0) {
+            auto iob = record_iobs_[sent_count];
+            auto shift_size = size < (int32_t)iob->size() ? size : (int32_t)iob->size();
+            if (iob->shift(shift_size) == 0) {
+                if (spare_record_iob_ == nullptr) {
+                    iob->clear();
+                    spare_record_iob_ = iob;
+                } else {
+                    iob->unrefer();
+                }
+                sent_count++;
+            }
+            size -= shift_size;
+        }
+        record_iobs_.erase(record_iobs_.begin(), record_iobs_.begin() + sent_count);
+    }
+    return error_none;
+}
+
+void flow_tls::__clear_records() {
+    for (auto iob : record_iobs_) {
+        iob->unrefer();
+    }
+    record_iobs_.clear();
+
+    if (spare_record_iob_ != nullptr) {
+        spare_record_iob_->unrefer();
+        spare_record_iob_ = nullptr;
+    }
+}
+
 }  // namespace flow
 }  // namespace transport
 }  // namespace pump
@@ -58,6 +58,14 @@ bool flow_udp::init(
     return true;
 }
 
+bool flow_udp::enable_gso(int32_t segment_size) {
+    return net::set_udp_segment(fd_, segment_size);
+}
+
+bool flow_udp::enable_gro() {
+    return net::set_udp_gro(fd_, 1);
+}
+
 int32_t flow_udp::read_from(
     char *b,
     int32_t size,
@@ -71,6 +79,46 @@ int32_t flow_udp::read_from(
     return size;
 }
 
+int32_t flow_udp::read_from_gro(
+    char *b,
+    int32_t size,
+    address *from,
+    int32_t *segment_size) {
+    auto addrlen = max_address_len;
+    struct sockaddr *addr = from->get();
+    size = net::read_from_gro(fd_, b, size, addr, &addrlen, segment_size);
+    if (size > 0) {
+        from->set((sockaddr *)addr, addrlen);
+    }
+    return size;
+}
+
+int32_t flow_udp::read_from_batch(
+    char *b,
+    int32_t size,
+    udp_datagram *dgs,
+    int32_t count) {
+    pump_iovec iovs[net::max_batch_count];
+    struct sockaddr *addrs[net::max_batch_count];
+    int32_t addrlens[net::max_batch_count];
+    int32_t sizes[net::max_batch_count];
+    if (count > net::max_batch_count) {
+        count = net::max_batch_count;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        net::set_iovec(iovs[i], b + i * size, size);
+        addrs[i] = dgs[i].addr.get();
+        addrlens[i] = max_address_len;
+    }
+    count = net::read_from_batch(fd_, iovs, addrs, addrlens, sizes, count);
+    for (int32_t i = 0; i < count; i++) {
+        dgs[i].addr.set(addrs[i], addrlens[i]);
+        dgs[i].data = b + i * size;
+        dgs[i].size = sizes[i];
+    }
+    return count;
+}
+
 int32_t flow_udp::send(
     const char *b,
     int32_t size,
@@ -83,6 +131,21 @@ int32_t flow_udp::send(
         to.len());
 }
 
+int32_t flow_udp::send_batch(const udp_datagram *dgs, int32_t count) {
+    pump_iovec iovs[net::max_batch_count];
+    struct sockaddr *addrs[net::max_batch_count];
+    int32_t addrlens[net::max_batch_count];
+    if (count > net::max_batch_count) {
+        count = net::max_batch_count;
+    }
+    for (int32_t i = 0; i < count; i++) {
+        net::set_iovec(iovs[i], dgs[i].data, dgs[i].size);
+        addrs[i] = (struct sockaddr *)dgs[i].addr.get();
+        addrlens[i] = dgs[i].addr.len();
+    }
+    return net::send_to_batch(fd_, iovs, addrs, addrlens, count);
+}
+
 }  // namespace flow
 }  // namespace transport
 }  // namespace pump
\ No newline at end of file
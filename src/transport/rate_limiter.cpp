@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pump/time/timestamp.h"
+#include "pump/transport/rate_limiter.h"
+
+namespace pump {
+namespace transport {
+
+// Refill interval of limiter.
+const static uint64_t refill_interval_ns = 10 * 1000 * 1000;  // 10ms
+// Default burst time of limiter.
+const static uint64_t default_burst_ns = 100 * 1000 * 1000;  // 100ms
+
+rate_limiter::rate_limiter(
+    int64_t rate,
+    int64_t burst,
+    const rate_limiter_sptr &parent) noexcept
+  : started_(false),
+    rate_(0),
+    burst_(0),
+    tokens_(0),
+    last_refill_ns_(0),
+    parent_(parent),
+    waiter_cnt_(0) {
+    set_rate(rate, burst);
+    tokens_.store(burst_.load());
+}
+
+rate_limiter::~rate_limiter() {
+    stop();
+}
+
+bool rate_limiter::start(service *sv) {
+    if (sv == nullptr) {
+        pump_debug_log("service invalid");
+        return false;
+    }
+
+    bool expected = false;
+    if (!started_.compare_exchange_strong(expected, true)) {
+        pump_debug_log("rate limiter already started");
+        return false;
+    }
+
+    last_refill_ns_ = time::get_clock_nanoseconds();
+
+    rate_limiter_wptr wptr = shared_from_this();
+    time::timer_callback cb = pump_bind(&rate_limiter::on_refill_timeout, wptr);
+    timer_ = time::timer::create(true, refill_interval_ns, cb);
+    if (!timer_) {
+        pump_warn_log("new rate limiter's timer object failed");
+    } else if (sv->start_timer(timer_)) {
+        return true;
+    }
+
+    started_.store(false);
+
+    return false;
+}
+
+void rate_limiter::stop() {
+    bool expected = true;
+    if (!started_.compare_exchange_strong(expected, false)) {
+        return;
+    }
+    if (timer_) {
+        timer_->stop();
+    }
+    __wake_waiters();
+}
+
+void rate_limiter::set_rate(int64_t rate, int64_t burst) {
+    if (rate <= 0) {
+        pump_debug_log("rate invalid");
+        return;
+    }
+    // Burst must be enough for one refilling, and default burst is tokens of
+    // default burst time.
+    auto min_burst = int64_t((double)rate * refill_interval_ns / 1000000000);
+    if (burst <= 0) {
+        burst = int64_t((double)rate * default_burst_ns / 1000000000);
+    }
+    if (burst < min_burst) {
+        burst = min_burst > 0 ? min_burst : 1;
+    }
+    rate_.store(rate);
+    burst_.store(burst);
+}
+
+int64_t rate_limiter::get_tokens() const noexcept {
+    auto tokens = is_started() ? tokens_.load(std::memory_order_relaxed)
+                               : INT64_MAX;
+    if (parent_) {
+        auto parent_tokens = parent_->get_tokens();
+        if (parent_tokens < tokens) {
+            tokens = parent_tokens;
+        }
+    }
+    return tokens;
+}
+
+bool rate_limiter::is_exhausted() const noexcept {
+    if (is_started() &&
+        (tokens_.load(std::memory_order_relaxed) <= 0 ||
+         waiter_cnt_.load(std::memory_order_relaxed) > 0)) {
+        return true;
+    }
+    return parent_ && parent_->is_exhausted();
+}
+
+void rate_limiter::consume(int64_t size) noexcept {
+    if (is_started()) {
+        tokens_.fetch_sub(size, std::memory_order_relaxed);
+    }
+    if (parent_) {
+        parent_->consume(size);
+    }
+}
+
+void rate_limiter::wait(const waiter_callback &cb) {
+    // Wait the limiter which is exhausted, parent limiter maybe exhausted
+    // instead of this one.
+    if (parent_ &&
+        (!is_started() || tokens_.load(std::memory_order_relaxed) > 0) &&
+        parent_->is_exhausted()) {
+        parent_->wait(cb);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(waiter_mx_);
+        if (is_started()) {
+            waiters_.push_back(cb);
+            waiter_cnt_.store((int32_t)waiters_.size(), std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // Limiter is stopped, so resume the waiter at once.
+    cb();
+}
+
+void rate_limiter::on_refill_timeout(rate_limiter_wptr limiter) {
+    auto limiter_locker = limiter.lock();
+    if (limiter_locker) {
+        limiter_locker->__refill();
+    }
+}
+
+void rate_limiter::__refill() {
+    // Refill by elapsed time, because timer maybe delayed.
+    auto now = time::get_clock_nanoseconds();
+    auto elapsed = now - last_refill_ns_;
+    last_refill_ns_ = now;
+
+    auto burst = burst_.load(std::memory_order_relaxed);
+    auto add = int64_t((double)rate_.load(std::memory_order_relaxed) * elapsed / 1000000000);
+    auto tokens = tokens_.load(std::memory_order_relaxed);
+    while (true) {
+        auto refilled = tokens + add < burst ? tokens + add : burst;
+        if (tokens_.compare_exchange_weak(tokens, refilled)) {
+            tokens = refilled;
+            break;
+        }
+    }
+
+    // Waiters keep waiting until tokens consumed in debt are paid back.
+    if (tokens > 0) {
+        __wake_waiters();
+    }
+}
+
+void rate_limiter::__wake_waiters() {
+    std::vector<waiter_callback> waiters;
+    {
+        std::lock_guard<std::mutex> lock(waiter_mx_);
+        waiters.swap(waiters_);
+        waiter_cnt_.store(0, std::memory_order_relaxed);
+    }
+    // Waiters are resumed in waiting order, then no one is starved.
+    for (auto &cb : waiters) {
+        cb();
+    }
+}
+
+}  // namespace transport
+}  // namespace pump
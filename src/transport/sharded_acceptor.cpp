@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pump/transport/sharded_acceptor.h"
+
+namespace pump {
+namespace transport {
+
+sharded_acceptor::sharded_acceptor(const acceptor_creator &creator) noexcept
+  : creator_(creator),
+    started_(false),
+    running_count_(0) {}
+
+error_code sharded_acceptor::start(service *sv, const acceptor_callbacks &cbs) {
+    if (sv == nullptr || sv->get_shard_count() <= 0) {
+        pump_debug_log("service is invalid");
+        return error_invalid;
+    }
+
+    if (!creator_ ||
+        (!cbs.accepted_cb && !cbs.accepted_batch_cb) ||
+        !cbs.stopped_cb) {
+        pump_debug_log("creator or callbacks is invalid");
+        return error_invalid;
+    }
+
+    bool expected = false;
+    if (!started_.compare_exchange_strong(expected, true)) {
+        pump_debug_log("sharded acceptor already started");
+        return error_fault;
+    }
+
+    cbs_ = cbs;
+
+    acceptor_callbacks acbs;
+    acbs.accepted_cb = cbs.accepted_cb;
+    acbs.accepted_batch_cb = cbs.accepted_batch_cb;
+    acbs.stopped_cb = pump_bind(
+        &sharded_acceptor::on_stopped,
+        sharded_acceptor_wptr(shared_from_this()));
+
+    // Only tcp acceptors accept in batch, other acceptors hand transports to
+    // batch callback one by one.
+    acceptor_callbacks single_acbs = acbs;
+    single_acbs.accepted_batch_cb = nullptr;
+    if (!cbs.accepted_cb) {
+        single_acbs.accepted_cb = pump_bind(
+            &sharded_acceptor::on_accepted,
+            sharded_acceptor_wptr(shared_from_this()),
+            _1);
+    }
+
+    // Running count holds one more reference during starting, so it doesn't drop
+    // to zero before all acceptors are started.
+    running_count_.store(1);
+    int32_t shard_count = sv->get_shard_count();
+    for (shard_id sid = 0; sid < shard_count; sid++) {
+        auto acceptor = creator_();
+        if (!acceptor) {
+            pump_warn_log("create shard acceptor failed");
+            break;
+        }
+        acceptor->set_shard(sid);
+        acceptor->set_reuse_port(true);
+        running_count_.fetch_add(1);
+        auto &shard_acbs =
+            acceptor->get_type() == transport_tcp_acceptor ? acbs : single_acbs;
+        if (acceptor->start(sv, shard_acbs) != error_none) {
+            pump_debug_log("start shard acceptor failed");
+            running_count_.fetch_sub(1);
+            break;
+        }
+        acceptors_.push_back(acceptor);
+    }
+
+    // Started acceptors are stopped if any acceptor failed to start, and then
+    // stopped callback is triggered after all of them stopped.
+    bool failed = (int32_t)acceptors_.size() != shard_count;
+    if (failed) {
+        stop();
+    }
+    if (running_count_.fetch_sub(1) == 1 && !acceptors_.empty()) {
+        cbs_.stopped_cb();
+    }
+
+    return failed ? error_fault : error_none;
+}
+
+void sharded_acceptor::stop() {
+    for (auto &acceptor : acceptors_) {
+        acceptor->stop();
+    }
+}
+
+void sharded_acceptor::on_accepted(
+    sharded_acceptor_wptr acceptor,
+    base_transport_sptr &transp) {
+    auto acceptor_locker = acceptor.lock();
+    if (acceptor_locker) {
+        std::vector<base_transport_sptr> transports(1, transp);
+        acceptor_locker->cbs_.accepted_batch_cb(transports);
+    }
+}
+
+void sharded_acceptor::on_stopped(sharded_acceptor_wptr acceptor) {
+    auto acceptor_locker = acceptor.lock();
+    if (acceptor_locker &&
+        acceptor_locker->running_count_.fetch_sub(1) == 1) {
+        acceptor_locker->cbs_.stopped_cb();
+    }
+}
+
+}  // namespace transport
+}  // namespace pump
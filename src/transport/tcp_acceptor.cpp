@@ -29,7 +29,7 @@ error_code tcp_acceptor::start(service *sv, const acceptor_callbacks &cbs) {
         return error_invalid;
     }
 
-    if (!cbs.accepted_cb ||
+    if ((!cbs.accepted_cb && !cbs.accepted_batch_cb) ||
         !cbs.stopped_cb) {
         pump_debug_log("callbacks is invalid");
         return error_invalid;
@@ -80,19 +80,34 @@ void tcp_acceptor::on_read_event() {
         // pump_debug_log("tcp acceptor starting, wait");
     }
 
-    address local_address;
-    address remote_address;
-    pump_socket fd = flow_->accept(&local_address, &remote_address);
-    if (fd > 0) {
+    std::vector<base_transport_sptr> transports;
+    for (int32_t i = 0; i < accept_budget_; i++) {
+        address local_address;
+        address remote_address;
+        pump_socket fd = flow_->accept(&local_address, &remote_address);
+        if (fd == invalid_socket) {
+            break;
+        }
+
         tcp_transport_sptr tcp_transport = tcp_transport::create();
-        if (tcp_transport) {
-            tcp_transport->init(fd, local_address, remote_address);
-            base_transport_sptr transport = tcp_transport;
-            cbs_.accepted_cb(transport);
-        } else {
+        if (pump_unlikely(!tcp_transport)) {
             pump_warn_log("new tcp transport object failed");
             net::close(fd);
+            continue;
         }
+        tcp_transport->init(fd, local_address, remote_address);
+        __bind_accepted_shard(tcp_transport.get());
+
+        if (cbs_.accepted_batch_cb) {
+            transports.push_back(std::move(tcp_transport));
+        } else {
+            base_transport_sptr transport = tcp_transport;
+            cbs_.accepted_cb(transport);
+        }
+    }
+
+    if (!transports.empty()) {
+        cbs_.accepted_batch_cb(transports);
     }
 
     if (!__start_accept_tracker()) {
@@ -110,7 +125,7 @@ bool tcp_acceptor::__open_accept_flow() {
     if (!flow_) {
         pump_warn_log("new tcp acceptor's flow object failed");
         return false;
-    } else if (!flow_->init(shared_from_this(), listen_address_)) {
+    } else if (!flow_->init(shared_from_this(), listen_address_, reuse_port_)) {
         pump_debug_log("init tcp acceptor's flow failed");
         return false;
     }
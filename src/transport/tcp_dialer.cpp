@@ -71,9 +71,11 @@ error_code tcp_dialer::start(service *sv, const dialer_callbacks &cbs) {
             break;
         }
 
-        if (__set_state(state_starting, state_started)) {
-            return error_none;
-        }
+        // Dialing maybe finished before starting end, then the state has been
+        // changed by send event and callbacks are triggered already.
+        __set_state(state_starting, state_started);
+
+        return error_none;
     } while (false);
 
     __stop_dial_timer();
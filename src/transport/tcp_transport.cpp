@@ -22,14 +22,14 @@ namespace transport {
 
 tcp_transport::tcp_transport() noexcept
   : base_transport(transport_tcp, nullptr, -1),
-    last_send_iob_size_(0),
-    last_send_iob_(nullptr),
-    pending_opt_cnt_(0),
-    sendlist_(32) {
+    zc_threshold_(0),
+    pending_opt_cnt_(0) {
 }
 
 tcp_transport::~tcp_transport() {
-    __clear_sendlist();
+    __uninstall_trackers();
+
+    __clear_zerocopy_buffers();
 }
 
 void tcp_transport::init(
@@ -58,7 +58,27 @@ error_code tcp_transport::start(
         return error_invalid;
     }
 
-    if (!cbs.read_cb ||
+    if (edge_read_ && mode != read_mode_loop) {
+        pump_debug_log("edge triggered read only works with read loop mode");
+        return error_invalid;
+    }
+
+    if (__has_read_budget() && mode != read_mode_loop) {
+        pump_debug_log("read budget only works with read loop mode");
+        return error_invalid;
+    }
+
+    if (zc_threshold_ > 0 && mode != read_mode_loop) {
+        pump_debug_log("zero copy send only works with read loop mode");
+        return error_invalid;
+    }
+
+    if (edge_read_ && single_reg_) {
+        pump_debug_log("edge triggered read doesn't work with single registration");
+        return error_invalid;
+    }
+
+    if ((!cbs.read_cb && !cbs.read_iob_cb) ||
         !cbs.stopped_cb ||
         !cbs.disconnected_cb) {
         pump_debug_log("callbacks invalid");
@@ -87,7 +107,13 @@ error_code tcp_transport::start(
             break;
         }
 
-        if (!__install_read_tracker()) {
+        if (zc_threshold_ > 0 && !flow_->enable_zerocopy(zc_threshold_)) {
+            pump_debug_log("enable zero copy failed, send with copy");
+            zc_threshold_ = 0;
+        }
+
+        if (!__install_read_tracker(
+                edge_read_ ? poll::tracker_mode_edge : poll::tracker_mode_oneshot)) {
             pump_debug_log("install tcp transport's read tracker failed");
             break;
         }
@@ -167,7 +193,7 @@ error_code tcp_transport::async_read() {
         if (!__change_read_state(read_none, read_pending)) {
             pump_debug_log("tcp transport already reading by loop");
             ec = error_fault;
-        } else if (!__start_read_tracker()) {
+        } else if (!__resume_read()) {
             pump_debug_log("start tcp transport's read tracker failed");
             ec = error_fault;
         }
@@ -175,7 +201,7 @@ error_code tcp_transport::async_read() {
         if (!__change_read_state(read_none, read_pending)) {
             pump_debug_log("tcp transport already reading");
             ec = error_fault;
-        } else if (!__start_read_tracker()) {
+        } else if (!__resume_read()) {
             pump_debug_log("start tcp transport's read tracker failed");
             ec = error_fault;
         }
@@ -258,100 +284,60 @@ error_code tcp_transport::send(toolkit::io_buffer *iob) {
     return ec;
 }
 
-void tcp_transport::on_channel_event(int32_t ev, void *arg) {
-    switch (ev) {
-    case channel_event_disconnected: {
-        base_transport::on_channel_event(ev, arg);
-        break;
-    }
-    case channel_event_buffer_sent: {
-        auto iob = (toolkit::io_buffer *)arg;
-        cbs_.sent_cb(iob);
-        iob->unrefer();
-        break;
-    }
-    default:
-        pump_abort_with_log("unknown channel event %d", ev);
+error_code tcp_transport::send_file(int32_t fd, int64_t offset, int32_t size) {
+    if (fd < 0 || offset < 0 || size <= 0) {
+        pump_debug_log("file region is invalid");
+        return error_invalid;
     }
-}
 
-void tcp_transport::on_read_event() {
-    // Wait transport starting end
-    while (__is_state(state_starting, std::memory_order_relaxed)) {
-        // pump_debug_log("tcp transport starting, wait");
+#if defined(PUMP_HAVE_WINSOCK)
+    pump_debug_log("tcp transport send file not supported");
+    return error_disable;
+#else
+    if (!is_started()) {
+        pump_debug_log("tcp transport not started");
+        return error_unstart;
     }
 
-    bool disconnected = false;
-    char data[max_tcp_buffer_size];
-    auto size = flow_->read(data, max_tcp_buffer_size);
-    if (size > 0) {
-        if (rmode_ == read_mode_once) {
-            // Free read state.
-            if (!__change_read_state(read_pending, read_none)) {
-                pump_debug_log("free tcp transport's read state failed");
-                disconnected = true;
-            }
-        } else {
-            if (!__start_read_tracker()) {
-                pump_debug_log("start tcp transport's read tracker failed");
-                disconnected = true;
-            }
+    auto ec = error_none;
+    pending_opt_cnt_.fetch_add(1, std::memory_order_relaxed);
+    do {
+        if (pump_unlikely(!__is_state(state_started))) {
+            pump_debug_log("tcp transport not started");
+            ec = error_unstart;
+            break;
         }
-        // Callback data.
-        cbs_.read_cb(data, size);
-    } else {
-        pump_debug_log("tcp transport read zero size and already disconnected");
-        disconnected = true;
-    }
-
-    if (disconnected) {
-        __try_triggering_disconnected_callback();
-    }
-}
 
-void tcp_transport::on_send_event() {
-    if (last_send_iob_ != nullptr) {
-        switch (flow_->send()) {
-        case error_none:
-            __handle_sent_buffer();
-            if (pending_send_size_.fetch_sub(last_send_iob_size_) > last_send_iob_size_) {
-                goto continue_send;
-            }
-            goto end;
-        case error_again:
-            if (!__start_send_tracker()) {
-                pump_debug_log("start tcp transport's send tracker failed");
-                goto disconnected;
-            }
-            return;
-        default:
-            pump_debug_log("tcp transport's flow send data failed");
-            goto disconnected;
+        // File buffer owns the duplicated fd.
+        auto file_fd = ::dup(fd);
+        if (file_fd < 0) {
+            pump_debug_log("duplicate file fd failed");
+            ec = error_invalid;
+            break;
         }
-    }
-
-continue_send:
-    switch (__send_once()) {
-    case error_none:
-        goto end;
-    case error_again:
-        if (!__start_send_tracker()) {
-            pump_debug_log("start tcp transport's send tracker failed");
-            goto disconnected;
+        auto iob = toolkit::io_buffer::create_by_file(file_fd, offset, size);
+        if (iob == nullptr) {
+            ::close(file_fd);
+            pump_warn_log("new file iob object failed");
+            ec = error_fault;
+            break;
         }
-        return;
-    default:
-        pump_debug_log("tcp transport send once failed");
-        goto disconnected;
-    }
+        if (!__async_send(iob)) {
+            pump_debug_log("tcp transport async send failed");
+            ec = error_fault;
+        }
+    } while (false);
+    pending_opt_cnt_.fetch_sub(1, std::memory_order_relaxed);
 
-disconnected:
-    if (__try_triggering_disconnected_callback()) {
-        return;
-    }
+    return ec;
+#endif
+}
 
-end:
-    __trigger_stopped_callback();
+void tcp_transport::on_send_event() {
+    if (zc_threshold_ > 0) {
+        __release_zerocopy_buffers();
+    }
+    base_transport::on_send_event();
 }
 
 bool tcp_transport::__open_transport_flow() {
@@ -381,86 +367,78 @@ void tcp_transport::__close_transport_flow() {
     }
 }
 
-bool tcp_transport::__async_send(toolkit::io_buffer *iob) {
-    // Push buffer to sendlist.
-    if (pump_unlikely(!sendlist_.push(iob))) {
-        pump_abort_with_log("push iob to queue failed");
-    }
-
-    // If there are no more buffers, we try to get next send chance.
-    if (pending_send_size_.fetch_add(iob->size()) > 0) {
-        return true;
-    }
-
-    switch (__send_once()) {
-    case error_none:
-        return true;
-    case error_again:
-        if (!__start_send_tracker()) {
-            pump_debug_log("start tcp transport's send tracker failed");
-            break;
-        }
-        return true;
-    default:
-        pump_debug_log("tcp transport send once failed");
-        break;
+void tcp_transport::__handle_sent_buffers() {
+    // Rest of file buffer sent in chunks is carried to next sending, and its
+    // size is still pending.
+    auto first = send_iobs_[0];
+    if (pump_unlikely(first->is_file() && first->size() > 0)) {
+        carried_iob_ = first;
+        send_iobs_.clear();
+        return;
     }
 
-    if (__set_state(state_started, state_disconnecting)) {
-        __post_channel_event(shared_from_this(), channel_event_disconnected);
+    if (pump_unlikely(flow_->is_zerocopy_sent())) {
+        __hold_zerocopy_buffer(send_iobs_[0]);
+        send_iobs_.clear();
+        return;
     }
 
-    return false;
+    base_transport::__handle_sent_buffers();
 }
 
-error_code tcp_transport::__send_once() {
-    // Pop next buffer from sendlist to send.
-    pump_assert(last_send_iob_ == nullptr);
-    if (pump_unlikely(!sendlist_.pop(last_send_iob_))) {
-        pump_abort_with_log("pop iob from queue failed");
+void tcp_transport::__hold_zerocopy_buffer(toolkit::io_buffer *iob) {
+    {
+        std::lock_guard<std::mutex> lock(zc_mx_);
+        zc_iobs_.push_back(std::make_pair(iob, flow_->get_zerocopy_counter() - 1));
     }
+    // Completion maybe already read on read event.
+    __release_zerocopy_buffers();
+}
 
-    // Save last send buffer data size.
-    last_send_iob_size_ = last_send_iob_->size();
-
-    // Try to send the buffer.
-    auto ret = flow_->want_to_send(last_send_iob_);
-    if (ret == error_none) {
-        // Handle sent buffer.
-        __handle_sent_buffer();
-        // Reduce pending send size.
-        if (pending_send_size_.fetch_sub(last_send_iob_size_) > last_send_iob_size_) {
-            return error_again;
+void tcp_transport::__release_zerocopy_buffers() {
+    std::vector<toolkit::io_buffer *> iobs;
+    {
+        std::lock_guard<std::mutex> lock(zc_mx_);
+        if (flow_->read_zerocopy_completions() != error_none) {
+            pump_debug_log("read tcp transport's zero copy completions failed");
+        }
+        auto completed = flow_->get_zerocopy_completed();
+        while (!zc_iobs_.empty() &&
+               int32_t(zc_iobs_.front().second - completed) < 0) {
+            iobs.push_back(zc_iobs_.front().first);
+            zc_iobs_.pop_front();
         }
-        return error_none;
-    } else if (ret == error_again) {
-        return error_again;
+    }
+    if (iobs.empty()) {
+        return;
     }
 
-    return error_fault;
-}
-
-void tcp_transport::__handle_sent_buffer() {
-    if (cbs_.sent_cb) {
+    if (cbs_.sent_batch_cb) {
+        auto batch = __take_sent_batch();
+        batch->assign(iobs.begin(), iobs.end());
         __post_channel_event(
             shared_from_this(),
-            channel_event_buffer_sent,
-            last_send_iob_);
+            channel_event_buffers_sent,
+            batch);
+    } else if (cbs_.sent_cb) {
+        for (auto iob : iobs) {
+            __post_channel_event(
+                shared_from_this(),
+                channel_event_buffer_sent,
+                iob);
+        }
     } else {
-        last_send_iob_->unrefer();
+        for (auto iob : iobs) {
+            iob->unrefer();
+        }
     }
-    last_send_iob_ = nullptr;
 }
 
-void tcp_transport::__clear_sendlist() {
-    if (last_send_iob_ != nullptr) {
-        last_send_iob_->unrefer();
-    }
-
-    toolkit::io_buffer *iob;
-    while (sendlist_.pop(iob)) {
-        iob->unrefer();
+void tcp_transport::__clear_zerocopy_buffers() {
+    for (auto &zc_iob : zc_iobs_) {
+        zc_iob.first->unrefer();
     }
+    zc_iobs_.clear();
 }
 
 }  // namespace transport
@@ -26,7 +26,11 @@ tls_acceptor::tls_acceptor(
     uint64_t handshake_timeout_ns) noexcept
   : base_acceptor(transport_tls_acceptor, listen_address),
     xcred_(xcred),
-    handshake_timeout_ns_(handshake_timeout_ns) {
+    handshake_timeout_ns_(handshake_timeout_ns),
+    memory_bio_(false),
+    max_handshakes_(0),
+    max_queued_handshakes_(1024),
+    accept_paused_(false) {
 }
 
 tls_acceptor::~tls_acceptor() {
@@ -97,47 +101,19 @@ void tls_acceptor::on_read_event() {
         // pump_debug_log("tls acceptor starting, wait");
     }
 
-    do {
+    for (int32_t i = 0; i < accept_budget_; i++) {
+        // Tracker is restarted when a queued socket starts handshaking.
+        if (__pause_accepting_if_full()) {
+            return;
+        }
+
         address local_address, remote_address;
         pump_socket fd = flow_->accept(&local_address, &remote_address);
-        if (fd > 0) {
-            tls_handshaker *handshaker = __create_handshaker();
-            if (pump_unlikely(handshaker == nullptr)) {
-                pump_warn_log("create tls handshaker failed");
-                net::close(fd);
-                break;
-            }
-
-            tls_handshaker::tls_handshaker_callbacks handshaker_cbs;
-            handshaker_cbs.handshaked_cb = pump_bind(
-                &tls_acceptor::on_handshaked,
-                shared_from_this(),
-                _1,
-                _2);
-            handshaker_cbs.stopped_cb = pump_bind(
-                &tls_acceptor::on_handshake_stopped,
-                shared_from_this(),
-                _1);
-            if (!handshaker->init(
-                    fd,
-                    false,
-                    xcred_,
-                    local_address,
-                    remote_address)) {
-                pump_debug_log("init tls handshaker failed");
-                __remove_handshaker(handshaker);
-                break;
-            }
-            if (!handshaker->start(
-                    get_service(),
-                    handshake_timeout_ns_,
-                    handshaker_cbs)) {
-                pump_debug_log("start tls handshaker failed");
-                __remove_handshaker(handshaker);
-                break;
-            }
+        if (fd == invalid_socket) {
+            break;
         }
-    } while (false);
+        __handshake_accepted(fd, local_address, remote_address);
+    }
 
     if (!__start_accept_tracker()) {
         if (__is_state(state_started)) {
@@ -166,6 +142,7 @@ void tls_acceptor::on_handshaked(
             handshaker->unlock_flow(),
             handshaker->get_local_address(),
             handshaker->get_remote_address());
+        acceptor_locker->__bind_accepted_shard(tls_transport.get());
 
         base_transport_sptr transport = tls_transport;
         acceptor_locker->cbs_.accepted_cb(transport);
@@ -189,7 +166,7 @@ bool tls_acceptor::__open_accept_flow() {
     if (!flow_) {
         pump_warn_log("new tls acceptor's flow failed");
         return false;
-    } else if (!flow_->init(shared_from_this(), listen_address_)) {
+    } else if (!flow_->init(shared_from_this(), listen_address_, reuse_port_)) {
         pump_debug_log("init tls acceptor's flow failed");
         return false;
     }
@@ -205,6 +182,82 @@ void tls_acceptor::__close_accept_flow() {
     }
 }
 
+bool tls_acceptor::__pause_accepting_if_full() {
+    if (max_handshakes_ <= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(handshaker_mx_);
+    if ((int32_t)queued_sockets_.size() < max_queued_handshakes_) {
+        return false;
+    }
+    accept_paused_ = true;
+    return true;
+}
+
+void tls_acceptor::__handshake_accepted(
+    pump_socket fd,
+    const address &local_address,
+    const address &remote_address) {
+    tls_handshaker *handshaker = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(handshaker_mx_);
+        if (max_handshakes_ > 0 &&
+            (int32_t)handshakers_.size() >= max_handshakes_) {
+            queued_sockets_.push_back({fd, local_address, remote_address});
+            return;
+        }
+        handshaker = __create_handshaker();
+    }
+    if (pump_unlikely(handshaker == nullptr)) {
+        pump_warn_log("create tls handshaker failed");
+        net::close(fd);
+        return;
+    }
+    if (!__start_handshaker(handshaker, fd, local_address, remote_address)) {
+        __remove_handshaker(handshaker);
+    }
+}
+
+bool tls_acceptor::__start_handshaker(
+    tls_handshaker *handshaker,
+    pump_socket fd,
+    const address &local_address,
+    const address &remote_address) {
+    __bind_accepted_shard(handshaker);
+
+    tls_handshaker::tls_handshaker_callbacks handshaker_cbs;
+    handshaker_cbs.handshaked_cb = pump_bind(
+        &tls_acceptor::on_handshaked,
+        shared_from_this(),
+        _1,
+        _2);
+    handshaker_cbs.stopped_cb = pump_bind(
+        &tls_acceptor::on_handshake_stopped,
+        shared_from_this(),
+        _1);
+    if (!handshaker->init(
+            fd,
+            false,
+            xcred_,
+            local_address,
+            remote_address,
+            memory_bio_)) {
+        pump_debug_log("init tls handshaker failed");
+        return false;
+    }
+    if (handshake_pool_) {
+        handshaker->set_handshake_pool(handshake_pool_);
+    }
+    if (!handshaker->start(
+            get_service(),
+            handshake_timeout_ns_,
+            handshaker_cbs)) {
+        pump_debug_log("start tls handshaker failed");
+        return false;
+    }
+    return true;
+}
+
 tls_handshaker *tls_acceptor::__create_handshaker() {
     tls_handshaker_sptr handshaker(
         pump_object_create<tls_handshaker>(),
@@ -213,18 +266,58 @@ tls_handshaker *tls_acceptor::__create_handshaker() {
         pump_warn_log("new tls handshaker object failed");
         return nullptr;
     }
-    std::lock_guard<std::mutex> lock(handshaker_mx_);
     handshakers_[handshaker.get()] = handshaker;
     return handshaker.get();
 }
 
 bool tls_acceptor::__remove_handshaker(tls_handshaker *handshaker) {
-    std::lock_guard<std::mutex> lock(handshaker_mx_);
-    auto it = handshakers_.find(handshaker);
-    if (it == handshakers_.end()) {
-        return false;
+    bool resume_accepting = false;
+    {
+        std::lock_guard<std::mutex> lock(handshaker_mx_);
+        auto it = handshakers_.find(handshaker);
+        if (it == handshakers_.end()) {
+            return false;
+        }
+        handshakers_.erase(it);
+    }
+
+    // Handshake queued sockets until one handshaker starts. Failed handshakers
+    // are removed in the loop, so many failed sockets don't recurse deeply.
+    while (true) {
+        queued_socket next;
+        tls_handshaker *next_handshaker = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(handshaker_mx_);
+            if (queued_sockets_.empty() || !__is_state(state_started)) {
+                break;
+            }
+            next_handshaker = __create_handshaker();
+            if (next_handshaker == nullptr) {
+                break;
+            }
+            next = queued_sockets_.front();
+            queued_sockets_.pop_front();
+            if (accept_paused_) {
+                resume_accepting = true;
+                accept_paused_ = false;
+            }
+        }
+        if (__start_handshaker(
+                next_handshaker,
+                next.fd,
+                next.local_address,
+                next.remote_address)) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(handshaker_mx_);
+        handshakers_.erase(next_handshaker);
     }
-    handshakers_.erase(it);
+    if (resume_accepting && !__start_accept_tracker()) {
+        if (__is_state(state_started)) {
+            pump_err_log("start tls acceptor's tracker failed");
+        }
+    }
+
     return true;
 }
 
@@ -234,6 +327,10 @@ void tls_acceptor::__stop_all_handshakers() {
         hs.second->stop();
     }
     handshakers_.clear();
+    for (auto &qs : queued_sockets_) {
+        net::close(qs.fd);
+    }
+    queued_sockets_.clear();
 }
 
 }  // namespace transport
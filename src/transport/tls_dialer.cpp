@@ -32,7 +32,8 @@ tls_dialer::tls_dialer(
         remote_address,
         dial_timeout_ns),
     xcred_(xcred),
-    handshake_timeout_ns_(handshake_timeout_ns) {
+    handshake_timeout_ns_(handshake_timeout_ns),
+    memory_bio_(false) {
     if (xcred_ == nullptr) {
         xcred_ = new_client_tls_credentials();
     }
@@ -91,9 +92,11 @@ error_code tls_dialer::start(service *sv, const dialer_callbacks &cbs) {
             break;
         }
 
-        if (__set_state(state_starting, state_started)) {
-            return error_none;
-        }
+        // Dialing maybe finished before starting end, then the state has been
+        // changed by send event and callbacks are triggered already.
+        __set_state(state_starting, state_started);
+
+        return error_none;
     } while (false);
 
     __stop_dial_timer();
@@ -153,10 +156,17 @@ void tls_dialer::on_send_event() {
                 true,
                 xcred_,
                 local_address,
-                remote_address)) {
+                remote_address,
+                memory_bio_)) {
             pump_debug_log("init tls handshaker failed");
             break;
         }
+        if (session_store_ && !handshaker_->resume_session(session_store_)) {
+            pump_debug_log("resume tls session failed");
+        }
+        if (handshake_pool_) {
+            handshaker_->set_handshake_pool(handshake_pool_);
+        }
 
         tls_handshaker::tls_handshaker_callbacks tls_cbs;
         tls_cbs.handshaked_cb = pump_bind(
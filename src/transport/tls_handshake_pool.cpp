@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2015-2018 ZhengHaiTao <ming8ren@163.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pump/debug.h"
+#include "pump/transport/tls_handshake_pool.h"
+
+namespace pump {
+namespace transport {
+
+tls_handshake_pool::tls_handshake_pool(
+    int32_t worker_count,
+    int32_t max_pending_count)
+  : running_(false),
+    worker_count_(worker_count),
+    max_pending_count_(max_pending_count > 0 ? max_pending_count : 1),
+    pending_count_(0),
+    tasks_(1024) {
+    if (worker_count_ <= 0) {
+        worker_count_ = (int32_t)std::thread::hardware_concurrency();
+        if (worker_count_ <= 0) {
+            worker_count_ = 1;
+        }
+    }
+}
+
+tls_handshake_pool::~tls_handshake_pool() {
+    stop();
+    for (auto &worker : workers_) {
+        worker->join();
+    }
+}
+
+bool tls_handshake_pool::start() {
+    if (running_.exchange(true)) {
+        pump_debug_log("tls handshake pool already started");
+        return false;
+    }
+
+    for (int32_t i = 0; i < worker_count_; i++) {
+        workers_.push_back(std::shared_ptr<std::thread>(
+            pump_object_create<std::thread>(
+                pump_bind(&tls_handshake_pool::__run_worker, this)),
+            pump_object_destroy<std::thread>));
+    }
+
+    return true;
+}
+
+void tls_handshake_pool::stop() {
+    if (running_.exchange(false)) {
+        // Wake up all workers to exit.
+        pending_tasks_.signal(worker_count_);
+    }
+}
+
+bool tls_handshake_pool::post(task_callback &&task) {
+    if (pump_unlikely(!running_.load(std::memory_order_relaxed))) {
+        return false;
+    }
+
+    auto count = pending_count_.fetch_add(1, std::memory_order_relaxed);
+    if (count >= max_pending_count_) {
+        pending_count_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (pump_unlikely(!tasks_.push(std::move(task)))) {
+        pending_count_.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    pending_tasks_.signal();
+
+    // Workers maybe exited if pool stopped after checking running state above,
+    // then tasks left in queue are run here instead of waiting for ever.
+    if (pump_unlikely(!running_.load())) {
+        task_callback left;
+        while (tasks_.pop(left)) {
+            pending_count_.fetch_sub(1, std::memory_order_relaxed);
+            left();
+            left = nullptr;
+        }
+    }
+
+    return true;
+}
+
+void tls_handshake_pool::__run_worker() {
+    task_callback task;
+    while (true) {
+        if (!pending_tasks_.wait(1000000000)) {
+            if (!running_.load(std::memory_order_relaxed)) {
+                break;
+            }
+            continue;
+        }
+        // Pending tasks are still run after stopping, because handshakers of
+        // them are waiting for results.
+        if (tasks_.pop(task)) {
+            pending_count_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+        } else if (!running_.load(std::memory_order_relaxed)) {
+            break;
+        }
+    }
+}
+
+}  // namespace transport
+}  // namespace pump
@@ -35,13 +35,14 @@ bool tls_handshaker::init(
     bool client,
     tls_credentials xcred,
     const address &local_address,
-    const address &remote_address) {
+    const address &remote_address,
+    bool memory_bio) {
     // Set addresses.
     local_address_ = local_address;
     remote_address_ = remote_address;
 
     // Open flow.
-    if (!__open_flow(client, fd, xcred)) {
+    if (!__open_flow(client, fd, xcred, memory_bio)) {
         pump_debug_log("open tls handshaker's flow falied");
         net::close(fd);
         return false;
@@ -50,6 +51,14 @@ bool tls_handshaker::init(
     return true;
 }
 
+bool tls_handshaker::resume_session(tls_session_store_sptr &store) {
+    if (!flow_) {
+        pump_debug_log("tls handshaker's flow invalid");
+        return false;
+    }
+    return flow_->resume_session(store, remote_address_.to_string());
+}
+
 bool tls_handshaker::start(
     service *sv,
     uint64_t timeout_ns,
@@ -79,11 +88,15 @@ bool tls_handshaker::start(
 
         __set_service(sv);
 
-        // Flow init handshake
-        auto phase = flow_->handshake();
-        if (phase == tls_handshake_error) {
-            pump_debug_log("tls flow handshake failed");
-            break;
+        // Flow init handshake. With handshake pool, the first step runs in the
+        // pool after socket is writable.
+        tls_handshake_phase phase = tls_handshake_send;
+        if (pool_.expired()) {
+            phase = flow_->handshake();
+            if (phase == tls_handshake_error) {
+                pump_debug_log("tls flow handshake failed");
+                break;
+            }
         }
 
         // Start handshake timeout timer
@@ -102,14 +115,15 @@ bool tls_handshaker::start(
             pump_warn_log("new tls handshaker's tracker object failed");
             break;
         }
-        // Start tracker.
-        if (phase == tls_handshake_send) {
+        // Start tracker. Handshake maybe finished at once if peer is fast, then
+        // it's finished by send event as socket is writable.
+        if (phase == tls_handshake_send || phase == tls_handshake_ok) {
             tracker_->set_expected_event(poll::track_send);
         } else {
             tracker_->set_expected_event(poll::track_read);
         }
 
-        auto poller = get_service()->get_poller(send_pid);
+        auto poller = __get_poller(send_pid);
         if (poller == nullptr || !poller->install_channel_tracker(tracker_)) {
             pump_debug_log("install tls handshaker's tracker failed");
             break;
@@ -136,6 +150,13 @@ void tls_handshaker::stop() {
 }
 
 void tls_handshaker::on_channel_event(int32_t ev, void *arg) {
+    if (ev == channel_event_handshake_step) {
+        // Handshaker maybe stopped or timeouted while the step was running.
+        if (__is_state(state_started)) {
+            __handle_handshake_phase((tls_handshake_phase)(intptr_t)arg);
+        }
+        return;
+    }
     __handshake_finished();
 }
 
@@ -167,7 +188,22 @@ void tls_handshaker::on_timeout(tls_handshaker_wptr wptr) {
     }
 }
 
-bool tls_handshaker::__open_flow(bool client, pump_socket fd, void *xcred) {
+void tls_handshaker::on_handshake_task(tls_handshaker_sptr handshaker) {
+    auto phase = handshaker->flow_->handshake();
+    // Handle the phase in the poller of handshaker, where tracker is started.
+    if (!handshaker->__post_channel_event(
+            handshaker,
+            channel_event_handshake_step,
+            (void *)(intptr_t)phase)) {
+        pump_debug_log("post tls handshake step event failed");
+    }
+}
+
+bool tls_handshaker::__open_flow(
+    bool client,
+    pump_socket fd,
+    tls_credentials xcred,
+    bool memory_bio) {
     // Create flow.
     flow_.reset(
         pump_object_create<flow::flow_tls>(),
@@ -179,7 +215,7 @@ bool tls_handshaker::__open_flow(bool client, pump_socket fd, void *xcred) {
 
     // Init flow.
     poll::channel_sptr ch = shared_from_this();
-    if (!flow_->init(ch, client, fd, xcred)) {
+    if (!flow_->init(ch, client, fd, xcred, memory_bio)) {
         pump_debug_log("init tls handshaker's flow failed");
         net::close(fd);
         return false;
@@ -192,7 +228,18 @@ bool tls_handshaker::__open_flow(bool client, pump_socket fd, void *xcred) {
 }
 
 void tls_handshaker::__process_handshake() {
-    switch (flow_->handshake()) {
+    auto pool = pool_.lock();
+    if (pool && pool->post(pump_bind(
+                    &tls_handshaker::on_handshake_task,
+                    shared_from_this()))) {
+        return;
+    }
+    // Handshake in poller without pool or if pool is full.
+    __handle_handshake_phase(flow_->handshake());
+}
+
+void tls_handshaker::__handle_handshake_phase(tls_handshake_phase phase) {
+    switch (phase) {
     case tls_handshake_ok:
         if (__set_state(state_started, state_finished)) {
             __handshake_finished();
@@ -245,10 +292,12 @@ void tls_handshaker::__handshake_finished() {
     // Stop handshake timer
     __stop_handshake_timer();
 
-    // Stop tracker.
+    // Stop tracker. Clear its poller to avoid uninstalling it again on
+    // destruction, for the socket maybe is tracked by transport at that time.
     pump_assert(tracker_);
     pump_assert(tracker_->get_poller() != nullptr);
     tracker_->get_poller()->uninstall_channel_tracker(tracker_);
+    tracker_->set_poller(nullptr);
 
     if (__is_state(state_finished)) {
         cbs_.handshaked_cb(this, true);
@@ -22,14 +22,11 @@ namespace transport {
 
 tls_transport::tls_transport() noexcept
   : base_transport(transport_tls, nullptr, -1),
-    last_send_iob_size_(0),
-    last_send_iob_(nullptr),
-    pending_opt_cnt_(0),
-    sendlist_(32) {
+    pending_opt_cnt_(0) {
 }
 
 tls_transport::~tls_transport() {
-    __clear_send_pockets();
+    __uninstall_trackers();
 }
 
 void tls_transport::init(
@@ -61,7 +58,12 @@ error_code tls_transport::start(
         return error_invalid;
     }
 
-    if (!cbs.read_cb ||
+    if (__has_read_budget() && mode != read_mode_loop) {
+        pump_debug_log("read budget only works with read loop mode");
+        return error_invalid;
+    }
+
+    if ((!cbs.read_cb && !cbs.read_iob_cb) ||
         !cbs.stopped_cb ||
         !cbs.disconnected_cb) {
         pump_debug_log("callbacks invalid");
@@ -161,7 +163,7 @@ error_code tls_transport::async_read() {
         if (!__change_read_state(read_none, read_pending)) {
             pump_debug_log("tls transport's already reading by loop");
             ec = error_fault;
-        } else if (!__start_read_tracker()) {
+        } else if (!__resume_read()) {
             pump_debug_log("start tls transport's read tracker failed");
             ec = error_fault;
         }
@@ -172,13 +174,7 @@ error_code tls_transport::async_read() {
         } else if (!__change_read_state(read_none, read_pending)) {
             pump_debug_log("tls transport's already reading");
             ec = error_fault;
-        } else if (flow_->has_unread_data()) {
-            __post_channel_event(
-                shared_from_this(),
-                channel_event_read,
-                nullptr,
-                read_pid);
-        } else if (!__start_read_tracker()) {
+        } else if (!__resume_read()) {
             pump_debug_log("start tls transport's read tracker failed");
             ec = error_fault;
         }
@@ -231,7 +227,7 @@ error_code tls_transport::send(const char *b, int32_t size) {
 }
 
 error_code tls_transport::send(toolkit::io_buffer *iob) {
-    if (iob == nullptr || iob->size() == 0) {
+    if (iob == nullptr || iob->size() == 0 || iob->is_file()) {
         pump_debug_log("iob invalid");
         return error_invalid;
     }
@@ -261,141 +257,61 @@ error_code tls_transport::send(toolkit::io_buffer *iob) {
     return ec;
 }
 
-void tls_transport::on_channel_event(int32_t ev, void *arg) {
-    switch (ev) {
-    case channel_event_disconnected: {
-        base_transport::on_channel_event(ev, arg);
-        break;
+error_code tls_transport::send_file(int32_t fd, int64_t offset, int32_t size) {
+    if (fd < 0 || offset < 0 || size <= 0) {
+        pump_debug_log("file region invalid");
+        return error_invalid;
     }
-    case channel_event_buffer_sent: {
-        auto iob = (toolkit::io_buffer *)arg;
-        cbs_.sent_cb(iob);
-        iob->unrefer();
-        break;
+
+#if defined(PUMP_HAVE_WINSOCK)
+    pump_debug_log("tls transport send file not supported");
+    return error_disable;
+#else
+    if (!is_started()) {
+        pump_debug_log("tls transport not started");
+        return error_unstart;
     }
-    case channel_event_read: {
-        while (__is_state(state_starting, std::memory_order_relaxed)) {
-            // pump_debug_log("tls transport starting, wait");
-        }
 
-        bool disconnected = false;
-        char data[max_tcp_buffer_size];
-        auto size = flow_->read(data, sizeof(data));
-        if (size > 0) {
-            if (rmode_ == read_mode_once) {
-                // Change read state from read_pending to read_none.
-                if (!__change_read_state(read_pending, read_none)) {
-                    pump_debug_log("free tls transport's read state failed");
-                    disconnected = true;
-                }
-            } else if (!__start_read_tracker()) {
-                pump_debug_log("start tls transport's read tracker failed");
-                disconnected = true;
-            }
-            // Callback read data.
-            cbs_.read_cb(data, size);
-        } else if (size < 0) {
-            if (!__start_read_tracker()) {
-                pump_debug_log("start tls transport's read tracker failed");
-                disconnected = true;
-            }
-        } else {
-            pump_debug_log("tls transport read zero size and already disconnected");
-            disconnected = true;
+    auto ec = error_none;
+    pending_opt_cnt_.fetch_add(1, std::memory_order_relaxed);
+    do {
+        if (pump_unlikely(!__is_state(state_started))) {
+            pump_debug_log("tls transport is not started");
+            ec = error_unstart;
+            break;
         }
 
-        if (disconnected) {
-            __try_triggering_disconnected_callback();
+        auto iob = toolkit::io_buffer::create(size);
+        if (iob == nullptr) {
+            pump_debug_log("create iob object failed");
+            ec = error_fault;
+            break;
         }
-        break;
-    }
-    default:
-        pump_abort_with_log("unknown channel event %d", ev);
-    }
-}
-
-void tls_transport::on_read_event() {
-    // Wait transport starting end
-    while (__is_state(state_starting, std::memory_order_relaxed)) {
-        // pump_debug_log("tls transport starting, wait");
-    }
-
-    bool disconnected = false;
-    char data[max_tcp_buffer_size];
-    auto size = flow_->read(data, sizeof(data));
-    if (size > 0) {
-        if (rmode_ == read_mode_once) {
-            // Free read state.
-            if (!__change_read_state(read_pending, read_none)) {
-                pump_debug_log("free tls transport's read state failed");
-                disconnected = true;
+        auto b = iob->prepare_write(size);
+        int32_t read_size = 0;
+        while (read_size < size) {
+            auto ret = ::pread(fd, b + read_size, size - read_size, offset + read_size);
+            if (ret <= 0) {
+                break;
             }
-        } else {
-            if (!__start_read_tracker()) {
-                pump_debug_log("start tls transport's read tracker failed");
-                disconnected = true;
-            }
-        }
-        // Callback data.
-        cbs_.read_cb(data, size);
-    } else if (size < 0) {
-        if (!__start_read_tracker()) {
-            pump_debug_log("start tls transport's read tracker failed");
-            disconnected = true;
+            read_size += (int32_t)ret;
         }
-    } else {
-        pump_debug_log("tls transport read zero size and already disconnected");
-        disconnected = true;
-    }
-
-    if (disconnected) {
-        __try_triggering_disconnected_callback();
-    }
-}
-
-void tls_transport::on_send_event() {
-    if (pump_likely(last_send_iob_ != nullptr)) {
-        switch (flow_->send()) {
-        case error_none:
-            __handle_sent_buffer();
-            if (pending_send_size_.fetch_sub(last_send_iob_size_) > last_send_iob_size_) {
-                goto continue_send;
-            }
-            goto end;
-        case error_again:
-            if (!__start_send_tracker()) {
-                pump_debug_log("resume tls transport's send tracker failed");
-                goto disconnected;
-            }
-            return;
-        default:
-            pump_debug_log("tls transport's flow send data failed");
-            goto disconnected;
+        if (read_size < size) {
+            iob->unrefer();
+            pump_debug_log("read file region failed");
+            ec = error_invalid;
+            break;
         }
-    }
-
-continue_send:
-    switch (__send_once()) {
-    case error_none:
-        goto end;
-    case error_again:
-        if (!__start_send_tracker()) {
-            pump_debug_log("start tls transport's send tracker failed");
-            goto disconnected;
+        iob->commit_write(size);
+        if (!__async_send(iob)) {
+            pump_debug_log("tls transport async send failed");
+            ec = error_fault;
         }
-        return;
-    default:
-        pump_debug_log("tls transport send once failed");
-        goto disconnected;
-    }
-
-disconnected:
-    if (__try_triggering_disconnected_callback()) {
-        return;
-    }
+    } while (false);
+    pending_opt_cnt_.fetch_sub(1, std::memory_order_relaxed);
 
-end:
-    __trigger_stopped_callback();
+    return ec;
+#endif
 }
 
 void tls_transport::__shutdown_transport_flow(int32_t how) {
@@ -410,85 +326,14 @@ void tls_transport::__close_transport_flow() {
     }
 }
 
-bool tls_transport::__async_send(toolkit::io_buffer *iob) {
-    // Insert buffer to sendlist.
-    if (pump_unlikely(!sendlist_.push(iob))) {
-        pump_abort_with_log("push iob to queue failed");
-    }
-
-    // If there are no more buffers, we should try to get next send chance.
-    if (pending_send_size_.fetch_add(iob->size()) > 0) {
-        return true;
-    }
-
-    switch (__send_once()) {
-    case error_none:
-        return true;
-    case error_again:
-        if (!__start_send_tracker()) {
-            pump_debug_log("start tls transport's send tracker failed");
-            break;
-        }
-        return true;
-    default:
-        pump_debug_log("tls transport send once failed");
-        break;
-    }
-
-    if (__set_state(state_started, state_disconnecting)) {
-        __post_channel_event(shared_from_this(), channel_event_disconnected);
-    }
-
-    return false;
-}
-
-int32_t tls_transport::__send_once() {
-    // Pop next buffer from sendlist.
-    pump_assert(last_send_iob_ == nullptr);
-    if (pump_unlikely(!sendlist_.pop(last_send_iob_))) {
-        pump_abort_with_log("pop iob from queue failed");
-    }
-
-    // Save last send buffer data size.
-    last_send_iob_size_ = last_send_iob_->size();
-
-    auto ret = flow_->want_to_send(last_send_iob_);
-    if (pump_likely(ret == error_none)) {
-        // Handle sent buffer.
-        __handle_sent_buffer();
-        // Reduce pending send size.
-        if (pending_send_size_.fetch_sub(last_send_iob_size_) > last_send_iob_size_) {
-            return error_again;
-        }
-        return error_none;
-    } else if (ret == error_again) {
-        return error_again;
-    }
-
-    return error_fault;
-}
-
-void tls_transport::__handle_sent_buffer() {
-    if (cbs_.sent_cb) {
-        __post_channel_event(
-            shared_from_this(),
-            channel_event_buffer_sent,
-            last_send_iob_);
-    } else {
-        last_send_iob_->unrefer();
-    }
-    last_send_iob_ = nullptr;
-}
-
-void tls_transport::__clear_send_pockets() {
-    if (last_send_iob_) {
-        last_send_iob_->unrefer();
-    }
-
-    toolkit::io_buffer *iob;
-    while (sendlist_.pop(iob)) {
-        iob->unrefer();
+int32_t tls_transport::__read_from_flow(char *b, int32_t size) {
+    auto ret = flow_->read(b, size);
+    // Records generated on reading, such as key update response, are flushed
+    // at once instead of waiting for next sending.
+    if (pump_unlikely(flow_->has_pending_records())) {
+        __async_flush();
     }
+    return ret;
 }
 
 }  // namespace transport
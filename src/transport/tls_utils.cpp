@@ -16,17 +16,420 @@
 
 #include "pump/debug.h"
 #include "pump/memory.h"
+#include "pump/time/timestamp.h"
 #include "pump/transport/tls_utils.h"
 
 #if defined(PUMP_HAVE_TLS)
 extern "C" {
 #include <openssl/ssl.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#else
+#include <openssl/hmac.h>
+#endif
 }
 #endif
 
 namespace pump {
 namespace transport {
 
+tls_session_store::tls_session_store(int32_t max_count, int32_t max_key_count)
+  : max_shard_size_(max_count / shard_count),
+    max_key_size_(max_key_count) {
+    if (max_shard_size_ <= 0) {
+        max_shard_size_ = 1;
+    }
+    if (max_key_size_ <= 0) {
+        max_key_size_ = 1;
+    }
+}
+
+static void free_stored_session(void *session) {
+#if defined(PUMP_HAVE_TLS)
+    if (session != nullptr) {
+        SSL_SESSION_free((SSL_SESSION *)session);
+    }
+#endif
+}
+
+tls_session_store::~tls_session_store() {
+    for (auto &sd : shards_) {
+        for (auto &node : sd.nodes) {
+            for (auto session : node.second.sessions) {
+                free_stored_session(session);
+            }
+        }
+    }
+}
+
+void tls_session_store::put(const std::string &key, void *session) {
+    void *dropped = nullptr;
+    void *evicted = nullptr;
+    {
+        auto &sd = shards_[__get_shard(key)];
+        std::lock_guard<std::mutex> lock(sd.mx);
+        auto it = sd.nodes.find(key);
+        if (it != sd.nodes.end() &&
+            (int32_t)it->second.sessions.size() >= max_key_size_) {
+            dropped = it->second.sessions.front();
+            it->second.sessions.pop_front();
+            sd.count--;
+        } else if (sd.count >= max_shard_size_) {
+            auto oldest = sd.nodes.find(sd.keys.front());
+            evicted = oldest->second.sessions.front();
+            oldest->second.sessions.pop_front();
+            if (oldest->second.sessions.empty()) {
+                sd.nodes.erase(oldest);
+                sd.keys.pop_front();
+                // The oldest key maybe the key.
+                it = sd.nodes.find(key);
+            }
+            sd.count--;
+        }
+        if (it != sd.nodes.end()) {
+            auto &node = it->second;
+            node.sessions.push_back(session);
+            sd.keys.splice(sd.keys.end(), sd.keys, node.it);
+        } else {
+            sd.keys.push_back(key);
+            auto &node = sd.nodes[key];
+            node.sessions.push_back(session);
+            node.it = --sd.keys.end();
+        }
+        sd.count++;
+    }
+    // Free sessions out of the lock.
+    free_stored_session(dropped);
+    free_stored_session(evicted);
+}
+
+void *tls_session_store::get(const std::string &key) {
+    auto &sd = shards_[__get_shard(key)];
+    std::lock_guard<std::mutex> lock(sd.mx);
+    auto it = sd.nodes.find(key);
+    if (it == sd.nodes.end()) {
+        return nullptr;
+    }
+    auto session = it->second.sessions.back();
+#if defined(PUMP_HAVE_TLS)
+    SSL_SESSION_up_ref((SSL_SESSION *)session);
+#endif
+    return session;
+}
+
+void *tls_session_store::take(const std::string &key) {
+    auto &sd = shards_[__get_shard(key)];
+    std::lock_guard<std::mutex> lock(sd.mx);
+    auto it = sd.nodes.find(key);
+    if (it == sd.nodes.end()) {
+        return nullptr;
+    }
+    auto &node = it->second;
+    auto session = node.sessions.back();
+    node.sessions.pop_back();
+    if (node.sessions.empty()) {
+        sd.keys.erase(node.it);
+        sd.nodes.erase(it);
+    }
+    sd.count--;
+    return session;
+}
+
+void tls_session_store::remove(const std::string &key) {
+    std::deque<void *> sessions;
+    {
+        auto &sd = shards_[__get_shard(key)];
+        std::lock_guard<std::mutex> lock(sd.mx);
+        auto it = sd.nodes.find(key);
+        if (it == sd.nodes.end()) {
+            return;
+        }
+        sessions.swap(it->second.sessions);
+        sd.count -= (int32_t)sessions.size();
+        sd.keys.erase(it->second.it);
+        sd.nodes.erase(it);
+    }
+    for (auto session : sessions) {
+        free_stored_session(session);
+    }
+}
+
+int32_t tls_session_store::size() {
+    int32_t count = 0;
+    for (auto &sd : shards_) {
+        std::lock_guard<std::mutex> lock(sd.mx);
+        count += sd.count;
+    }
+    return count;
+}
+
+#if defined(PUMP_HAVE_TLS)
+// Ticket key name size
+const static int32_t ticket_key_name_size = 16;
+// Ticket key size of aes and hmac
+const static int32_t ticket_key_size = 32;
+
+struct ticket_key {
+    unsigned char name[ticket_key_name_size];
+    unsigned char aes_key[ticket_key_size];
+    unsigned char hmac_key[ticket_key_size];
+    uint64_t created_ns;
+};
+
+struct credentials_data {
+    credentials_data()
+      : tickets(false),
+        rotate_interval_ns(0),
+        key_count(0) {
+    }
+    // Server session cache
+    tls_session_store_sptr cache;
+    // Session tickets
+    bool tickets;
+    uint64_t rotate_interval_ns;
+    // Current and previous ticket keys
+    std::mutex keys_mx;
+    ticket_key keys[2];
+    int32_t key_count;
+};
+
+struct resumption_data {
+    // Client session store
+    tls_session_store_sptr store;
+    // Session key
+    std::string key;
+};
+
+static void free_credentials_data(
+    void *parent,
+    void *ptr,
+    CRYPTO_EX_DATA *ad,
+    int32_t idx,
+    long argl,
+    void *argp) {
+    if (ptr != nullptr) {
+        pump_object_destroy((credentials_data *)ptr);
+    }
+}
+
+static void free_resumption_data(
+    void *parent,
+    void *ptr,
+    CRYPTO_EX_DATA *ad,
+    int32_t idx,
+    long argl,
+    void *argp) {
+    if (ptr != nullptr) {
+        pump_object_destroy((resumption_data *)ptr);
+    }
+}
+
+static int32_t get_credentials_data_index() {
+    static int32_t index = SSL_CTX_get_ex_new_index(
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        free_credentials_data);
+    return index;
+}
+
+static int32_t get_resumption_data_index() {
+    static int32_t index = SSL_get_ex_new_index(
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        free_resumption_data);
+    return index;
+}
+
+static credentials_data *get_credentials_data(SSL_CTX *xcred, bool create) {
+    auto index = get_credentials_data_index();
+    auto data = (credentials_data *)SSL_CTX_get_ex_data(xcred, index);
+    if (data == nullptr && create) {
+        data = pump_object_create<credentials_data>();
+        if (data != nullptr && SSL_CTX_set_ex_data(xcred, index, data) != 1) {
+            pump_object_destroy(data);
+            data = nullptr;
+        }
+    }
+    return data;
+}
+
+static std::string get_session_id(SSL_SESSION *session) {
+    uint32_t len = 0;
+    auto id = SSL_SESSION_get_id(session, &len);
+    return std::string((const char *)id, len);
+}
+
+static int32_t on_server_new_session(SSL *ssl, SSL_SESSION *session) {
+    auto data = get_credentials_data(SSL_get_SSL_CTX(ssl), false);
+    if (data == nullptr || !data->cache) {
+        return 0;
+    }
+    // Cache takes the reference of the session.
+    data->cache->put(get_session_id(session), session);
+    return 1;
+}
+
+static SSL_SESSION *on_server_get_session(
+    SSL *ssl,
+    const unsigned char *id,
+    int32_t len,
+    int32_t *copy) {
+    auto data = get_credentials_data(SSL_get_SSL_CTX(ssl), false);
+    if (data == nullptr || !data->cache) {
+        return nullptr;
+    }
+    // Reference of the returned session is added by cache.
+    *copy = 0;
+    return (SSL_SESSION *)data->cache->get(std::string((const char *)id, len));
+}
+
+static void on_server_remove_session(SSL_CTX *xcred, SSL_SESSION *session) {
+    auto data = get_credentials_data(xcred, false);
+    if (data != nullptr && data->cache) {
+        data->cache->remove(get_session_id(session));
+    }
+}
+
+static int32_t on_client_new_session(SSL *ssl, SSL_SESSION *session) {
+    auto data = (resumption_data *)SSL_get_ex_data(ssl, get_resumption_data_index());
+    if (data == nullptr || SSL_SESSION_is_resumable(session) != 1) {
+        return 0;
+    }
+    // The session is still used by the connection, and it's marked as not
+    // resumable if the connection is freed without shutdown. So a duplicate of
+    // the session is stored.
+    auto dup = SSL_SESSION_dup(session);
+    if (dup != nullptr) {
+        data->store->put(data->key, dup);
+    }
+    return 0;
+}
+
+static void init_client_credentials(SSL_CTX *xcred) {
+    // New sessions are handed to session stores of sessions.
+    SSL_CTX_set_session_cache_mode(
+        xcred,
+        SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(xcred, on_client_new_session);
+}
+
+static bool new_ticket_key(ticket_key &key, uint64_t now) {
+    if (RAND_bytes(key.name, ticket_key_name_size) != 1 ||
+        RAND_bytes(key.aes_key, ticket_key_size) != 1 ||
+        RAND_bytes(key.hmac_key, ticket_key_size) != 1) {
+        return false;
+    }
+    key.created_ns = now;
+    return true;
+}
+
+// It returns 1 if the key is current key, 2 if the key is previous key which
+// should be renewed and 0 if not found.
+static int32_t get_ticket_key(
+    credentials_data *data,
+    const unsigned char *name,
+    ticket_key &key) {
+    std::lock_guard<std::mutex> lock(data->keys_mx);
+
+    // Rotate ticket key if it's expired.
+    auto now = time::get_clock_nanoseconds();
+    if (data->key_count == 0 ||
+        now - data->keys[0].created_ns >= data->rotate_interval_ns) {
+        ticket_key next;
+        if (!new_ticket_key(next, now)) {
+            pump_warn_log("new tls ticket key failed");
+            return 0;
+        }
+        data->keys[1] = data->keys[0];
+        data->keys[0] = next;
+        if (data->key_count < 2) {
+            data->key_count++;
+        }
+    }
+
+    if (name == nullptr) {
+        key = data->keys[0];
+        return 1;
+    }
+    for (int32_t i = 0; i < data->key_count; i++) {
+        if (memcmp(data->keys[i].name, name, ticket_key_name_size) == 0) {
+            key = data->keys[i];
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int32_t on_ticket_key(
+    SSL *ssl,
+    unsigned char *name,
+    unsigned char *iv,
+    EVP_CIPHER_CTX *cctx,
+    EVP_MAC_CTX *hctx,
+    int32_t enc) {
+#else
+static int32_t on_ticket_key(
+    SSL *ssl,
+    unsigned char *name,
+    unsigned char *iv,
+    EVP_CIPHER_CTX *cctx,
+    HMAC_CTX *hctx,
+    int32_t enc) {
+#endif
+    auto data = get_credentials_data(SSL_get_SSL_CTX(ssl), false);
+    if (data == nullptr || !data->tickets) {
+        return 0;
+    }
+
+    ticket_key key;
+    auto ret = get_ticket_key(data, enc == 1 ? nullptr : name, key);
+    if (ret == 0) {
+        // Decrypting ticket with unknown key falls back to full handshake.
+        return enc == 1 ? -1 : 0;
+    }
+
+    if (enc == 1) {
+        if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) {
+            return -1;
+        }
+        memcpy(name, key.name, ticket_key_name_size);
+        if (EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, key.aes_key, iv) != 1) {
+            return -1;
+        }
+    } else if (EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), nullptr, key.aes_key, iv) != 1) {
+        return -1;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM params[3];
+    params[0] = OSSL_PARAM_construct_octet_string(
+        OSSL_MAC_PARAM_KEY,
+        key.hmac_key,
+        ticket_key_size);
+    params[1] = OSSL_PARAM_construct_utf8_string(
+        OSSL_MAC_PARAM_DIGEST,
+        (char *)"SHA256",
+        0);
+    params[2] = OSSL_PARAM_construct_end();
+    if (EVP_MAC_CTX_set_params(hctx, params) != 1) {
+        return -1;
+    }
+#else
+    if (HMAC_Init_ex(hctx, key.hmac_key, ticket_key_size, EVP_sha256(), nullptr) != 1) {
+        return -1;
+    }
+#endif
+
+    return ret;
+}
+#endif
+
 tls_credentials new_client_tls_credentials() {
 #if defined(PUMP_HAVE_TLS)
     auto xcred = SSL_CTX_new(TLS_client_method());
@@ -35,6 +438,7 @@ tls_credentials new_client_tls_credentials() {
         return nullptr;
     }
     SSL_CTX_set_options(xcred, SSL_EXT_TLS1_3_ONLY);
+    init_client_credentials(xcred);
     return xcred;
 #else
     return nullptr;
@@ -46,7 +450,7 @@ tls_credentials load_tls_credentials_from_file(
     const std::string &cert,
     const std::string &key) {
 #if defined(PUMP_HAVE_TLS)
-    auto xcred = nullptr;
+    SSL_CTX *xcred = nullptr;
     if (client) {
         xcred = SSL_CTX_new(TLS_client_method());
     } else {
@@ -55,6 +459,9 @@ tls_credentials load_tls_credentials_from_file(
     if (xcred == nullptr) {
         return nullptr;
     }
+    if (client) {
+        init_client_credentials(xcred);
+    }
 
     if (SSL_CTX_use_certificate_file(xcred, cert.c_str(), SSL_FILETYPE_PEM) != 1 ||
         SSL_CTX_use_PrivateKey_file(xcred, key.c_str(), SSL_FILETYPE_PEM) != 1) {
@@ -72,7 +479,7 @@ tls_credentials load_tls_credentials_from_memory(
     const std::string &cert,
     const std::string &key) {
 #if defined(PUMP_HAVE_TLS)
-    SSL_CTX xcred = nullptr;
+    SSL_CTX *xcred = nullptr;
     if (client) {
         xcred = SSL_CTX_new(TLS_client_method());
     } else {
@@ -81,6 +488,9 @@ tls_credentials load_tls_credentials_from_memory(
     if (xcred == nullptr) {
         return nullptr;
     }
+    if (client) {
+        init_client_credentials(xcred);
+    }
 
     auto cert_bio = BIO_new_mem_buf((void *)cert.c_str(), -1);
     if (cert_bio == nullptr) {
@@ -134,18 +544,78 @@ void delete_tls_credentials(tls_credentials xcred) {
     }
 }
 
+bool set_tls_session_cache(tls_credentials xcred, int32_t max_count) {
+#if defined(PUMP_HAVE_TLS)
+    if (xcred == nullptr || max_count <= 0) {
+        return false;
+    }
+    auto ctx = (SSL_CTX *)xcred;
+    auto data = get_credentials_data(ctx, true);
+    if (data == nullptr) {
+        pump_warn_log("new tls credentials data failed");
+        return false;
+    }
+    // Server stores one session by one session id.
+    data->cache = tls_session_store::create(max_count, 1);
+    if (!data->cache) {
+        pump_warn_log("new tls session cache failed");
+        return false;
+    }
+
+    SSL_CTX_set_session_cache_mode(
+        ctx,
+        SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx, on_server_new_session);
+    SSL_CTX_sess_set_get_cb(ctx, on_server_get_session);
+    SSL_CTX_sess_set_remove_cb(ctx, on_server_remove_session);
+    if (!data->tickets) {
+        // Tls 1.3 resumes cached sessions by stateful tickets.
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool set_tls_session_tickets(tls_credentials xcred, uint64_t rotate_interval_ns) {
+#if defined(PUMP_HAVE_TLS)
+    if (xcred == nullptr || rotate_interval_ns == 0) {
+        return false;
+    }
+    auto ctx = (SSL_CTX *)xcred;
+    auto data = get_credentials_data(ctx, true);
+    if (data == nullptr) {
+        pump_warn_log("new tls credentials data failed");
+        return false;
+    }
+    data->tickets = true;
+    data->rotate_interval_ns = rotate_interval_ns;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, on_ticket_key);
+#else
+    SSL_CTX_set_tlsext_ticket_key_cb(ctx, on_ticket_key);
+#endif
+    SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+    return true;
+#else
+    return false;
+#endif
+}
+
 tls_session *new_tls_session(
     bool client,
     pump_socket fd,
     tls_credentials xcred) {
 #if defined(PUMP_HAVE_TLS)
-    auto session = object_create<tls_session>();
+    auto session = pump_object_create<tls_session>();
     if (session == nullptr) {
         return nullptr;
     }
     auto ssl_ctx = SSL_new((SSL_CTX *)xcred);
     if (ssl_ctx == nullptr) {
-        object_delete(session);
+        pump_object_destroy(session);
         return nullptr;
     }
     SSL_set_fd(ssl_ctx, (int32_t)fd);
@@ -163,6 +633,44 @@ tls_session *new_tls_session(
 #endif
 }
 
+tls_session *new_tls_memory_session(
+    bool client,
+    tls_credentials xcred) {
+#if defined(PUMP_HAVE_TLS)
+    auto session = pump_object_create<tls_session>();
+    if (session == nullptr) {
+        return nullptr;
+    }
+    auto ssl_ctx = SSL_new((SSL_CTX *)xcred);
+    if (ssl_ctx == nullptr) {
+        pump_object_destroy(session);
+        return nullptr;
+    }
+    auto read_bio = BIO_new(BIO_s_mem());
+    auto send_bio = BIO_new(BIO_s_mem());
+    if (read_bio == nullptr || send_bio == nullptr) {
+        BIO_free(read_bio);
+        BIO_free(send_bio);
+        SSL_free(ssl_ctx);
+        pump_object_destroy(session);
+        return nullptr;
+    }
+    // Ssl context takes ownership of the bios.
+    SSL_set_bio(ssl_ctx, read_bio, send_bio);
+    if (client) {
+        SSL_set_connect_state(ssl_ctx);
+    } else {
+        SSL_set_accept_state(ssl_ctx);
+    }
+
+    session->ssl_ctx = ssl_ctx;
+
+    return session;
+#else
+    return nullptr;
+#endif
+}
+
 void delete_tls_session(tls_session *session) {
     if (session == nullptr) {
         return;
@@ -170,7 +678,16 @@ void delete_tls_session(tls_session *session) {
 
     if (session->ssl_ctx != nullptr) {
 #if defined(PUMP_HAVE_TLS)
-        SSL_free((SSL *)session->ssl_ctx);
+        auto ssl = (SSL *)session->ssl_ctx;
+        // Close notify isn't sent by memory sessions, and session freed
+        // without shutdown is removed from session cache. Sessions of failed
+        // connections are removed when errors occur, so shutdown quietly to
+        // keep sessions of finished connections resumable.
+        if (SSL_is_init_finished(ssl)) {
+            SSL_set_quiet_shutdown(ssl, 1);
+            SSL_shutdown(ssl);
+        }
+        SSL_free(ssl);
 #endif
     }
     pump_object_destroy(session);
@@ -178,14 +695,22 @@ void delete_tls_session(tls_session *session) {
 
 tls_handshake_phase tls_handshake(tls_session *session) {
 #if defined(PUMP_HAVE_TLS)
-    auto ret = SSL_do_handshake((SSL *)session->ssl_ctx);
-    auto ec = SSL_get_error((SSL *)session->ssl_ctx, ret);
+    auto ssl = (SSL *)session->ssl_ctx;
+    auto ret = SSL_do_handshake(ssl);
+    auto ec = SSL_get_error(ssl, ret);
     if (ec != SSL_ERROR_SSL) {
         if (ec == SSL_ERROR_NONE) {
+            // Tls 1.3 server doesn't issue ticket on resumption by default, but
+            // tickets are used once. So a new ticket is sent with next writing
+            // to let client resume again.
+            if (SSL_is_server(ssl) && SSL_session_reused(ssl) &&
+                SSL_version(ssl) == TLS1_3_VERSION) {
+                SSL_new_session_ticket(ssl);
+            }
             return tls_handshake_ok;
-        } else if (SSL_want_write((SSL *)session->ssl_ctx)) {
+        } else if (SSL_want_write(ssl)) {
             return tls_handshake_send;
-        } else if (SSL_want_read((SSL *)session->ssl_ctx)) {
+        } else if (SSL_want_read(ssl)) {
             return tls_handshake_read;
         }
     }
@@ -194,11 +719,57 @@ tls_handshake_phase tls_handshake(tls_session *session) {
     return tls_handshake_error;
 }
 
+bool tls_resume_session(
+    tls_session *session,
+    tls_session_store_sptr &store,
+    const std::string &key) {
+#if defined(PUMP_HAVE_TLS)
+    if (!store) {
+        return false;
+    }
+    auto ssl = (SSL *)session->ssl_ctx;
+
+    auto data = pump_object_create<resumption_data>();
+    if (data == nullptr) {
+        pump_warn_log("new tls resumption data failed");
+        return false;
+    }
+    data->store = store;
+    data->key = key;
+    if (SSL_set_ex_data(ssl, get_resumption_data_index(), data) != 1) {
+        pump_object_destroy(data);
+        return false;
+    }
+
+    // Tickets should be used once, so stored session is taken.
+    auto stored = (SSL_SESSION *)store->take(key);
+    if (stored != nullptr) {
+        SSL_set_session(ssl, stored);
+        SSL_SESSION_free(stored);
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool tls_is_session_resumed(tls_session *session) {
+#if defined(PUMP_HAVE_TLS)
+    return SSL_session_reused((SSL *)session->ssl_ctx) == 1;
+#else
+    return false;
+#endif
+}
+
 bool tls_has_unread_data(tls_session *session) {
 #if defined(PUMP_HAVE_TLS)
     if (SSL_has_pending((SSL *)session->ssl_ctx) == 1) {
         return true;
     }
+    // Ciphertext fed to memory session maybe not processed yet.
+    if (BIO_ctrl_pending(SSL_get_rbio((SSL *)session->ssl_ctx)) > 0) {
+        return true;
+    }
 #endif
     return false;
 }
@@ -236,5 +807,49 @@ int32_t tls_send(
     return 0;
 }
 
+void tls_shutdown(tls_session *session) {
+#if defined(PUMP_HAVE_TLS)
+    auto ssl = (SSL *)session->ssl_ctx;
+    if (SSL_is_init_finished(ssl) &&
+        (SSL_get_shutdown(ssl) & SSL_SENT_SHUTDOWN) == 0) {
+        SSL_shutdown(ssl);
+    }
+#endif
+}
+
+int32_t tls_feed_read_data(
+    tls_session *session,
+    const char *b,
+    int32_t size) {
+#if defined(PUMP_HAVE_TLS)
+    auto ret = BIO_write(SSL_get_rbio((SSL *)session->ssl_ctx), b, size);
+    if (pump_likely(ret > 0)) {
+        return ret;
+    }
+#endif
+    return 0;
+}
+
+int32_t tls_get_send_data_size(tls_session *session) {
+#if defined(PUMP_HAVE_TLS)
+    return (int32_t)BIO_ctrl_pending(SSL_get_wbio((SSL *)session->ssl_ctx));
+#else
+    return 0;
+#endif
+}
+
+int32_t tls_take_send_data(
+    tls_session *session,
+    char *b,
+    int32_t size) {
+#if defined(PUMP_HAVE_TLS)
+    auto ret = BIO_read(SSL_get_wbio((SSL *)session->ssl_ctx), b, size);
+    if (pump_likely(ret > 0)) {
+        return ret;
+    }
+#endif
+    return 0;
+}
+
 }  // namespace transport
 }  // namespace pump
\ No newline at end of file
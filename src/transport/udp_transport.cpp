@@ -20,8 +20,33 @@ namespace pump {
 namespace transport {
 
 udp_transport::udp_transport(const address &bind_address) noexcept
-  : base_transport(transport_udp, nullptr, -1) {
+  : base_transport(transport_udp, nullptr, -1),
+    read_buffer_(nullptr),
+    segment_size_(0),
+    gso_(false),
+    gro_(false),
+    send_queue_max_(0),
+    send_queue_policy_(udp_send_drop_newest) {
     local_address_ = bind_address;
+    memset(&send_queue_stats_, 0, sizeof(send_queue_stats_));
+}
+
+udp_transport::~udp_transport() {
+    __uninstall_trackers();
+
+    if (read_buffer_ != nullptr) {
+        pump_free(read_buffer_);
+    }
+    for (auto &item : send_queue_) {
+        item.first->unrefer();
+    }
+}
+
+udp_send_queue_stats udp_transport::get_send_queue_stats() {
+    std::lock_guard<std::mutex> lock(send_queue_mx_);
+    auto stats = send_queue_stats_;
+    stats.pending = (int32_t)send_queue_.size();
+    return stats;
 }
 
 error_code udp_transport::start(
@@ -39,7 +64,7 @@ error_code udp_transport::start(
         return error_invalid;
     }
 
-    if (!cbs.read_from_cb || !cbs.stopped_cb) {
+    if ((!cbs.read_from_cb && !cbs.read_from_batch_cb) || !cbs.stopped_cb) {
         pump_debug_log("callbacks invalid");
         return error_invalid;
     }
@@ -61,10 +86,40 @@ error_code udp_transport::start(
             break;
         }
 
+        if (segment_size_ > 0) {
+            if (!(gso_ = flow_->enable_gso(segment_size_))) {
+                pump_debug_log("enable udp segment offload failed");
+            }
+            if (!(gro_ = flow_->enable_gro())) {
+                pump_debug_log("enable udp receive offload failed");
+            }
+        }
+
+        if (cbs_.read_from_batch_cb) {
+            read_batch_.resize(net::max_batch_count);
+        }
+        if (gro_ || cbs_.read_from_batch_cb) {
+            // Gro reading needs a buffer for coalesced datagrams.
+            auto size = gro_ ? max_udp_gro_buffer_size
+                             : net::max_batch_count * max_udp_buffer_size;
+            read_buffer_ = (char *)pump_malloc(size);
+            if (read_buffer_ == nullptr) {
+                pump_warn_log("new udp transport's read buffer failed");
+                break;
+            }
+        }
+
         if (!__install_read_tracker()) {
             pump_debug_log("install udp transport's read tracker failed");
             break;
         }
+        // Send tracker drains the send queue, which keeps remaining segments of
+        // buffers partially sent as well.
+        if ((send_queue_max_ > 0 || segment_size_ > 0) &&
+            !__install_send_tracker()) {
+            pump_debug_log("install udp transport's send tracker failed");
+            break;
+        }
 
         if (__set_state(state_starting, state_started)) {
             return error_none;
@@ -85,6 +140,11 @@ void udp_transport::stop() {
             __shutdown_transport_flow(SHUT_RDWR);
             // Post channel event.
             __post_channel_event(shared_from_this(), channel_event_disconnected);
+            // Wake up blocked sendings.
+            if (send_queue_max_ > 0) {
+                std::lock_guard<std::mutex> lock(send_queue_mx_);
+                send_queue_cond_.notify_all();
+            }
             return;
         }
     }
@@ -138,7 +198,13 @@ error_code udp_transport::send(
         return error_unstart;
     }
 
-    if (flow_->send(b, size, address) < 0) {
+    if (send_queue_max_ > 0) {
+        return __queue_send(b, size, address);
+    } else if (segment_size_ > 0 && size > segment_size_) {
+        return __send_segments(b, size, address);
+    }
+
+    if (__send_until_again(b, size, address) < size) {
         pump_debug_log("udp transport's flow send failed");
         return error_again;
     }
@@ -149,7 +215,7 @@ error_code udp_transport::send(
 error_code udp_transport::send(
     toolkit::io_buffer *iob,
     const address &address) {
-    if (iob == nullptr || iob->size() <= 0) {
+    if (iob == nullptr || iob->size() <= 0 || iob->is_file()) {
         pump_debug_log("io buffer invalid");
         return error_invalid;
     }
@@ -159,7 +225,18 @@ error_code udp_transport::send(
         return error_unstart;
     }
 
-    if (flow_->send(iob->data(), iob->size(), address) < 0) {
+    auto size = (int32_t)iob->size();
+    if (send_queue_max_ > 0) {
+        auto ec = __queue_send(iob->data(), size, address);
+        if (ec != error_none) {
+            return ec;
+        }
+    } else if (segment_size_ > 0 && size > segment_size_) {
+        auto ec = __send_segments(iob->data(), size, address);
+        if (ec != error_none) {
+            return ec;
+        }
+    } else if (__send_until_again(iob->data(), size, address) < size) {
         pump_debug_log("udp transport's flow send failed");
         return error_again;
     }
@@ -169,12 +246,82 @@ error_code udp_transport::send(
     return error_none;
 }
 
+error_code udp_transport::send_batch(
+    const udp_datagram *dgs,
+    int32_t count,
+    int32_t *sent_count) {
+    if (dgs == nullptr || count <= 0) {
+        pump_debug_log("datagrams invalid");
+        return error_invalid;
+    }
+
+    if (!is_started()) {
+        pump_debug_log("udp transport not started");
+        return error_unstart;
+    }
+
+    std::unique_lock<std::mutex> lock(send_queue_mx_, std::defer_lock);
+    if (send_queue_max_ > 0) {
+        lock.lock();
+    }
+
+    // Datagrams are sent after queued datagrams.
+    int32_t sent = 0;
+    bool failed = false;
+    while (sent < count && send_queue_.empty()) {
+        auto ret = flow_->send_batch(dgs + sent, count - sent);
+        if (ret > 0) {
+            sent += ret;
+        } else {
+            // Failed datagram is not sent, and sent count points to it.
+            failed = ret == 0;
+            break;
+        }
+    }
+    error_code ec = error_none;
+    if (!failed && send_queue_max_ > 0) {
+        // Datagram dropped by drop newest policy is not sent, and sent count
+        // points to it.
+        for (; sent < count; sent++) {
+            auto &dg = dgs[sent];
+            ec = __push_send_queue(lock, dg.data, dg.size, dg.addr);
+            if (ec != error_none) {
+                break;
+            }
+        }
+    }
+    if (sent_count != nullptr) {
+        *sent_count = sent;
+    }
+
+    if (failed) {
+        pump_debug_log("udp transport's flow send batch failed");
+        return error_fault;
+    } else if (ec != error_none && ec != error_again) {
+        pump_debug_log("push udp transport's send queue failed");
+        return ec;
+    } else if (sent < count) {
+        pump_debug_log("udp transport's flow send batch failed");
+        return error_again;
+    }
+
+    return error_none;
+}
+
 void udp_transport::on_read_event() {
     // Wait transport starting end.
     while (__is_state(state_starting, std::memory_order_relaxed)) {
         pump_debug_log("udp transport starting, wait");
     }
 
+    if (gro_) {
+        __read_gro();
+        return;
+    } else if (cbs_.read_from_batch_cb) {
+        __read_batch();
+        return;
+    }
+
     address remote_addr;
     char data[max_udp_buffer_size];
     int32_t size = flow_->read_from(data, sizeof(data), &remote_addr);
@@ -194,6 +341,235 @@ void udp_transport::on_read_event() {
     }
 }
 
+void udp_transport::on_send_event() {
+    std::lock_guard<std::mutex> lock(send_queue_mx_);
+    while (!send_queue_.empty()) {
+        auto &item = send_queue_.front();
+        auto iob = item.first;
+        auto size = (int32_t)iob->size();
+        auto sent = __send_until_again(iob->data(), size, item.second);
+        if (sent < size) {
+            // Remaining data is sent when socket buffer is writable again.
+            iob->shift(sent);
+            if (!__start_send_tracker()) {
+                pump_debug_log("start udp transport's send tracker failed");
+            }
+            break;
+        }
+        iob->unrefer();
+        send_queue_.pop_front();
+        send_queue_stats_.sent++;
+    }
+    send_queue_cond_.notify_all();
+}
+
+void udp_transport::__read_batch() {
+    int32_t count = flow_->read_from_batch(
+        read_buffer_,
+        max_udp_buffer_size,
+        read_batch_.data(),
+        net::max_batch_count);
+    if (count > 0) {
+        if (rmode_ == read_mode_once) {
+            // Free read state.
+            if (!__change_read_state(read_pending, read_none)) {
+                pump_debug_log("free udp transport's read state failed");
+            }
+        }
+        // Callback read datagrams.
+        cbs_.read_from_batch_cb(read_batch_.data(), count);
+        // Batch read buffer is reused by next reading, so read tracker is
+        // restarted after callback.
+        if (rmode_ == read_mode_once) {
+            return;
+        }
+    }
+    if (!__start_read_tracker()) {
+        pump_debug_log("start udp transport's read tracker failed");
+    }
+}
+
+void udp_transport::__read_gro() {
+    address remote_addr;
+    int32_t segment_size = 0;
+    int32_t size = flow_->read_from_gro(
+        read_buffer_,
+        max_udp_gro_buffer_size,
+        &remote_addr,
+        &segment_size);
+    if (size > 0) {
+        if (rmode_ == read_mode_once) {
+            // Free read state.
+            if (!__change_read_state(read_pending, read_none)) {
+                pump_debug_log("free udp transport's read state failed");
+            }
+        }
+        // Callback datagrams split from coalesced data.
+        __callback_read_segments(remote_addr, read_buffer_, size, segment_size);
+        // Read buffer is reused by next reading, so read tracker is restarted
+        // after callback.
+        if (rmode_ == read_mode_once) {
+            return;
+        }
+    }
+    if (!__start_read_tracker()) {
+        pump_debug_log("start udp transport's read tracker failed");
+    }
+}
+
+void udp_transport::__callback_read_segments(
+    const address &from,
+    const char *b,
+    int32_t size,
+    int32_t segment_size) {
+    if (segment_size <= 0 || segment_size > size) {
+        segment_size = size;
+    }
+
+    if (!cbs_.read_from_batch_cb) {
+        for (int32_t offset = 0; offset < size; offset += segment_size) {
+            auto len = size - offset < segment_size ? size - offset : segment_size;
+            cbs_.read_from_cb(from, b + offset, len);
+        }
+        return;
+    }
+
+    int32_t count = 0;
+    for (int32_t offset = 0; offset < size; offset += segment_size) {
+        auto &dg = read_batch_[count++];
+        dg.addr = from;
+        dg.data = b + offset;
+        dg.size = size - offset < segment_size ? size - offset : segment_size;
+        if (count == net::max_batch_count) {
+            cbs_.read_from_batch_cb(read_batch_.data(), count);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        cbs_.read_from_batch_cb(read_batch_.data(), count);
+    }
+}
+
+int32_t udp_transport::__send_until_again(
+    const char *b,
+    int32_t size,
+    const address &address) {
+    // Kernel segments limited datagrams in one sending, else datagrams are
+    // sent one by one.
+    int32_t max_size = size;
+    if (segment_size_ > 0 && size > segment_size_) {
+        max_size = segment_size_;
+        if (gso_) {
+            auto segments = max_udp_gso_size / segment_size_;
+            if (segments > max_udp_gso_segments) {
+                segments = max_udp_gso_segments;
+            }
+            max_size = segment_size_ * segments;
+        }
+    }
+
+    // Failed datagram is dropped.
+    int32_t sent = 0;
+    while (sent < size) {
+        auto len = size - sent < max_size ? size - sent : max_size;
+        if (flow_->send(b + sent, len, address) < 0) {
+            break;
+        }
+        sent += len;
+    }
+    return sent;
+}
+
+error_code udp_transport::__send_segments(
+    const char *b,
+    int32_t size,
+    const address &address) {
+    std::unique_lock<std::mutex> lock(send_queue_mx_);
+    // Remaining segments of last buffer are sent before new buffers.
+    if (!send_queue_.empty()) {
+        return error_again;
+    }
+    auto sent = __send_until_again(b, size, address);
+    if (sent == 0) {
+        return error_again;
+    } else if (sent == size) {
+        return error_none;
+    }
+
+    // Sent segments can't be taken back, so remaining segments are sent by send
+    // tracker instead of retrying the whole buffer.
+    return __append_send_queue(b + sent, size - sent, address);
+}
+
+error_code udp_transport::__queue_send(
+    const char *b,
+    int32_t size,
+    const address &address) {
+    std::unique_lock<std::mutex> lock(send_queue_mx_);
+    if (send_queue_.empty()) {
+        auto sent = __send_until_again(b, size, address);
+        if (sent == size) {
+            return error_none;
+        } else if (sent > 0) {
+            // Remaining segments of partially sent data are queued beyond the
+            // max count, as sent segments can't be dropped or sent again.
+            return __append_send_queue(b + sent, size - sent, address);
+        }
+    }
+    return __push_send_queue(lock, b, size, address);
+}
+
+error_code udp_transport::__push_send_queue(
+    std::unique_lock<std::mutex> &lock,
+    const char *b,
+    int32_t size,
+    const address &address) {
+    if ((int32_t)send_queue_.size() >= send_queue_max_) {
+        if (send_queue_policy_ == udp_send_drop_newest) {
+            send_queue_stats_.dropped++;
+            return error_again;
+        } else if (send_queue_policy_ == udp_send_drop_oldest) {
+            send_queue_.front().first->unrefer();
+            send_queue_.pop_front();
+            send_queue_stats_.dropped++;
+        } else {
+            send_queue_stats_.blocked++;
+            send_queue_cond_.wait(lock, [&]() {
+                return (int32_t)send_queue_.size() < send_queue_max_ ||
+                       !__is_state(state_started);
+            });
+            if (!__is_state(state_started)) {
+                pump_debug_log("udp transport stopped when blocked");
+                return error_unstart;
+            }
+        }
+    }
+
+    return __append_send_queue(b, size, address);
+}
+
+error_code udp_transport::__append_send_queue(
+    const char *b,
+    int32_t size,
+    const address &address) {
+    auto iob = toolkit::io_buffer::create_by_copy(b, size);
+    if (iob == nullptr) {
+        pump_warn_log("new udp send queue iob object failed");
+        return error_fault;
+    }
+    send_queue_.push_back(std::make_pair(iob, address));
+    send_queue_stats_.queued++;
+
+    // Send tracker is started when the queue becomes not empty, and the queue
+    // is drained by send event.
+    if (send_queue_.size() == 1 && !__start_send_tracker()) {
+        pump_debug_log("start udp transport's send tracker failed");
+        return error_fault;
+    }
+
+    return error_none;
+}
+
 bool udp_transport::__open_transport_flow() {
     // Init udp transport flow.
     flow_.reset(pump_object_create<flow::flow_udp>(), pump_object_destroy<flow::flow_udp>);
@@ -13,6 +13,10 @@ using namespace pump::proto;
 
 void start_http_client(pump::service *sv, const std::vector<std::string> &urls);
 
-void start_http_server(pump::service *sv, const std::string &ip, int port);
+void start_http_server(
+    pump::service *sv,
+    const std::string &ip,
+    int port,
+    const std::string &file);
 
 #endif
\ No newline at end of file
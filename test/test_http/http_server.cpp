@@ -1,8 +1,27 @@
 #include "http.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// Static file served by sendfile
+static int32_t static_file_fd = -1;
+static int32_t static_file_size = 0;
+
 void on_new_request(http::connection_wptr &wconn, http::request_sptr &&req) {
     static std::string data = "hello world 1!!!";
 
+    if (static_file_fd >= 0) {
+        http::response res;
+        res.set_status_code(200);
+        res.set_http_version(http::VERSION_11);
+        res.set_head("Content-Type", "application/octet-stream");
+
+        auto conn = wconn.lock();
+        conn->send_file(&res, static_file_fd, 0, static_file_size);
+        return;
+    }
+
     http::response res;
     res.set_status_code(200);
     res.set_http_version(http::VERSION_11);
@@ -23,7 +42,21 @@ void on_stopped() {
     printf("http server stopped\n");
 }
 
-void start_http_server(pump::service *sv, const std::string &ip, int port) {
+void start_http_server(
+    pump::service *sv,
+    const std::string &ip,
+    int port,
+    const std::string &file) {
+    if (!file.empty()) {
+        struct stat st;
+        static_file_fd = ::open(file.c_str(), O_RDONLY);
+        if (static_file_fd < 0 || ::fstat(static_file_fd, &st) != 0) {
+            printf("open static file error\n");
+            return;
+        }
+        static_file_size = (int32_t)st.st_size;
+    }
+
     pump::transport::address bind_address(ip, port);
 
     http::server_callbacks cbs;
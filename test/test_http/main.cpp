@@ -15,7 +15,9 @@ int main(int argc, const char **argv) {
 
         std::string ip = argv[2];
         int port = atoi(argv[3]);
-        start_http_server(sv, ip, port);
+        // Optional static file is served by sendfile.
+        std::string file = argc > 4 ? argv[4] : "";
+        start_http_server(sv, ip, port, file);
     } else if (type == "c") {
         if (argc < 3)
             return -1;
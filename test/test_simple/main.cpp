@@ -5,6 +5,7 @@
 #include <mutex>
 #include <new>
 
+#include <pump/service.h>
 #include <pump/time/timestamp.h>
 #include <pump/toolkit/features.h>
 #include <pump/toolkit/freelock_m2m_queue.h>
@@ -254,6 +255,61 @@ int test2(int loop) {
     return 0;
 }
 
+int test3_run(int loop, int worker_count) {
+    service sv(false, 0, worker_count);
+    sv.start();
+
+    std::atomic_int count(0);
+    auto task = [&]() { count.fetch_add(1, std::memory_order_relaxed); };
+
+    // Post tasks from outside of task workers.
+    auto beg = time::get_clock_microseconds();
+    for (int i = 0; i < loop; i++) {
+        sv.post(task);
+    }
+    while (count.load() < loop) {
+    }
+    auto end = time::get_clock_microseconds();
+    printf("service with %d task workers run %d posted tasks use %dus\n",
+           worker_count,
+           loop,
+           int(end - beg));
+
+    // Post tasks from task workers, the tasks are pushed to worker local
+    // deques and can be stolen by other workers.
+    count.store(0);
+    int fanout = 1000;
+    beg = time::get_clock_microseconds();
+    for (int i = 0; i < loop / fanout; i++) {
+        sv.post([&]() {
+            for (int ii = 0; ii < fanout; ii++) {
+                sv.post(task);
+            }
+        });
+    }
+    while (count.load() < loop / fanout * fanout) {
+    }
+    end = time::get_clock_microseconds();
+    printf("service with %d task workers run %d fanout tasks use %dus\n",
+           worker_count,
+           loop / fanout * fanout,
+           int(end - beg));
+
+    sv.stop();
+    sv.wait_stopped();
+
+    return 0;
+}
+
+int test3(int loop) {
+    int worker_count = (int)std::thread::hardware_concurrency();
+    test3_run(loop, 1);
+    if (worker_count > 1) {
+        test3_run(loop, worker_count);
+    }
+    return 0;
+}
+
 int main(int argc, const char **argv) {
     int i = 0;
     defer_call_begin
@@ -275,6 +331,9 @@ int main(int argc, const char **argv) {
     if (test_case == "test2") {
         test2(loop);
     }
+    if (test_case == "test3") {
+        test3(loop);
+    }
 
     return 0;
 }
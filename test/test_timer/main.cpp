@@ -81,7 +81,7 @@ int main(int argc, const char **argv) {
     sv->start_timer(t);
     //t.reset();
 
-    Sleep(5000);
+    std::this_thread::sleep_for(std::chrono::seconds(5));
 
     //printf("begin %llums\n", pump::time::get_clock_milliseconds());
     auto b_us = pump::time::get_clock_microseconds();
@@ -4,6 +4,209 @@
 #include "tls_transport_test.h"
 #include "udp_transport_test.h"
 
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+service *bench_sv = nullptr;
+
+// Benchmark seconds before stopping send loops
+static int32_t bench_seconds = 5;
+// Max seconds waiting for data in flight delivered
+static const int32_t bench_drain_seconds = 5;
+
+static std::atomic_bool bench_running(false);
+static int32_t bench_failed_count = 0;
+
+static std::mutex bench_mx;
+static std::vector<std::thread> bench_send_threads;
+static std::vector<base_acceptor_sptr> bench_acceptors;
+static std::vector<base_dialer_sptr> bench_dialers;
+static std::vector<base_transport_sptr> bench_transports;
+
+void set_bench_seconds(int32_t seconds) {
+    if (seconds > 0) {
+        bench_seconds = seconds;
+    }
+}
+
+bool is_bench_running() {
+    return bench_running.load(std::memory_order_relaxed);
+}
+
+int32_t get_bench_failed_count() {
+    return bench_failed_count;
+}
+
+void start_bench_service() {
+    bench_sv = new service;
+    bench_sv->start();
+    bench_running.store(true);
+}
+
+static bool start_bench_pair(
+    base_acceptor_sptr acceptor,
+    const std::vector<base_dialer_sptr> &dialers,
+    const bench_transport_callback &accepted,
+    const bench_transport_callback &dialed) {
+    pump::acceptor_callbacks acbs;
+    acbs.accepted_cb = accepted;
+    acbs.stopped_cb = []() {};
+    if (acceptor->start(bench_sv, acbs) != error_none) {
+        printf("bench acceptor start error\n");
+        return false;
+    }
+    bench_acceptors.push_back(acceptor);
+
+    pump::dialer_callbacks dcbs;
+    dcbs.dialed_cb = [dialed](base_transport_sptr &transp, bool succ) {
+        if (!succ) {
+            printf("bench dialed error\n");
+            return;
+        }
+        dialed(transp);
+    };
+    dcbs.timeouted_cb = []() { printf("bench dial timeout\n"); };
+    dcbs.stopped_cb = []() {};
+    for (auto &dialer : dialers) {
+        if (dialer->start(bench_sv, dcbs) != error_none) {
+            printf("bench dialer start error\n");
+            return false;
+        }
+        bench_dialers.push_back(dialer);
+    }
+
+    return true;
+}
+
+bool start_bench_tcp(
+    const std::string &ip,
+    uint16_t port,
+    int32_t conn_count,
+    const bench_transport_callback &accepted,
+    const bench_transport_callback &dialed) {
+    address listen_address(ip, port);
+    address bind_address("0.0.0.0", 0);
+    std::vector<base_dialer_sptr> dialers;
+    for (int32_t i = 0; i < conn_count; i++) {
+        dialers.push_back(tcp_dialer::create(bind_address, listen_address, 0));
+    }
+    return start_bench_pair(
+        tcp_acceptor::create(listen_address),
+        dialers,
+        accepted,
+        dialed);
+}
+
+bool start_bench_tls(
+    const std::string &ip,
+    uint16_t port,
+    bool memory_bio,
+    const bench_transport_callback &accepted,
+    const bench_transport_callback &dialed) {
+    address listen_address(ip, port);
+    tls_credentials xcred = load_tls_credentials_from_memory(false, cert, key);
+    tls_acceptor_sptr acceptor = tls_acceptor::create(xcred, listen_address);
+    acceptor->set_memory_bio(memory_bio);
+
+    address bind_address("0.0.0.0", 0);
+    tls_dialer_sptr dialer = tls_dialer::create(bind_address, listen_address, 0);
+    dialer->set_memory_bio(memory_bio);
+
+    return start_bench_pair(acceptor, {dialer}, accepted, dialed);
+}
+
+bool start_bench_transport(
+    base_transport_sptr transp,
+    transport_callbacks &cbs) {
+    // Transports only sending discard read data.
+    if (!cbs.read_cb && !cbs.read_iob_cb &&
+        !cbs.read_from_cb && !cbs.read_from_batch_cb) {
+        cbs.read_cb = [](const char *, int32_t) {};
+    }
+    if (!cbs.stopped_cb) {
+        cbs.stopped_cb = []() {};
+    }
+    if (!cbs.disconnected_cb) {
+        cbs.disconnected_cb = []() {};
+    }
+
+    if (transp->start(bench_sv, read_mode_loop, cbs) != error_none) {
+        printf("bench transport start error\n");
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(bench_mx);
+        bench_transports.push_back(transp);
+    }
+    transp->async_read();
+
+    return true;
+}
+
+void start_bench_send_loop(const bench_send_function &send) {
+    std::lock_guard<std::mutex> lock(bench_mx);
+    bench_send_threads.emplace_back([send]() {
+        while (is_bench_running() && send()) {
+        }
+    });
+}
+
+static void stop_bench() {
+    std::vector<base_transport_sptr> transports;
+    {
+        std::lock_guard<std::mutex> lock(bench_mx);
+        transports.swap(bench_transports);
+    }
+    for (auto &transp : transports) {
+        transp->force_stop();
+    }
+    for (auto &acceptor : bench_acceptors) {
+        acceptor->stop();
+    }
+    bench_sv->stop();
+    bench_sv->wait_stopped();
+}
+
+bool run_bench(
+    const std::string &name,
+    const bench_report_function &report,
+    const bench_check_function &check) {
+    for (int32_t i = 0; i < bench_seconds; i++) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        report();
+    }
+
+    // Stop send loops, then check until data in flight is delivered.
+    bench_running.store(false);
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(bench_mx);
+        threads.swap(bench_send_threads);
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(bench_drain_seconds);
+    const char *failure = check();
+    while (failure != nullptr && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        failure = check();
+    }
+    if (failure == nullptr) {
+        printf("%s test passed\n", name.c_str());
+    } else {
+        printf("%s test failed: %s\n", name.c_str(), failure);
+        bench_failed_count++;
+    }
+
+    stop_bench();
+
+    return failure == nullptr;
+}
+
 int main(int argc, const char **argv) {
     pump::init();
 
@@ -20,6 +223,11 @@ int main(int argc, const char **argv) {
         conn_count = atoi(argv[5]);
     }
 
+    // Benchmarks run for seconds of the last argument.
+    if (argc > 6) {
+        set_bench_seconds(atoi(argv[6]));
+    }
+
     if (tag == "tcp") {
         printf("start tcp test\n");
 
@@ -37,6 +245,82 @@ int main(int argc, const char **argv) {
         client.join();
     }
 
+    if (tag == "churn") {
+        printf("start tcp churn test\n");
+        start_tcp_churn(ip, port, conn_count);
+    }
+
+    if (tag == "connrate") {
+        printf("start tcp conn rate test\n");
+        if (tp == "s") {
+            // Connection count argument is used as accept budget of server.
+            start_tcp_conn_rate_server(ip, port, conn_count);
+        } else if (tp == "c") {
+            start_tcp_conn_rate_client(ip, port, conn_count);
+        }
+    }
+
+    if (tag == "singlereg") {
+        printf("start tcp single registration test\n");
+        start_tcp_single_reg(ip, port);
+    }
+
+    if (tag == "sharded") {
+        printf("start sharded acceptor test\n");
+        // Type is tcp or tls, connection count argument is dialed count.
+        start_sharded_acceptor(ip, port, tp == "tls", argc > 5 ? conn_count : 64);
+    }
+
+    if (tag == "smallsend") {
+        printf("start tcp small send test\n");
+        // Type is pool or heap, connection count argument is message size.
+        start_tcp_small_send(ip, port, tp == "pool", argc > 5 ? conn_count : 64);
+    }
+
+    if (tag == "pipeline") {
+        printf("start tcp pipeline test\n");
+        // Type is sent notification mode, none, sent or batch, connection count
+        // argument is message size.
+        start_tcp_pipeline(ip, port, tp, argc > 5 ? conn_count : 64);
+    }
+
+    if (tag == "watermark") {
+        printf("start tcp watermark test\n");
+        // Connection count argument is high watermark, low watermark is half of it.
+        start_tcp_watermark(ip, port, argc > 5 ? conn_count : 0);
+    }
+
+    if (tag == "ratelimit") {
+        printf("start tcp rate limit test\n");
+        // Type is send or read, connection count argument is group rate in KB/s.
+        start_tcp_rate_limit(ip, port, tp == "send", argc > 5 ? (int64_t)conn_count * 1024 : 0);
+    }
+
+    if (tag == "sendfile") {
+        printf("start tcp sendfile test\n");
+        // Type is file, copy or limit, connection count argument is file size in
+        // KB. File is sent under a send limiter with limit type.
+        start_tcp_sendfile(ip, port, tp, argc > 5 ? conn_count * 1024 : 0);
+    }
+
+    if (tag == "zerocopy") {
+        printf("start tcp zerocopy test\n");
+        // Type is zc or copy, connection count argument is payload size in KB.
+        start_tcp_zerocopy(ip, port, tp == "zc", argc > 5 ? conn_count * 1024 : 0);
+    }
+
+    if (tag == "bulk") {
+        printf("start tcp bulk test\n");
+        // Type is read policy, connection count argument is read budget size.
+        start_tcp_bulk(ip, port, tp, argc > 5 ? conn_count : 0);
+    }
+
+    if (tag == "relay") {
+        printf("start tcp relay test\n");
+        // Type is iob or copy, connection count argument is chunk size.
+        start_tcp_relay(ip, port, tp == "iob", argc > 5 ? conn_count : 4096);
+    }
+
     if (tag == "tls") {
         printf("start tls test\n");
 
@@ -54,6 +338,18 @@ int main(int argc, const char **argv) {
         client.join();
     }
 
+    if (tag == "tlsmsg") {
+        printf("start tls messages test\n");
+        // Type is mem or fd, connection count argument is message size.
+        start_tls_messages(ip, port, tp == "mem", argc > 5 ? conn_count : 256);
+    }
+
+    if (tag == "tlshs") {
+        printf("start tls handshakes test\n");
+        // Type is full, cache, ticket or pool.
+        start_tls_handshakes(ip, port, tp, argc > 5 ? conn_count : 8);
+    }
+
     if (tag == "udp") {
         printf("start udp test\n");
 
@@ -71,7 +367,34 @@ int main(int argc, const char **argv) {
         client.join();
     }
 
+    if (tag == "udppps") {
+        printf("start udp pps test\n");
+        // Type is batch or single, connection count argument is datagram size.
+        start_udp_pps(ip, port, tp == "batch", argc > 5 ? conn_count : 64);
+    }
+
+    if (tag == "udpgso") {
+        printf("start udp gso test\n");
+        // Type is gso or plain, connection count argument is segment size.
+        start_udp_gso(ip, port, tp == "gso", argc > 5 ? conn_count : 1400);
+    }
+
+    if (tag == "udpqueue") {
+        printf("start udp queue test\n");
+        // Type is queue policy, newest, oldest, block or none, connection count
+        // argument is max queue count.
+        start_udp_queue(ip, port, tp, argc > 5 ? conn_count : 1024);
+    }
+
+    if (tag == "udpagain") {
+        printf("start udp again test\n");
+        // Type is iob, raw, queue or batch. EAGAIN is forced by delaying loopback
+        // traffic, such as with "tc qdisc add dev lo root tbf rate 200mbit burst
+        // 64kb latency 200ms".
+        start_udp_again(ip, port, tp);
+    }
+
     pump::uninit();
 
-    return 0;
+    return get_bench_failed_count() > 0 ? 1 : 0;
 }
@@ -0,0 +1,123 @@
+#include "tcp_transport_test.h"
+
+static std::string bulk_policy;
+static int32_t bulk_chunk_size = 64 * 1024;
+static int32_t bulk_read_budget = 256 * 1024;
+static int32_t max_pending_size = 4 * 1024 * 1024;
+
+static base_transport_sptr sender;
+static std::string bulk_data;
+
+static bench_counter sent_chunks;
+static bench_counter read_times;
+static bench_counter read_bytes;
+
+/*********************************************************************************
+ * Tcp read event callback
+ ********************************************************************************/
+static void on_read_callback(const char *b, int32_t size) {
+    read_bytes.add(size);
+    read_times.add(1);
+}
+
+/*********************************************************************************
+ * Tcp read io buffer event callback
+ ********************************************************************************/
+static void on_read_iob_callback(toolkit::io_buffer *iob) {
+    read_bytes.add(iob->size());
+    read_times.add(1);
+}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    if (bulk_policy.find("iob") != std::string::npos) {
+        cbs.read_iob_cb = pump_bind(&on_read_iob_callback, _1);
+    } else {
+        cbs.read_cb = pump_bind(&on_read_callback, _1, _2);
+    }
+
+    // Policy is single, budget, edge or edgebudget, with iob suffix the data
+    // is read to io buffers.
+    tcp_transport_sptr transport = std::static_pointer_cast<tcp_transport>(transp);
+    if (bulk_policy.find("edge") == 0) {
+        transport->set_edge_triggered_read(true);
+    }
+    if (bulk_policy.find("budget") != std::string::npos) {
+        transport->set_read_budget(bulk_read_budget, 0);
+    }
+
+    start_bench_transport(transp, cbs);
+}
+
+static bool send_bulk() {
+    // Send chunks back to back, only wait when too much data is pending in
+    // the transport.
+    if (sender->get_pending_send_size() > max_pending_size) {
+        std::this_thread::yield();
+        return true;
+    }
+    if (sender->send(bulk_data.data(), bulk_chunk_size) != 0) {
+        return false;
+    }
+    sent_chunks.add(1);
+    return true;
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    sender = transp;
+    if (start_bench_transport(transp, cbs)) {
+        start_bench_send_loop(pump_bind(&send_bulk));
+    }
+}
+
+static void on_bulk_report() {
+    printf("tcp bulk %s read %lld bytes/s in %lld callbacks\n",
+           bulk_policy.c_str(),
+           (long long)read_bytes.take(),
+           (long long)read_times.take());
+}
+
+static const char *check_bulk() {
+    if (sent_chunks.total() == 0) {
+        return "no chunk sent";
+    }
+    if (read_bytes.total() != sent_chunks.total() * bulk_chunk_size) {
+        return "read bytes mismatch sent chunks";
+    }
+    return nullptr;
+}
+
+void start_tcp_bulk(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &policy,
+    int32_t budget) {
+    bulk_policy = policy;
+    if (budget > 0) {
+        bulk_read_budget = budget;
+    }
+    bulk_data.assign(bulk_chunk_size, 'x');
+
+    start_bench_service();
+
+    if (!start_bench_tcp(
+            ip,
+            port,
+            1,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    run_bench(
+        "tcp bulk",
+        pump_bind(&on_bulk_report),
+        pump_bind(&check_bulk));
+}
@@ -0,0 +1,218 @@
+#include "tcp_transport_test.h"
+
+static service *sv;
+
+static uint16_t churn_port;
+static std::string churn_ip;
+
+static int32_t churn_count = 100000;
+static std::atomic_int32_t started_count(0);
+static std::atomic_int32_t finished_count(0);
+static int64_t churn_begin_time = 0;
+
+static std::mutex churn_mx;
+static std::map<void *, std::shared_ptr<void>> churn_objects;
+
+void start_once_churn_dialer();
+
+static void release_churn_object(void *obj) {
+    std::lock_guard<std::mutex> lock(churn_mx);
+    churn_objects.erase(obj);
+}
+
+class my_churn_acceptor {
+  public:
+    /*********************************************************************************
+     * Tcp accepted event callback
+     ********************************************************************************/
+    void on_accepted_callback(base_transport_sptr &transp) {
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_churn_acceptor::on_read_callback, this, _1, _2);
+        cbs.stopped_cb =
+            pump_bind(&my_churn_acceptor::on_closed_callback, this, transp.get());
+        cbs.disconnected_cb =
+            pump_bind(&my_churn_acceptor::on_closed_callback, this, transp.get());
+
+        churn_mx.lock();
+        churn_objects[transp.get()] = transp;
+        churn_mx.unlock();
+
+        if (transp->start(sv, read_mode_loop, cbs) != 0) {
+            release_churn_object(transp.get());
+            return;
+        }
+        transp->async_read();
+    }
+
+    /*********************************************************************************
+     * Stopped accepting event callback
+     ********************************************************************************/
+    void on_stopped_accepting_callback() {}
+
+    /*********************************************************************************
+     * Tcp read event callback
+     ********************************************************************************/
+    void on_read_callback(const char *b, int32_t size) {}
+
+    /*********************************************************************************
+     * Tcp disconnected or stopped event callback
+     ********************************************************************************/
+    void on_closed_callback(base_transport *transp) {
+        // Transport can't be released in its callback.
+        sv->post(pump_bind(&release_churn_object, transp));
+    }
+};
+
+class my_churn_dialer : public std::enable_shared_from_this<my_churn_dialer> {
+  public:
+    /*********************************************************************************
+     * Tcp dialed event callback
+     ********************************************************************************/
+    void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+        if (!succ) {
+            printf("tcp churn dialed error\n");
+            __finish();
+            return;
+        }
+
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_churn_dialer::on_read_callback, this, _1, _2);
+        cbs.stopped_cb = pump_bind(&my_churn_dialer::on_closed_callback, this);
+        cbs.disconnected_cb = pump_bind(&my_churn_dialer::on_closed_callback, this);
+
+        transport_ = transp;
+        if (transport_->start(sv, read_mode_loop, cbs) != 0) {
+            __finish();
+            return;
+        }
+
+        // Close the connection at once.
+        transport_->stop();
+    }
+
+    /*********************************************************************************
+     * Tcp dialed timeout event callback
+     ********************************************************************************/
+    void on_dialed_timeout_callback() {
+        printf("tcp churn dial timeout\n");
+        __finish();
+    }
+
+    /*********************************************************************************
+     * Stopped dial event callback
+     ********************************************************************************/
+    void on_stopped_dialing_callback() {}
+
+    /*********************************************************************************
+     * Tcp read event callback
+     ********************************************************************************/
+    void on_read_callback(const char *b, int32_t size) {}
+
+    /*********************************************************************************
+     * Tcp disconnected or stopped event callback
+     ********************************************************************************/
+    void on_closed_callback() {
+        __finish();
+    }
+
+    void set_dialer(tcp_dialer_sptr d) {
+        dialer_ = d;
+    }
+
+  private:
+    void __finish() {
+        auto finished = finished_count.fetch_add(1) + 1;
+        if (finished == churn_count) {
+            auto cost = (int64_t)time::get_clock_milliseconds() - churn_begin_time;
+            printf("tcp churn %d cycles cost %dms, %f cycles/s\n",
+                   churn_count,
+                   (int32_t)cost,
+                   cost > 0 ? (double)churn_count * 1000 / cost : 0.0);
+        }
+
+        // Dialer can't be released in its callback.
+        sv->post(pump_bind(&release_churn_object, this));
+
+        start_once_churn_dialer();
+    }
+
+  private:
+    tcp_dialer_sptr dialer_;
+    base_transport_sptr transport_;
+};
+
+void start_once_churn_dialer() {
+    if (started_count.fetch_add(1) >= churn_count) {
+        return;
+    }
+
+    address bind_address("0.0.0.0", 0);
+    address peer_address(churn_ip, churn_port);
+    tcp_dialer_sptr dialer =
+        tcp_dialer::create(bind_address, peer_address, 0);
+
+    std::shared_ptr<my_churn_dialer> my_dialer(new my_churn_dialer);
+    my_dialer->set_dialer(dialer);
+
+    pump::dialer_callbacks cbs;
+    cbs.dialed_cb =
+        pump_bind(&my_churn_dialer::on_dialed_callback, my_dialer.get(), _1, _2);
+    cbs.stopped_cb =
+        pump_bind(&my_churn_dialer::on_stopped_dialing_callback, my_dialer.get());
+    cbs.timeouted_cb =
+        pump_bind(&my_churn_dialer::on_dialed_timeout_callback, my_dialer.get());
+
+    churn_mx.lock();
+    churn_objects[my_dialer.get()] = my_dialer;
+    churn_mx.unlock();
+
+    if (dialer->start(sv, cbs) != 0) {
+        printf("tcp churn dialer start error\n");
+        release_churn_object(my_dialer.get());
+        finished_count.fetch_add(1);
+    }
+}
+
+static void on_churn_report_timeout() {
+    printf("tcp churn finished %d cycles at %d\n",
+           finished_count.load(),
+           (int32_t)::time(0));
+}
+
+void start_tcp_churn(
+    const std::string &ip,
+    uint16_t port,
+    int32_t conn_count) {
+    churn_ip = ip;
+    churn_port = port;
+
+    sv = new service;
+    sv->start();
+
+    my_churn_acceptor *my_acceptor = new my_churn_acceptor;
+
+    pump::acceptor_callbacks acbs;
+    acbs.accepted_cb =
+        pump_bind(&my_churn_acceptor::on_accepted_callback, my_acceptor, _1);
+    acbs.stopped_cb =
+        pump_bind(&my_churn_acceptor::on_stopped_accepting_callback, my_acceptor);
+
+    address listen_address(ip, port);
+    tcp_acceptor_sptr acceptor = tcp_acceptor::create(listen_address);
+    if (acceptor->start(sv, acbs) != 0) {
+        printf("tcp acceptor start error\n");
+        return;
+    }
+
+    // Every dialer dials next connection after its connection closed.
+    churn_begin_time = (int64_t)time::get_clock_milliseconds();
+    for (int32_t i = 0; i < conn_count; i++) {
+        start_once_churn_dialer();
+    }
+
+    time::timer_callback cb = pump_bind(&on_churn_report_timeout);
+    time::timer_sptr t = time::timer::create(true, 1000000000, cb);
+    sv->start_timer(t);
+
+    sv->wait_stopped();
+}
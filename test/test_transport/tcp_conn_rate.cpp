@@ -0,0 +1,170 @@
+#include "tcp_transport_test.h"
+
+static service *sv;
+
+static uint16_t rate_port;
+static std::string rate_ip;
+
+static std::atomic_int32_t accepted_count(0);
+static std::atomic_int32_t accepted_batch_count(0);
+static std::atomic_int32_t dialed_count(0);
+
+static std::mutex rate_mx;
+static std::map<void *, std::shared_ptr<void>> rate_objects;
+
+void start_once_rate_dialer();
+
+static void release_rate_object(void *obj) {
+    std::lock_guard<std::mutex> lock(rate_mx);
+    rate_objects.erase(obj);
+}
+
+class my_rate_acceptor {
+  public:
+    /*********************************************************************************
+     * Tcp accepted batch event callback
+     ********************************************************************************/
+    void on_accepted_batch_callback(std::vector<base_transport_sptr> &transps) {
+        // Accepted transports are closed when released.
+        accepted_count.fetch_add((int32_t)transps.size());
+        accepted_batch_count.fetch_add(1);
+    }
+
+    /*********************************************************************************
+     * Stopped accepting event callback
+     ********************************************************************************/
+    void on_stopped_accepting_callback() {}
+};
+
+class my_rate_dialer {
+  public:
+    /*********************************************************************************
+     * Tcp dialed event callback
+     ********************************************************************************/
+    void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+        if (succ) {
+            dialed_count.fetch_add(1);
+        } else {
+            printf("tcp conn rate dialed error\n");
+        }
+        __finish();
+    }
+
+    /*********************************************************************************
+     * Tcp dialed timeout event callback
+     ********************************************************************************/
+    void on_dialed_timeout_callback() {
+        printf("tcp conn rate dial timeout\n");
+        __finish();
+    }
+
+    /*********************************************************************************
+     * Stopped dial event callback
+     ********************************************************************************/
+    void on_stopped_dialing_callback() {}
+
+    void set_dialer(tcp_dialer_sptr d) {
+        dialer_ = d;
+    }
+
+  private:
+    void __finish() {
+        // Dialer can't be released in its callback.
+        sv->post(pump_bind(&release_rate_object, this));
+
+        start_once_rate_dialer();
+    }
+
+  private:
+    tcp_dialer_sptr dialer_;
+};
+
+void start_once_rate_dialer() {
+    address bind_address("0.0.0.0", 0);
+    address peer_address(rate_ip, rate_port);
+    tcp_dialer_sptr dialer = tcp_dialer::create(bind_address, peer_address, 0);
+
+    std::shared_ptr<my_rate_dialer> my_dialer(new my_rate_dialer);
+    my_dialer->set_dialer(dialer);
+
+    pump::dialer_callbacks cbs;
+    cbs.dialed_cb =
+        pump_bind(&my_rate_dialer::on_dialed_callback, my_dialer.get(), _1, _2);
+    cbs.stopped_cb =
+        pump_bind(&my_rate_dialer::on_stopped_dialing_callback, my_dialer.get());
+    cbs.timeouted_cb =
+        pump_bind(&my_rate_dialer::on_dialed_timeout_callback, my_dialer.get());
+
+    rate_mx.lock();
+    rate_objects[my_dialer.get()] = my_dialer;
+    rate_mx.unlock();
+
+    if (dialer->start(sv, cbs) != 0) {
+        printf("tcp conn rate dialer start error\n");
+        release_rate_object(my_dialer.get());
+    }
+}
+
+static void on_server_rate_timeout() {
+    int32_t accepted = accepted_count.exchange(0);
+    int32_t batches = accepted_batch_count.exchange(0);
+    printf("tcp conn rate accepted %d conns/s, %f conns/batch\n",
+           accepted,
+           batches > 0 ? (double)accepted / batches : 0.0);
+}
+
+static void on_client_rate_timeout() {
+    printf("tcp conn rate dialed %d conns/s\n", dialed_count.exchange(0));
+}
+
+void start_tcp_conn_rate_server(
+    const std::string &ip,
+    uint16_t port,
+    int32_t budget) {
+    sv = new service;
+    sv->start();
+
+    my_rate_acceptor *my_acceptor = new my_rate_acceptor;
+
+    pump::acceptor_callbacks acbs;
+    acbs.accepted_batch_cb =
+        pump_bind(&my_rate_acceptor::on_accepted_batch_callback, my_acceptor, _1);
+    acbs.stopped_cb =
+        pump_bind(&my_rate_acceptor::on_stopped_accepting_callback, my_acceptor);
+
+    address listen_address(ip, port);
+    tcp_acceptor_sptr acceptor = tcp_acceptor::create(listen_address);
+    acceptor->set_accept_budget(budget);
+    if (acceptor->start(sv, acbs) != 0) {
+        printf("tcp acceptor start error\n");
+        return;
+    }
+
+    time::timer_callback cb = pump_bind(&on_server_rate_timeout);
+    time::timer_sptr t = time::timer::create(true, 1000000000, cb);
+    sv->start_timer(t);
+
+    sv->wait_stopped();
+}
+
+void start_tcp_conn_rate_client(
+    const std::string &ip,
+    uint16_t port,
+    int32_t conn_count) {
+    rate_ip = ip;
+    rate_port = port;
+
+    sv = new service;
+    sv->start();
+
+    // Every dialer dials next connection after its connection dialed.
+    for (int32_t i = 0; i < conn_count; i++) {
+        start_once_rate_dialer();
+    }
+
+    time::timer_callback cb = pump_bind(&on_client_rate_timeout);
+    time::timer_sptr t = time::timer::create(true, 1000000000, cb);
+    sv->start_timer(t);
+
+    sv->wait_stopped();
+}
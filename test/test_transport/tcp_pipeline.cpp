@@ -0,0 +1,137 @@
+#include "tcp_transport_test.h"
+
+static int32_t pipeline_size = 64;
+static int32_t max_pending_size = 4 * 1024 * 1024;
+// Small socket buffer makes kernel send buffer full as a congested link, then
+// messages are queued in the transport.
+static int32_t socket_buffer_size = 16 * 1024;
+
+// Sent notification mode, none, sent callback or sent batch callback.
+static std::string sent_mode;
+
+static base_transport_sptr sender;
+static std::string pipeline_data;
+
+static bench_counter sent_msgs;
+static bench_counter read_bytes;
+static bench_counter sent_notified_msgs;
+static bench_counter sent_callbacks;
+
+/*********************************************************************************
+ * Tcp read event callback
+ ********************************************************************************/
+static void on_read_callback(const char *b, int32_t size) {
+    read_bytes.add(size);
+}
+
+/*********************************************************************************
+ * Tcp sent event callback
+ ********************************************************************************/
+static void on_sent_callback(toolkit::io_buffer *iob) {
+    sent_notified_msgs.add(1);
+    sent_callbacks.add(1);
+}
+
+/*********************************************************************************
+ * Tcp sent batch event callback
+ ********************************************************************************/
+static void on_sent_batch_callback(toolkit::io_buffer **iobs, int32_t count) {
+    sent_notified_msgs.add(count);
+    sent_callbacks.add(1);
+}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_read_callback, _1, _2);
+
+    net::set_read_bs(transp->get_fd(), socket_buffer_size);
+
+    start_bench_transport(transp, cbs);
+}
+
+static bool send_pipeline() {
+    // Send small messages back to back, only wait when too much data is
+    // pending in the transport.
+    if (sender->get_pending_send_size() > max_pending_size) {
+        std::this_thread::yield();
+        return true;
+    }
+    if (sender->send(pipeline_data.data(), pipeline_size) != 0) {
+        return false;
+    }
+    sent_msgs.add(1);
+    return true;
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    if (sent_mode == "sent") {
+        cbs.sent_cb = pump_bind(&on_sent_callback, _1);
+    } else if (sent_mode == "batch") {
+        cbs.sent_batch_cb = pump_bind(&on_sent_batch_callback, _1, _2);
+    }
+
+    net::set_send_bs(transp->get_fd(), socket_buffer_size);
+
+    sender = transp;
+    if (start_bench_transport(transp, cbs)) {
+        start_bench_send_loop(pump_bind(&send_pipeline));
+    }
+}
+
+static void on_pipeline_report() {
+    printf("tcp pipeline sent %lld msgs/s, read %lld bytes/s, notified %lld sent msgs in %lld callbacks\n",
+           (long long)sent_msgs.take(),
+           (long long)read_bytes.take(),
+           (long long)sent_notified_msgs.take(),
+           (long long)sent_callbacks.take());
+}
+
+static const char *check_pipeline() {
+    if (sent_msgs.total() == 0) {
+        return "no message sent";
+    }
+    if (read_bytes.total() != sent_msgs.total() * pipeline_size) {
+        return "read bytes mismatch sent messages";
+    }
+    if (sent_mode == "sent" || sent_mode == "batch") {
+        if (sent_notified_msgs.total() != sent_msgs.total()) {
+            return "notified messages mismatch sent messages";
+        }
+    } else if (sent_callbacks.total() != 0) {
+        return "sent callbacks triggered without notification";
+    }
+    return nullptr;
+}
+
+void start_tcp_pipeline(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &mode,
+    int32_t size) {
+    sent_mode = mode;
+    pipeline_size = size > 0 ? size : 64;
+    pipeline_data.assign(pipeline_size, 'x');
+
+    start_bench_service();
+
+    if (!start_bench_tcp(
+            ip,
+            port,
+            1,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    run_bench(
+        "tcp pipeline",
+        pump_bind(&on_pipeline_report),
+        pump_bind(&check_pipeline));
+}
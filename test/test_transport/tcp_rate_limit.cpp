@@ -0,0 +1,138 @@
+#include "tcp_transport_test.h"
+
+#include <pump/transport/rate_limiter.h>
+
+#include <cstdlib>
+
+static const int32_t limit_conn_count = 4;
+static const int32_t limit_msg_size = 16 * 1024;
+static const int32_t max_pending_size = 4 * 1024 * 1024;
+// Tolerance percent of measured rate
+static const int32_t limit_tolerance = 10;
+
+static bool limit_sending = true;
+
+// Group limiter shared by all connections, and every connection has its own
+// limiter of half rate under the group limiter.
+static rate_limiter_sptr group_limiter;
+
+static std::atomic_int32_t accepted_count(0);
+static std::string limit_data;
+
+static bench_counter read_bytes;
+static bench_counter conn_read_bytes[limit_conn_count];
+
+static rate_limiter_sptr create_conn_limiter() {
+    auto limiter = rate_limiter::create(group_limiter->get_rate() / 2, 0, group_limiter);
+    limiter->start(bench_sv);
+    return limiter;
+}
+
+/*********************************************************************************
+ * Tcp read event callback
+ ********************************************************************************/
+static void on_read_callback(int32_t id, const char *b, int32_t size) {
+    conn_read_bytes[id].add(size);
+    read_bytes.add(size);
+}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    int32_t id = accepted_count.fetch_add(1);
+    if (id >= limit_conn_count) {
+        return;
+    }
+
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_read_callback, id, _1, _2);
+
+    if (!limit_sending) {
+        transp->set_read_limiter(create_conn_limiter());
+    }
+
+    start_bench_transport(transp, cbs);
+}
+
+static bool send_limited(base_transport *transp) {
+    if (transp->get_pending_send_size() > max_pending_size) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return true;
+    }
+    return transp->send(limit_data.data(), limit_msg_size) == 0;
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+
+    if (limit_sending) {
+        transp->set_send_limiter(create_conn_limiter());
+    }
+
+    if (start_bench_transport(transp, cbs)) {
+        start_bench_send_loop(pump_bind(&send_limited, transp.get()));
+    }
+}
+
+static void on_limit_report() {
+    std::string conns;
+    for (int32_t i = 0; i < limit_conn_count; i++) {
+        conns += " " + std::to_string(conn_read_bytes[i].take() / 1024);
+    }
+    printf("tcp limit read %lld KB/s, connections%s KB/s\n",
+           (long long)read_bytes.take() / 1024,
+           conns.c_str());
+}
+
+static const char *check_rate_limit() {
+    // Connections share the group rate, as the group rate is less than the
+    // sum of connection rates.
+    auto rate = group_limiter->get_rate();
+    if (std::abs(read_bytes.rate() - rate) > rate * limit_tolerance / 100) {
+        return "read rate out of group rate";
+    }
+    for (int32_t i = 0; i < limit_conn_count; i++) {
+        auto conn_rate = conn_read_bytes[i].rate();
+        if (conn_rate == 0) {
+            return "connection starved";
+        }
+        if (conn_rate > rate / 2 * (100 + limit_tolerance) / 100) {
+            return "connection rate exceeds its limiter rate";
+        }
+    }
+    return nullptr;
+}
+
+void start_tcp_rate_limit(
+    const std::string &ip,
+    uint16_t port,
+    bool sending,
+    int64_t rate) {
+    limit_sending = sending;
+    limit_data.assign(limit_msg_size, 'x');
+
+    start_bench_service();
+
+    // Group rate is less than the sum of connection rates, so connections
+    // share the group rate.
+    group_limiter = rate_limiter::create(rate > 0 ? rate : 100 * 1024 * 1024);
+    group_limiter->start(bench_sv);
+
+    if (!start_bench_tcp(
+            ip,
+            port,
+            limit_conn_count,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    run_bench(
+        "tcp rate limit",
+        pump_bind(&on_limit_report),
+        pump_bind(&check_rate_limit));
+}
@@ -0,0 +1,327 @@
+#include "tcp_transport_test.h"
+
+static service *sv;
+
+static bool relay_by_iob = true;
+static int32_t relay_chunk_size = 4096;
+static int32_t max_pending_size = 4 * 1024 * 1024;
+
+static std::atomic_int64_t relayed_bytes(0);
+static std::atomic_int64_t sunk_bytes(0);
+
+// Upstream transport of relay to sink
+static base_transport_sptr upstream;
+
+void start_relay_source(const address &relay_address);
+
+class my_relay_sink {
+  public:
+    /*********************************************************************************
+     * Tcp accepted event callback
+     ********************************************************************************/
+    void on_accepted_callback(base_transport_sptr &transp) {
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_relay_sink::on_read_callback, this, _1, _2);
+        cbs.stopped_cb = pump_bind(&my_relay_sink::on_closed_callback, this);
+        cbs.disconnected_cb = pump_bind(&my_relay_sink::on_closed_callback, this);
+
+        transport_ = transp;
+        if (transport_->start(sv, read_mode_loop, cbs) != 0) {
+            printf("tcp relay sink start error\n");
+            return;
+        }
+        transport_->async_read();
+    }
+
+    /*********************************************************************************
+     * Stopped accepting event callback
+     ********************************************************************************/
+    void on_stopped_accepting_callback() {}
+
+    /*********************************************************************************
+     * Tcp read event callback
+     ********************************************************************************/
+    void on_read_callback(const char *b, int32_t size) {
+        sunk_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Tcp disconnected or stopped event callback
+     ********************************************************************************/
+    void on_closed_callback() {
+        printf("tcp relay sink closed\n");
+    }
+
+  private:
+    base_transport_sptr transport_;
+};
+
+class my_relay {
+  public:
+    /*********************************************************************************
+     * Tcp dialed event callback of upstream
+     ********************************************************************************/
+    void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+        if (!succ) {
+            printf("tcp relay dial sink error\n");
+            return;
+        }
+
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_relay::on_upstream_read_callback, this, _1, _2);
+        cbs.stopped_cb = pump_bind(&my_relay::on_closed_callback, this);
+        cbs.disconnected_cb = pump_bind(&my_relay::on_closed_callback, this);
+        if (transp->start(sv, read_mode_loop, cbs) != 0) {
+            printf("tcp relay upstream start error\n");
+            return;
+        }
+        upstream = transp;
+
+        start_relay_source(relay_address_);
+    }
+
+    /*********************************************************************************
+     * Tcp dialed timeout event callback
+     ********************************************************************************/
+    void on_dialed_timeout_callback() {
+        printf("tcp relay dial sink timeout\n");
+    }
+
+    /*********************************************************************************
+     * Stopped dial event callback
+     ********************************************************************************/
+    void on_stopped_dialing_callback() {}
+
+    /*********************************************************************************
+     * Tcp accepted event callback of downstream
+     ********************************************************************************/
+    void on_accepted_callback(base_transport_sptr &transp) {
+        pump::transport_callbacks cbs;
+        if (relay_by_iob) {
+            cbs.read_iob_cb = pump_bind(&my_relay::on_read_iob_callback, this, _1);
+        } else {
+            cbs.read_cb = pump_bind(&my_relay::on_read_callback, this, _1, _2);
+        }
+        cbs.stopped_cb = pump_bind(&my_relay::on_closed_callback, this);
+        cbs.disconnected_cb = pump_bind(&my_relay::on_closed_callback, this);
+
+        downstream_ = transp;
+        if (downstream_->start(sv, read_mode_loop, cbs) != 0) {
+            printf("tcp relay downstream start error\n");
+            return;
+        }
+        downstream_->async_read();
+    }
+
+    /*********************************************************************************
+     * Stopped accepting event callback
+     ********************************************************************************/
+    void on_stopped_accepting_callback() {}
+
+    /*********************************************************************************
+     * Tcp read event callback of downstream
+     ********************************************************************************/
+    void on_read_callback(const char *b, int32_t size) {
+        // Data is copied to a new io buffer for sending.
+        upstream->send(b, size);
+        relayed_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    /*********************************************************************************
+     * Tcp read io buffer event callback of downstream
+     ********************************************************************************/
+    void on_read_iob_callback(toolkit::io_buffer *iob) {
+        // Read io buffer is sent without copy.
+        relayed_bytes.fetch_add(iob->size(), std::memory_order_relaxed);
+        upstream->send(iob);
+    }
+
+    /*********************************************************************************
+     * Tcp read event callback of upstream
+     ********************************************************************************/
+    void on_upstream_read_callback(const char *b, int32_t size) {}
+
+    /*********************************************************************************
+     * Tcp disconnected or stopped event callback
+     ********************************************************************************/
+    void on_closed_callback() {
+        printf("tcp relay closed\n");
+    }
+
+    void set_relay_address(const address &addr) {
+        relay_address_ = addr;
+    }
+
+    void set_dialer(tcp_dialer_sptr d) {
+        dialer_ = d;
+    }
+
+  private:
+    address relay_address_;
+    tcp_dialer_sptr dialer_;
+    base_transport_sptr downstream_;
+};
+
+class my_relay_source {
+  public:
+    /*********************************************************************************
+     * Tcp dialed event callback
+     ********************************************************************************/
+    void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+        if (!succ) {
+            printf("tcp relay source dialed error\n");
+            return;
+        }
+
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_relay_source::on_read_callback, this, _1, _2);
+        cbs.stopped_cb = pump_bind(&my_relay_source::on_closed_callback, this);
+        cbs.disconnected_cb = pump_bind(&my_relay_source::on_closed_callback, this);
+
+        transport_ = transp;
+        if (transport_->start(sv, read_mode_loop, cbs) != 0) {
+            printf("tcp relay source start error\n");
+            return;
+        }
+
+        std::thread t(pump_bind(&my_relay_source::__send_loop, this));
+        t.detach();
+    }
+
+    /*********************************************************************************
+     * Tcp dialed timeout event callback
+     ********************************************************************************/
+    void on_dialed_timeout_callback() {
+        printf("tcp relay source dial timeout\n");
+    }
+
+    /*********************************************************************************
+     * Stopped dial event callback
+     ********************************************************************************/
+    void on_stopped_dialing_callback() {}
+
+    /*********************************************************************************
+     * Tcp read event callback
+     ********************************************************************************/
+    void on_read_callback(const char *b, int32_t size) {}
+
+    /*********************************************************************************
+     * Tcp disconnected or stopped event callback
+     ********************************************************************************/
+    void on_closed_callback() {
+        printf("tcp relay source closed\n");
+    }
+
+    void set_dialer(tcp_dialer_sptr d) {
+        dialer_ = d;
+    }
+
+  private:
+    void __send_loop() {
+        // Wait when too much data is pending in the source or the relay.
+        std::string data(relay_chunk_size, 'x');
+        while (transport_->is_started()) {
+            if (transport_->get_pending_send_size() > max_pending_size ||
+                upstream->get_pending_send_size() > max_pending_size) {
+                std::this_thread::yield();
+                continue;
+            }
+            if (transport_->send(data.data(), relay_chunk_size) != 0) {
+                break;
+            }
+        }
+    }
+
+  private:
+    tcp_dialer_sptr dialer_;
+    base_transport_sptr transport_;
+};
+
+void start_relay_source(const address &relay_address) {
+    address bind_address("0.0.0.0", 0);
+    tcp_dialer_sptr dialer = tcp_dialer::create(bind_address, relay_address, 0);
+
+    my_relay_source *my_source = new my_relay_source;
+    my_source->set_dialer(dialer);
+
+    pump::dialer_callbacks dcbs;
+    dcbs.dialed_cb =
+        pump_bind(&my_relay_source::on_dialed_callback, my_source, _1, _2);
+    dcbs.stopped_cb =
+        pump_bind(&my_relay_source::on_stopped_dialing_callback, my_source);
+    dcbs.timeouted_cb =
+        pump_bind(&my_relay_source::on_dialed_timeout_callback, my_source);
+    if (dialer->start(sv, dcbs) != 0) {
+        printf("tcp relay source dialer start error\n");
+    }
+}
+
+static void on_relay_timeout() {
+    printf("tcp relay %s relayed %lld bytes/s, sink read %lld bytes/s\n",
+           relay_by_iob ? "iob" : "copy",
+           (long long)relayed_bytes.exchange(0),
+           (long long)sunk_bytes.exchange(0));
+}
+
+void start_tcp_relay(
+    const std::string &ip,
+    uint16_t port,
+    bool by_iob,
+    int32_t chunk_size) {
+    relay_by_iob = by_iob;
+    relay_chunk_size = chunk_size > 0 ? chunk_size : 4096;
+
+    sv = new service;
+    sv->start();
+
+    // Sink listens on the next port of relay.
+    my_relay_sink *my_sink = new my_relay_sink;
+
+    pump::acceptor_callbacks sink_cbs;
+    sink_cbs.accepted_cb =
+        pump_bind(&my_relay_sink::on_accepted_callback, my_sink, _1);
+    sink_cbs.stopped_cb =
+        pump_bind(&my_relay_sink::on_stopped_accepting_callback, my_sink);
+
+    address sink_address(ip, port + 1);
+    tcp_acceptor_sptr sink_acceptor = tcp_acceptor::create(sink_address);
+    if (sink_acceptor->start(sv, sink_cbs) != 0) {
+        printf("tcp relay sink acceptor start error\n");
+        return;
+    }
+
+    my_relay *relay = new my_relay;
+
+    pump::acceptor_callbacks relay_cbs;
+    relay_cbs.accepted_cb = pump_bind(&my_relay::on_accepted_callback, relay, _1);
+    relay_cbs.stopped_cb =
+        pump_bind(&my_relay::on_stopped_accepting_callback, relay);
+
+    address relay_address(ip, port);
+    tcp_acceptor_sptr relay_acceptor = tcp_acceptor::create(relay_address);
+    if (relay_acceptor->start(sv, relay_cbs) != 0) {
+        printf("tcp relay acceptor start error\n");
+        return;
+    }
+
+    // Source dials relay after upstream of relay connected.
+    address bind_address("0.0.0.0", 0);
+    tcp_dialer_sptr dialer = tcp_dialer::create(bind_address, sink_address, 0);
+    relay->set_dialer(dialer);
+    relay->set_relay_address(relay_address);
+
+    pump::dialer_callbacks dcbs;
+    dcbs.dialed_cb = pump_bind(&my_relay::on_dialed_callback, relay, _1, _2);
+    dcbs.stopped_cb = pump_bind(&my_relay::on_stopped_dialing_callback, relay);
+    dcbs.timeouted_cb = pump_bind(&my_relay::on_dialed_timeout_callback, relay);
+    if (dialer->start(sv, dcbs) != 0) {
+        printf("tcp relay dialer start error\n");
+        return;
+    }
+
+    time::timer_callback cb = pump_bind(&on_relay_timeout);
+    time::timer_sptr t = time::timer::create(true, 1000000000, cb);
+    sv->start_timer(t);
+
+    sv->wait_stopped();
+}
@@ -0,0 +1,174 @@
+#include "tcp_transport_test.h"
+
+#include <pump/transport/rate_limiter.h>
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+static int32_t file_size = 4 * 1024 * 1024;
+static int32_t max_pending_size = 16 * 1024 * 1024;
+// Tolerance percent of measured rate
+static const int32_t limit_tolerance = 10;
+
+// Send file by sendfile, else read file to buffers and send them.
+static bool by_sendfile = true;
+
+// Send limiter of sender, file is sent in chunks under it.
+static int64_t limited_rate = 64 * 1024 * 1024;
+static rate_limiter_sptr send_limiter;
+
+static int32_t file_fd = -1;
+
+static base_transport_sptr sender;
+// Read position in the file
+static int32_t read_pos = 0;
+
+static bench_counter sent_bytes;
+static bench_counter read_bytes;
+static bench_counter corrupt_bytes;
+
+/*********************************************************************************
+ * Tcp read event callback
+ ********************************************************************************/
+static void on_read_callback(const char *b, int32_t size) {
+    // Byte at file position i is i % 251.
+    for (int32_t i = 0; i < size; i++) {
+        if ((uint8_t)b[i] != (uint8_t)(read_pos % 251)) {
+            corrupt_bytes.add(1);
+        }
+        if (++read_pos == file_size) {
+            read_pos = 0;
+        }
+    }
+    read_bytes.add(size);
+}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_read_callback, _1, _2);
+    start_bench_transport(transp, cbs);
+}
+
+static bool send_file() {
+    if (sender->get_pending_send_size() > max_pending_size) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return true;
+    }
+    if (by_sendfile) {
+        if (sender->send_file(file_fd, 0, file_size) != 0) {
+            return false;
+        }
+        sent_bytes.add(file_size);
+        return true;
+    }
+    // Read the file to buffers in user space and send them.
+    const int32_t chunk_size = 64 * 1024;
+    for (int32_t offset = 0; offset < file_size; offset += chunk_size) {
+        auto size = file_size - offset < chunk_size ? file_size - offset : chunk_size;
+        auto iob = toolkit::io_buffer::create(size);
+        auto ret = ::pread(file_fd, iob->prepare_write(size), size, offset);
+        iob->commit_write((uint32_t)ret);
+        auto ec = sender->send(iob);
+        iob->unrefer();
+        if (ec != 0) {
+            return false;
+        }
+        sent_bytes.add(ret);
+    }
+    return true;
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+
+    sender = transp;
+    if (send_limiter) {
+        sender->set_send_limiter(send_limiter);
+    }
+    if (start_bench_transport(transp, cbs)) {
+        start_bench_send_loop(pump_bind(&send_file));
+    }
+}
+
+static bool create_test_file() {
+    char path[] = "/tmp/pump_sendfile_XXXXXX";
+    file_fd = ::mkstemp(path);
+    if (file_fd < 0) {
+        return false;
+    }
+    ::unlink(path);
+
+    std::string data(file_size, 0);
+    for (int32_t i = 0; i < file_size; i++) {
+        data[i] = char(i % 251);
+    }
+    return ::write(file_fd, data.data(), data.size()) == (ssize_t)data.size();
+}
+
+static void on_sendfile_report() {
+    printf("tcp sendfile read %lld MB/s, corrupt %lld bytes\n",
+           (long long)read_bytes.take() / (1024 * 1024),
+           (long long)corrupt_bytes.total());
+}
+
+static const char *check_sendfile() {
+    // Read rate is taken at reporting, so check it before data in flight is
+    // drained.
+    if (send_limiter &&
+        std::abs(read_bytes.rate() - limited_rate) > limited_rate * limit_tolerance / 100) {
+        return "read rate out of limited rate";
+    }
+    if (corrupt_bytes.total() != 0) {
+        return "file data corrupt";
+    }
+    if (sent_bytes.total() == 0) {
+        return "no file sent";
+    }
+    if (read_bytes.total() != sent_bytes.total()) {
+        return "read bytes mismatch sent bytes";
+    }
+    return nullptr;
+}
+
+void start_tcp_sendfile(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &mode,
+    int32_t size) {
+    by_sendfile = mode != "copy";
+    if (size > 0) {
+        file_size = size;
+    }
+    if (!create_test_file()) {
+        printf("create sendfile test file error\n");
+        return;
+    }
+
+    start_bench_service();
+
+    if (mode == "limit") {
+        send_limiter = rate_limiter::create(limited_rate);
+        send_limiter->start(bench_sv);
+    }
+
+    if (!start_bench_tcp(
+            ip,
+            port,
+            1,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    run_bench(
+        "tcp sendfile",
+        pump_bind(&on_sendfile_report),
+        pump_bind(&check_sendfile));
+}
@@ -0,0 +1,232 @@
+#include "tcp_transport_test.h"
+#include "tls_transport_test.h"
+
+#include <pump/transport/sharded_acceptor.h>
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+static service *sv;
+
+static const int32_t sharded_shard_count = 4;
+
+static std::atomic_int32_t created_count(0);
+static std::atomic_int32_t accepted_count(0);
+static std::atomic_int32_t dialed_count(0);
+static std::atomic_int32_t stopped_count(0);
+
+static std::mutex sharded_mx;
+static std::map<void *, std::shared_ptr<void>> sharded_objects;
+
+static void release_sharded_object(void *obj) {
+    std::lock_guard<std::mutex> lock(sharded_mx);
+    sharded_objects.erase(obj);
+}
+
+static void hold_sharded_object(std::shared_ptr<void> obj) {
+    std::lock_guard<std::mutex> lock(sharded_mx);
+    sharded_objects[obj.get()] = obj;
+}
+
+static bool wait_count(std::atomic_int32_t &count, int32_t expected) {
+    for (int32_t i = 0; i < 300; i++) {
+        if (count.load() >= expected) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return count.load() >= expected;
+}
+
+/*********************************************************************************
+ * Creator which fails to create acceptors after the first two shards
+ ********************************************************************************/
+static base_acceptor_sptr create_failed_acceptor(const address &listen_address) {
+    if (created_count.fetch_add(1) >= 2) {
+        return base_acceptor_sptr();
+    }
+    return tcp_acceptor::create(listen_address);
+}
+
+/*********************************************************************************
+ * Accepted batch event callback
+ ********************************************************************************/
+static void on_accepted_batch_callback(std::vector<base_transport_sptr> &transps) {
+    // Accepted transports are closed when released.
+    accepted_count.fetch_add((int32_t)transps.size());
+}
+
+/*********************************************************************************
+ * Stopped accepting event callback
+ ********************************************************************************/
+static void on_stopped_accepting_callback() {
+    stopped_count.fetch_add(1);
+}
+
+class my_sharded_dialer {
+  public:
+    /*********************************************************************************
+     * Dialed event callback
+     ********************************************************************************/
+    void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+        if (succ) {
+            dialed_count.fetch_add(1);
+        } else {
+            printf("sharded acceptor dialed error\n");
+        }
+        // Dialer can't be released in its callback.
+        sv->post(pump_bind(&release_sharded_object, this));
+    }
+
+    /*********************************************************************************
+     * Dialed timeout event callback
+     ********************************************************************************/
+    void on_dialed_timeout_callback() {
+        printf("sharded acceptor dial timeout\n");
+        sv->post(pump_bind(&release_sharded_object, this));
+    }
+
+    /*********************************************************************************
+     * Stopped dial event callback
+     ********************************************************************************/
+    void on_stopped_dialing_callback() {}
+
+    void set_dialer(base_dialer_sptr d) {
+        dialer_ = d;
+    }
+
+  private:
+    base_dialer_sptr dialer_;
+};
+
+static void start_sharded_dialer(
+    const address &peer_address,
+    tls_credentials xcred) {
+    address bind_address("0.0.0.0", 0);
+    base_dialer_sptr dialer;
+    if (xcred != nullptr) {
+        dialer = tls_dialer::create(bind_address, peer_address, 0, 1000000000);
+    } else {
+        dialer = tcp_dialer::create(bind_address, peer_address, 0);
+    }
+
+    std::shared_ptr<my_sharded_dialer> my_dialer(new my_sharded_dialer);
+    my_dialer->set_dialer(dialer);
+
+    pump::dialer_callbacks cbs;
+    cbs.dialed_cb =
+        pump_bind(&my_sharded_dialer::on_dialed_callback, my_dialer.get(), _1, _2);
+    cbs.stopped_cb =
+        pump_bind(&my_sharded_dialer::on_stopped_dialing_callback, my_dialer.get());
+    cbs.timeouted_cb =
+        pump_bind(&my_sharded_dialer::on_dialed_timeout_callback, my_dialer.get());
+
+    hold_sharded_object(my_dialer);
+    if (dialer->start(sv, cbs) != 0) {
+        printf("sharded acceptor dialer start error\n");
+        release_sharded_object(my_dialer.get());
+    }
+}
+
+/*********************************************************************************
+ * Stopped callback is triggered after a failed starting stopped started shards
+ ********************************************************************************/
+static bool test_failed_start(const address &listen_address) {
+    stopped_count.store(0);
+
+    pump::acceptor_callbacks acbs;
+    acbs.accepted_batch_cb = pump_bind(&on_accepted_batch_callback, _1);
+    acbs.stopped_cb = pump_bind(&on_stopped_accepting_callback);
+
+    sharded_acceptor_sptr acceptor = sharded_acceptor::create(
+        pump_bind(&create_failed_acceptor, listen_address));
+    if (acceptor->start(sv, acbs) != error_fault) {
+        printf("sharded acceptor failed start: start should fail\n");
+        return false;
+    }
+    if (acceptor->get_acceptor_count() != 2) {
+        printf("sharded acceptor failed start: %d acceptors started\n",
+               acceptor->get_acceptor_count());
+        return false;
+    }
+    if (!wait_count(stopped_count, 1)) {
+        printf("sharded acceptor failed start: stopped callback not triggered\n");
+        return false;
+    }
+    return true;
+}
+
+/*********************************************************************************
+ * Batch callback receives transports of tcp or tls shard acceptors
+ ********************************************************************************/
+static bool test_batch_accept(
+    const address &listen_address,
+    tls_credentials xcred,
+    int32_t conn_count) {
+    accepted_count.store(0);
+    dialed_count.store(0);
+    stopped_count.store(0);
+
+    pump::acceptor_callbacks acbs;
+    acbs.accepted_batch_cb = pump_bind(&on_accepted_batch_callback, _1);
+    acbs.stopped_cb = pump_bind(&on_stopped_accepting_callback);
+
+    sharded_acceptor_sptr acceptor;
+    if (xcred != nullptr) {
+        acceptor = sharded_acceptor::create(pump_bind(
+            &tls_acceptor::create, xcred, listen_address, 1000000000));
+    } else {
+        acceptor = sharded_acceptor::create(
+            pump_bind(&tcp_acceptor::create, listen_address));
+    }
+    if (acceptor->start(sv, acbs) != error_none) {
+        printf("sharded acceptor batch: start error\n");
+        return false;
+    }
+
+    for (int32_t i = 0; i < conn_count; i++) {
+        start_sharded_dialer(listen_address, xcred);
+    }
+    bool ok = wait_count(accepted_count, conn_count) &&
+              wait_count(dialed_count, conn_count);
+    if (!ok) {
+        printf("sharded acceptor batch: accepted %d dialed %d of %d\n",
+               accepted_count.load(),
+               dialed_count.load(),
+               conn_count);
+    }
+
+    acceptor->stop();
+    if (!wait_count(stopped_count, 1)) {
+        printf("sharded acceptor batch: stopped callback not triggered\n");
+        return false;
+    }
+    return ok;
+}
+
+void start_sharded_acceptor(
+    const std::string &ip,
+    uint16_t port,
+    bool tls,
+    int32_t conn_count) {
+    sv = new service(true, sharded_shard_count);
+    sv->start();
+
+    tls_credentials xcred = nullptr;
+    if (tls) {
+        xcred = load_tls_credentials_from_memory(false, cert, key);
+        if (xcred == nullptr) {
+            printf("load tls credentials error\n");
+            return;
+        }
+    }
+
+    bool ok = test_failed_start(address(ip, port));
+    ok = test_batch_accept(address(ip, port + 1), xcred, conn_count) && ok;
+    printf("sharded acceptor test %s\n", ok ? "passed" : "failed");
+
+    sv->stop();
+    sv->wait_stopped();
+}
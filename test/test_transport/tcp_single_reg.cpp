@@ -0,0 +1,202 @@
+#include "tcp_transport_test.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+static service *sv;
+
+static const int32_t single_reg_chunk_size = 64 * 1024;
+static const int32_t single_reg_chunk_count = 128;
+static const int64_t single_reg_total_size =
+    (int64_t)single_reg_chunk_size * single_reg_chunk_count;
+
+static std::atomic_int64_t server_read_size(0);
+static std::atomic_int64_t client_read_size(0);
+static std::atomic_bool server_reading(false);
+
+static base_transport_sptr server_transport;
+static base_transport_sptr client_transport;
+
+static bool wait_size(std::atomic_int64_t &size, int64_t expected) {
+    for (int32_t i = 0; i < 500; i++) {
+        if (size.load() >= expected) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return size.load() >= expected;
+}
+
+/*********************************************************************************
+ * Count epoll instances of the process which the fd is registered in
+ ********************************************************************************/
+static int32_t count_fd_registrations(int32_t fd) {
+    int32_t count = 0;
+    DIR *dir = opendir("/proc/self/fd");
+    if (dir == nullptr) {
+        return -1;
+    }
+    for (auto ent = readdir(dir); ent != nullptr; ent = readdir(dir)) {
+        char link[64] = {0};
+        std::string path = std::string("/proc/self/fd/") + ent->d_name;
+        if (readlink(path.c_str(), link, sizeof(link) - 1) <= 0 ||
+            std::string(link) != "anon_inode:[eventpoll]") {
+            continue;
+        }
+        std::ifstream info(std::string("/proc/self/fdinfo/") + ent->d_name);
+        std::string line;
+        while (std::getline(info, line)) {
+            int32_t tfd = -1;
+            if (sscanf(line.c_str(), "tfd: %d", &tfd) == 1 && tfd == fd) {
+                count++;
+            }
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+/*********************************************************************************
+ * Server read event callback
+ ********************************************************************************/
+static void on_server_read_callback(const char *b, int32_t size) {
+    server_read_size.fetch_add(size);
+    // Read tracker is restarted only when reading.
+    if (server_reading.load()) {
+        server_transport->async_read();
+    }
+}
+
+/*********************************************************************************
+ * Client read event callback
+ ********************************************************************************/
+static void on_client_read_callback(const char *b, int32_t size) {
+    client_read_size.fetch_add(size);
+}
+
+static void on_ignored_callback() {}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_server_read_callback, _1, _2);
+    cbs.stopped_cb = pump_bind(&on_ignored_callback);
+    cbs.disconnected_cb = pump_bind(&on_ignored_callback);
+
+    // Read tracker stops after every read, and send tracker shares its
+    // registration.
+    transp->set_single_registration(true);
+    if (transp->start(sv, read_mode_once, cbs) != 0) {
+        printf("single registration server start error\n");
+        return;
+    }
+    server_transport = transp;
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+    if (!succ) {
+        printf("single registration dialed error\n");
+        return;
+    }
+
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_client_read_callback, _1, _2);
+    cbs.stopped_cb = pump_bind(&on_ignored_callback);
+    cbs.disconnected_cb = pump_bind(&on_ignored_callback);
+    if (transp->start(sv, read_mode_loop, cbs) != 0) {
+        printf("single registration client start error\n");
+        return;
+    }
+    transp->async_read();
+    client_transport = transp;
+}
+
+static void send_chunks(base_transport_sptr &transp) {
+    std::string chunk(single_reg_chunk_size, 's');
+    for (int32_t i = 0; i < single_reg_chunk_count; i++) {
+        transp->send(chunk.data(), (int32_t)chunk.size());
+    }
+}
+
+void start_tcp_single_reg(const std::string &ip, uint16_t port) {
+    // Read and send trackers of a transport are in pollers of one shard.
+    sv = new service(true, 1);
+    sv->start();
+
+    pump::acceptor_callbacks acbs;
+    acbs.accepted_cb = pump_bind(&on_accepted_callback, _1);
+    acbs.stopped_cb = pump_bind(&on_ignored_callback);
+
+    address listen_address(ip, port);
+    tcp_acceptor_sptr acceptor = tcp_acceptor::create(listen_address);
+    if (acceptor->start(sv, acbs) != 0) {
+        printf("tcp acceptor start error\n");
+        return;
+    }
+
+    pump::dialer_callbacks dcbs;
+    dcbs.dialed_cb = pump_bind(&on_dialed_callback, _1, _2);
+    dcbs.stopped_cb = pump_bind(&on_ignored_callback);
+    dcbs.timeouted_cb = pump_bind(&on_ignored_callback);
+
+    address bind_address("0.0.0.0", 0);
+    tcp_dialer_sptr dialer = tcp_dialer::create(bind_address, listen_address, 0);
+    if (dialer->start(sv, dcbs) != 0) {
+        printf("tcp dialer start error\n");
+        return;
+    }
+    for (int32_t i = 0; i < 300 && (!server_transport || !client_transport); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (!server_transport || !client_transport) {
+        printf("single registration connect error\n");
+        return;
+    }
+
+    bool ok = true;
+
+    // Read and send trackers share one registration.
+    auto regs = count_fd_registrations((int32_t)server_transport->get_fd());
+    if (regs != 1) {
+        printf("single registration: fd registered %d times\n", regs);
+        ok = false;
+    }
+
+    // Sending keeps working while read tracker is stopped.
+    send_chunks(server_transport);
+    if (!wait_size(client_read_size, single_reg_total_size)) {
+        printf("single registration: client read %lld of %lld with read stopped\n",
+               (long long)client_read_size.load(),
+               (long long)single_reg_total_size);
+        ok = false;
+    }
+
+    // Reading keeps working while send tracker is stopped.
+    server_reading.store(true);
+    server_transport->async_read();
+    send_chunks(client_transport);
+    if (!wait_size(server_read_size, single_reg_total_size)) {
+        printf("single registration: server read %lld of %lld with send stopped\n",
+               (long long)server_read_size.load(),
+               (long long)single_reg_total_size);
+        ok = false;
+    }
+
+    printf("single registration test %s\n", ok ? "passed" : "failed");
+
+    server_transport->force_stop();
+    client_transport->force_stop();
+    acceptor->stop();
+    sv->stop();
+    sv->wait_stopped();
+}
@@ -0,0 +1,108 @@
+#include <pump/toolkit/slab_pool.h>
+
+#include "tcp_transport_test.h"
+
+static int32_t send_size = 64;
+static int32_t send_window = 1024;
+static std::string send_data;
+
+static base_transport_sptr sender;
+
+static bench_counter issued_count;
+static bench_counter sent_count;
+static bench_counter read_bytes;
+
+/*********************************************************************************
+ * Tcp read event callback
+ ********************************************************************************/
+static void on_read_callback(const char *b, int32_t size) {
+    read_bytes.add(size);
+}
+
+/*********************************************************************************
+ * Tcp sent event callback
+ ********************************************************************************/
+static void on_sent_callback(toolkit::io_buffer *iob) {
+    sent_count.add(1);
+    if (is_bench_running() && sender->send(send_data.data(), send_size) == 0) {
+        issued_count.add(1);
+    }
+}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_read_callback, _1, _2);
+    start_bench_transport(transp, cbs);
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.sent_cb = pump_bind(&on_sent_callback, _1);
+
+    sender = transp;
+    if (!start_bench_transport(transp, cbs)) {
+        return;
+    }
+
+    // Keep a window of small messages in flight, every sent message triggers
+    // sending next one.
+    for (int32_t i = 0; i < send_window; i++) {
+        if (sender->send(send_data.data(), send_size) == 0) {
+            issued_count.add(1);
+        }
+    }
+}
+
+static void on_small_send_report() {
+    printf("tcp small send %s %lld msgs/s, read %lld bytes/s\n",
+           toolkit::slab_pool::is_enabled() ? "pool" : "heap",
+           (long long)sent_count.take(),
+           (long long)read_bytes.take());
+}
+
+static const char *check_small_send() {
+    if (issued_count.total() == 0) {
+        return "no message sent";
+    }
+    if (sent_count.total() != issued_count.total()) {
+        return "sent callbacks mismatch sent messages";
+    }
+    if (read_bytes.total() != issued_count.total() * send_size) {
+        return "read bytes mismatch sent messages";
+    }
+    return nullptr;
+}
+
+void start_tcp_small_send(
+    const std::string &ip,
+    uint16_t port,
+    bool pooled,
+    int32_t size) {
+    // Pool must be switched before any buffer is created.
+    toolkit::slab_pool::set_enabled(pooled);
+
+    send_size = size > 0 ? size : 64;
+    send_data.assign(send_size, 'x');
+
+    start_bench_service();
+
+    if (!start_bench_tcp(
+            ip,
+            port,
+            1,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    run_bench(
+        "tcp small send",
+        pump_bind(&on_small_send_report),
+        pump_bind(&check_small_send));
+}
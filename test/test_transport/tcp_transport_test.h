@@ -2,18 +2,113 @@
 #define tcp_client_h
 
 #include <pump/service.h>
+#include <pump/time/timestamp.h>
 #include <pump/time/timer.h>
 #include <pump/transport/tcp_acceptor.h>
 #include <pump/transport/tcp_dialer.h>
 #include <pump/transport/tcp_transport.h>
 #include <stdio.h>
 
+#include <atomic>
+#include <string>
+#include <thread>
+
 namespace pump {
 using namespace transport;
 }
 
 using namespace pump;
 
+/*********************************************************************************
+ * Benchmark harness
+ * Benchmark runs loopback transports on the bench service, reports counters
+ * every second, then stops send loops and checks its results. Checking is
+ * retried until data in flight is delivered or drain time is out.
+ ********************************************************************************/
+
+// Service of running benchmark
+extern service *bench_sv;
+
+// Transport accepted or dialed by benchmark
+typedef pump_function<void(base_transport_sptr &)> bench_transport_callback;
+
+// Send function of send loop, returning false ends the loop
+typedef pump_function<bool()> bench_send_function;
+
+// Report function called every second
+typedef pump_function<void()> bench_report_function;
+
+// Check function returning failure reason, or nullptr if passed
+typedef pump_function<const char *()> bench_check_function;
+
+/*********************************************************************************
+ * Benchmark counter
+ * Total is for checking, and increment since last taking is for reporting.
+ ********************************************************************************/
+class bench_counter {
+  public:
+    pump_inline void add(int64_t n) noexcept {
+        total_.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    pump_inline int64_t total() const noexcept {
+        return total_.load(std::memory_order_relaxed);
+    }
+
+    pump_inline int64_t take() noexcept {
+        auto total = total_.load(std::memory_order_relaxed);
+        auto n = total - taken_;
+        if (taken_count_++ == 0) {
+            first_taken_ = total;
+        }
+        taken_ = total;
+        return n;
+    }
+
+    /*********************************************************************************
+     * Get rate per second
+     * Increment taken at the first second is skipped as warming up.
+     ********************************************************************************/
+    pump_inline int64_t rate() const noexcept {
+        if (taken_count_ < 2) {
+            return taken_;
+        }
+        return (taken_ - first_taken_) / (taken_count_ - 1);
+    }
+
+  private:
+    std::atomic_int64_t total_{0};
+    int64_t taken_ = 0;
+    int64_t first_taken_ = 0;
+    int32_t taken_count_ = 0;
+};
+
+extern void set_bench_seconds(int32_t seconds);
+
+extern bool is_bench_running();
+
+extern int32_t get_bench_failed_count();
+
+extern void start_bench_service();
+
+extern bool start_bench_tcp(
+    const std::string &ip,
+    uint16_t port,
+    int32_t conn_count,
+    const bench_transport_callback &accepted,
+    const bench_transport_callback &dialed);
+
+extern bool start_bench_transport(
+    base_transport_sptr transp,
+    transport_callbacks &cbs);
+
+extern void start_bench_send_loop(const bench_send_function &send);
+
+extern bool run_bench(
+    const std::string &name,
+    const bench_report_function &report,
+    const bench_check_function &check);
+
 extern void start_tcp_server(
     const std::string &ip,
     uint16_t port);
@@ -23,4 +118,76 @@ extern void start_tcp_client(
     uint16_t port,
     int32_t conn_count);
 
+extern void start_tcp_churn(
+    const std::string &ip,
+    uint16_t port,
+    int32_t conn_count);
+
+extern void start_tcp_conn_rate_server(
+    const std::string &ip,
+    uint16_t port,
+    int32_t budget);
+
+extern void start_tcp_conn_rate_client(
+    const std::string &ip,
+    uint16_t port,
+    int32_t conn_count);
+
+extern void start_tcp_single_reg(
+    const std::string &ip,
+    uint16_t port);
+
+extern void start_sharded_acceptor(
+    const std::string &ip,
+    uint16_t port,
+    bool tls,
+    int32_t conn_count);
+
+extern void start_tcp_small_send(
+    const std::string &ip,
+    uint16_t port,
+    bool pooled,
+    int32_t size);
+
+extern void start_tcp_pipeline(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &mode,
+    int32_t size);
+
+extern void start_tcp_watermark(
+    const std::string &ip,
+    uint16_t port,
+    int32_t high);
+
+extern void start_tcp_rate_limit(
+    const std::string &ip,
+    uint16_t port,
+    bool sending,
+    int64_t rate);
+
+extern void start_tcp_sendfile(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &mode,
+    int32_t size);
+
+extern void start_tcp_zerocopy(
+    const std::string &ip,
+    uint16_t port,
+    bool zerocopy,
+    int32_t size);
+
+extern void start_tcp_bulk(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &policy,
+    int32_t budget);
+
+extern void start_tcp_relay(
+    const std::string &ip,
+    uint16_t port,
+    bool by_iob,
+    int32_t chunk_size);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "tcp_transport_test.h"
+
+#include <condition_variable>
+
+static int32_t watermark_size = 256;
+static int32_t high_watermark = 1024 * 1024;
+static int32_t low_watermark = high_watermark / 2;
+// Small socket buffer makes kernel send buffer full as a congested link, then
+// messages are queued in the transport.
+static int32_t socket_buffer_size = 16 * 1024;
+
+static base_transport_sptr sender;
+static std::string watermark_data;
+
+static std::mutex resume_mx;
+static std::condition_variable resume_cv;
+
+static bench_counter sent_msgs;
+static bench_counter read_bytes;
+static bench_counter paused_count;
+static bench_counter resumed_count;
+// Max pending send size of last second and of the whole run
+static std::atomic_int32_t max_pending_size(0);
+static std::atomic_int32_t peak_pending_size(0);
+// Max pending send size when sending is resumed
+static std::atomic_int32_t max_resumed_pending_size(0);
+
+static void update_max(std::atomic_int32_t &max, int32_t size) {
+    if (size > max.load(std::memory_order_relaxed)) {
+        max.store(size, std::memory_order_relaxed);
+    }
+}
+
+/*********************************************************************************
+ * Tcp read event callback
+ ********************************************************************************/
+static void on_read_callback(const char *b, int32_t size) {
+    read_bytes.add(size);
+}
+
+/*********************************************************************************
+ * Tcp send paused event callback
+ ********************************************************************************/
+static void on_send_paused_callback() {
+    paused_count.add(1);
+}
+
+/*********************************************************************************
+ * Tcp send resumed event callback
+ ********************************************************************************/
+static void on_send_resumed_callback() {
+    resumed_count.add(1);
+    std::lock_guard<std::mutex> lock(resume_mx);
+    resume_cv.notify_one();
+}
+
+/*********************************************************************************
+ * Tcp disconnected or stopped event callback
+ ********************************************************************************/
+static void on_closed_callback() {
+    std::lock_guard<std::mutex> lock(resume_mx);
+    resume_cv.notify_one();
+}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_read_callback, _1, _2);
+
+    net::set_read_bs(transp->get_fd(), socket_buffer_size);
+
+    start_bench_transport(transp, cbs);
+}
+
+static bool send_watermark() {
+    // Send messages back to back, wait without polling when the transport
+    // pauses sending. Paused status is set at once when pending send size
+    // reaches the high watermark, the callback comes later.
+    if (sender->is_send_paused()) {
+        std::unique_lock<std::mutex> lock(resume_mx);
+        resume_cv.wait(lock, []() {
+            return !sender->is_send_paused() || !sender->is_started();
+        });
+        // Only the sender adds pending send size, so it is not more than the
+        // low watermark until next sending.
+        update_max(max_resumed_pending_size, sender->get_pending_send_size());
+    }
+    if (sender->send(watermark_data.data(), watermark_size) != 0) {
+        return false;
+    }
+    sent_msgs.add(1);
+
+    int32_t pending = sender->get_pending_send_size();
+    update_max(max_pending_size, pending);
+    update_max(peak_pending_size, pending);
+    return true;
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.stopped_cb = pump_bind(&on_closed_callback);
+    cbs.disconnected_cb = pump_bind(&on_closed_callback);
+    cbs.send_paused_cb = pump_bind(&on_send_paused_callback);
+    cbs.send_resumed_cb = pump_bind(&on_send_resumed_callback);
+
+    net::set_send_bs(transp->get_fd(), socket_buffer_size);
+
+    sender = transp;
+    sender->set_send_watermark(high_watermark, low_watermark);
+    if (start_bench_transport(transp, cbs)) {
+        start_bench_send_loop(pump_bind(&send_watermark));
+    }
+}
+
+static void on_watermark_report() {
+    printf("tcp watermark sent %lld msgs/s, read %lld bytes/s, paused %lld times, max pending %d bytes\n",
+           (long long)sent_msgs.take(),
+           (long long)read_bytes.take(),
+           (long long)paused_count.take(),
+           max_pending_size.exchange(0));
+}
+
+static const char *check_watermark() {
+    if (paused_count.total() == 0) {
+        return "sending never paused";
+    }
+    // Sending pauses as soon as a message makes pending send size reach the
+    // high watermark.
+    if (peak_pending_size.load() < high_watermark ||
+        peak_pending_size.load() >= high_watermark + watermark_size) {
+        return "sending not paused at high watermark";
+    }
+    if (max_resumed_pending_size.load() > low_watermark) {
+        return "sending resumed above low watermark";
+    }
+    // Sending resumes after all pending data is sent.
+    if (resumed_count.total() != paused_count.total()) {
+        return "resumed callbacks mismatch paused callbacks";
+    }
+    if (read_bytes.total() != sent_msgs.total() * watermark_size) {
+        return "read bytes mismatch sent messages";
+    }
+    return nullptr;
+}
+
+void start_tcp_watermark(
+    const std::string &ip,
+    uint16_t port,
+    int32_t high) {
+    high_watermark = high > 0 ? high : 1024 * 1024;
+    low_watermark = high_watermark / 2;
+    watermark_data.assign(watermark_size, 'x');
+
+    start_bench_service();
+
+    if (!start_bench_tcp(
+            ip,
+            port,
+            1,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    run_bench(
+        "tcp watermark",
+        pump_bind(&on_watermark_report),
+        pump_bind(&check_watermark));
+}
@@ -0,0 +1,162 @@
+#include "tcp_transport_test.h"
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+static int32_t payload_size = 1024 * 1024;
+static int32_t max_pending_size = 16 * 1024 * 1024;
+
+// Send with zero copy, else send with copy.
+static bool by_zerocopy = true;
+
+// Payload is never changed, so it can be sent with zero copy.
+static std::string payload;
+
+static base_transport_sptr sender;
+// Read position in the payload
+static int32_t read_pos = 0;
+
+static bench_counter issued_bytes;
+static bench_counter sent_bytes;
+static bench_counter read_bytes;
+static bench_counter corrupt_bytes;
+static std::atomic_int64_t inflight_bytes(0);
+
+static int64_t last_cpu_us = 0;
+
+/*********************************************************************************
+ * Tcp read event callback
+ ********************************************************************************/
+static void on_read_callback(const char *b, int32_t size) {
+    // Byte at payload position i is i % 251.
+    for (int32_t i = 0; i < size; i++) {
+        if ((uint8_t)b[i] != (uint8_t)(read_pos % 251)) {
+            corrupt_bytes.add(1);
+        }
+        if (++read_pos == payload_size) {
+            read_pos = 0;
+        }
+    }
+    read_bytes.add(size);
+}
+
+/*********************************************************************************
+ * Tcp sent event callback
+ * With zero copy, it is triggered after kernel completes the sending.
+ ********************************************************************************/
+static void on_sent_callback(toolkit::io_buffer *iob) {
+    sent_bytes.add(iob->capacity());
+    inflight_bytes.fetch_sub(iob->capacity(), std::memory_order_relaxed);
+}
+
+/*********************************************************************************
+ * Tcp accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_read_callback, _1, _2);
+    start_bench_transport(transp, cbs);
+}
+
+static bool send_payload() {
+    if (inflight_bytes.load(std::memory_order_relaxed) > max_pending_size) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        return true;
+    }
+    auto iob = toolkit::io_buffer::create_by_reference(
+        payload.data(),
+        (uint32_t)payload.size());
+    inflight_bytes.fetch_add(payload_size, std::memory_order_relaxed);
+    auto ec = sender->send(iob);
+    iob->unrefer();
+    if (ec != 0) {
+        return false;
+    }
+    issued_bytes.add(payload_size);
+    return true;
+}
+
+/*********************************************************************************
+ * Tcp dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.sent_cb = pump_bind(&on_sent_callback, _1);
+
+    sender = transp;
+    if (by_zerocopy) {
+        tcp_transport_sptr transport = std::static_pointer_cast<tcp_transport>(transp);
+        transport->set_zerocopy_send(payload_size);
+    }
+    if (start_bench_transport(transp, cbs)) {
+        start_bench_send_loop(pump_bind(&send_payload));
+    }
+}
+
+static int64_t get_cpu_us() {
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void on_zerocopy_report() {
+    auto cpu_us = get_cpu_us();
+    auto read_mb = read_bytes.take() / (1024 * 1024);
+    auto sent_mb = sent_bytes.take() / (1024 * 1024);
+    auto used_us = cpu_us - last_cpu_us;
+    last_cpu_us = cpu_us;
+    printf("tcp zerocopy read %lld MB/s, sent %lld MB/s, cpu %lld ms, %lld us/MB\n",
+           (long long)read_mb,
+           (long long)sent_mb,
+           (long long)used_us / 1000,
+           (long long)(read_mb > 0 ? used_us / read_mb : 0));
+}
+
+static const char *check_zerocopy() {
+    if (corrupt_bytes.total() != 0) {
+        return "payload data corrupt";
+    }
+    if (issued_bytes.total() == 0) {
+        return "no payload sent";
+    }
+    if (sent_bytes.total() != issued_bytes.total()) {
+        return "sent callbacks mismatch sent payloads";
+    }
+    if (read_bytes.total() != issued_bytes.total()) {
+        return "read bytes mismatch sent payloads";
+    }
+    return nullptr;
+}
+
+void start_tcp_zerocopy(
+    const std::string &ip,
+    uint16_t port,
+    bool zerocopy,
+    int32_t size) {
+    by_zerocopy = zerocopy;
+    if (size > 0) {
+        payload_size = size;
+    }
+    payload.resize(payload_size);
+    for (int32_t i = 0; i < payload_size; i++) {
+        payload[i] = char(i % 251);
+    }
+
+    start_bench_service();
+
+    if (!start_bench_tcp(
+            ip,
+            port,
+            1,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    last_cpu_us = get_cpu_us();
+    run_bench(
+        "tcp zerocopy",
+        pump_bind(&on_zerocopy_report),
+        pump_bind(&check_zerocopy));
+}
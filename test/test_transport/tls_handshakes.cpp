@@ -0,0 +1,250 @@
+#include "tls_transport_test.h"
+
+#include <map>
+#include <mutex>
+#include <atomic>
+
+static service *sv;
+
+static uint16_t handshake_port;
+static std::string handshake_ip;
+
+static tls_session_store_sptr session_store;
+static tls_handshake_pool_sptr handshake_pool;
+
+static std::atomic_int32_t handshaked_count(0);
+static std::atomic_int32_t resumed_count(0);
+
+static std::mutex handshake_mx;
+static std::map<void *, std::shared_ptr<void>> handshake_objects;
+
+void start_once_handshake_dialer();
+
+static void release_handshake_object(void *obj) {
+    std::lock_guard<std::mutex> lock(handshake_mx);
+    handshake_objects.erase(obj);
+}
+
+static void hold_handshake_object(std::shared_ptr<void> obj) {
+    std::lock_guard<std::mutex> lock(handshake_mx);
+    handshake_objects[obj.get()] = obj;
+}
+
+static void on_ignored_read_callback(const char *b, int32_t size) {}
+
+class my_handshake_server {
+  public:
+    /*********************************************************************************
+     * Tls closed event callback
+     ********************************************************************************/
+    void on_closed_callback() {
+        sv->post(pump_bind(&release_handshake_object, this));
+    }
+
+    void set_transport(base_transport_sptr &transp) {
+        transport_ = transp;
+    }
+
+  private:
+    base_transport_sptr transport_;
+};
+
+/*********************************************************************************
+ * Tls accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    std::shared_ptr<my_handshake_server> server(new my_handshake_server);
+    server->set_transport(transp);
+
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_ignored_read_callback, _1, _2);
+    cbs.stopped_cb = pump_bind(&my_handshake_server::on_closed_callback, server.get());
+    cbs.disconnected_cb =
+        pump_bind(&my_handshake_server::on_closed_callback, server.get());
+
+    hold_handshake_object(server);
+    if (transp->start(sv, read_mode_loop, cbs) != 0) {
+        printf("tls handshakes server start error\n");
+        release_handshake_object(server.get());
+        return;
+    }
+    transp->async_read();
+
+    // Sessions from server are received by client before the message.
+    transp->send("h", 1);
+}
+
+/*********************************************************************************
+ * Stopped accepting event callback
+ ********************************************************************************/
+static void on_stopped_accepting_callback() {}
+
+class my_handshake_dialer {
+  public:
+    my_handshake_dialer()
+      : finished_(false) {
+    }
+
+    /*********************************************************************************
+     * Tls dialed event callback
+     ********************************************************************************/
+    void on_dialed_callback(base_transport_sptr &transp, bool succ) {
+        if (!succ) {
+            printf("tls handshakes dialed error\n");
+            __finish();
+            return;
+        }
+
+        handshaked_count.fetch_add(1);
+        if (std::static_pointer_cast<tls_transport>(transp)->is_session_resumed()) {
+            resumed_count.fetch_add(1);
+        }
+
+        pump::transport_callbacks cbs;
+        cbs.read_cb = pump_bind(&my_handshake_dialer::on_read_callback, this, _1, _2);
+        cbs.stopped_cb = pump_bind(&my_handshake_dialer::on_closed_callback, this);
+        cbs.disconnected_cb = pump_bind(&my_handshake_dialer::on_closed_callback, this);
+
+        transport_ = transp;
+        if (transport_->start(sv, read_mode_loop, cbs) != 0) {
+            printf("tls handshakes dialer start error\n");
+            __finish();
+            return;
+        }
+        transport_->async_read();
+    }
+
+    /*********************************************************************************
+     * Tls dialed timeout event callback
+     ********************************************************************************/
+    void on_dialed_timeout_callback() {
+        printf("tls handshakes dial timeout\n");
+        __finish();
+    }
+
+    /*********************************************************************************
+     * Stopped dial event callback
+     ********************************************************************************/
+    void on_stopped_dialing_callback() {}
+
+    /*********************************************************************************
+     * Tls read event callback
+     ********************************************************************************/
+    void on_read_callback(const char *b, int32_t size) {
+        transport_->stop();
+    }
+
+    /*********************************************************************************
+     * Tls stopped or disconnected event callback
+     ********************************************************************************/
+    void on_closed_callback() {
+        __finish();
+    }
+
+    void set_dialer(tls_dialer_sptr d) {
+        dialer_ = d;
+    }
+
+  private:
+    void __finish() {
+        if (finished_.exchange(true)) {
+            return;
+        }
+
+        // Dialer can't be released in its callback.
+        sv->post(pump_bind(&release_handshake_object, this));
+
+        start_once_handshake_dialer();
+    }
+
+  private:
+    std::atomic_bool finished_;
+    tls_dialer_sptr dialer_;
+    base_transport_sptr transport_;
+};
+
+void start_once_handshake_dialer() {
+    address bind_address("0.0.0.0", 0);
+    address peer_address(handshake_ip, handshake_port);
+    tls_dialer_sptr dialer = tls_dialer::create(bind_address, peer_address, 0);
+    if (session_store) {
+        dialer->set_session_store(session_store);
+    }
+    if (handshake_pool) {
+        dialer->set_handshake_pool(handshake_pool);
+    }
+
+    std::shared_ptr<my_handshake_dialer> my_dialer(new my_handshake_dialer);
+    my_dialer->set_dialer(dialer);
+
+    pump::dialer_callbacks cbs;
+    cbs.dialed_cb =
+        pump_bind(&my_handshake_dialer::on_dialed_callback, my_dialer.get(), _1, _2);
+    cbs.stopped_cb =
+        pump_bind(&my_handshake_dialer::on_stopped_dialing_callback, my_dialer.get());
+    cbs.timeouted_cb =
+        pump_bind(&my_handshake_dialer::on_dialed_timeout_callback, my_dialer.get());
+
+    hold_handshake_object(my_dialer);
+    if (dialer->start(sv, cbs) != 0) {
+        printf("tls handshakes dialer start error\n");
+        release_handshake_object(my_dialer.get());
+    }
+}
+
+static void on_handshakes_timeout() {
+    printf("tls handshaked %d conns/s, resumed %d conns/s\n",
+           handshaked_count.exchange(0),
+           resumed_count.exchange(0));
+}
+
+void start_tls_handshakes(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &mode,
+    int32_t conn_count) {
+    handshake_ip = ip;
+    handshake_port = port;
+
+    sv = new service;
+    sv->start();
+
+    tls_credentials xcred = load_tls_credentials_from_memory(false, cert, key);
+    if (mode == "cache") {
+        set_tls_session_cache(xcred, 10240);
+    } else if (mode == "ticket") {
+        set_tls_session_tickets(xcred, 60000000000);
+    }
+    if (mode == "cache" || mode == "ticket") {
+        session_store = tls_session_store::create();
+    }
+
+    pump::acceptor_callbacks acbs;
+    acbs.accepted_cb = pump_bind(&on_accepted_callback, _1);
+    acbs.stopped_cb = pump_bind(&on_stopped_accepting_callback);
+
+    address listen_address(ip, port);
+    tls_acceptor_sptr acceptor = tls_acceptor::create(xcred, listen_address);
+    if (mode == "pool") {
+        // Full handshakes run in the pool, and half of connections are queued.
+        handshake_pool = tls_handshake_pool::create();
+        handshake_pool->start();
+        acceptor->set_handshake_pool(handshake_pool);
+        acceptor->set_max_handshakes(conn_count / 2 + 1, conn_count / 4 + 1);
+    }
+    if (acceptor->start(sv, acbs) != 0) {
+        printf("tls acceptor start error\n");
+        return;
+    }
+
+    // Every dialer dials next connection after its connection closed.
+    for (int32_t i = 0; i < conn_count; i++) {
+        start_once_handshake_dialer();
+    }
+
+    time::timer_callback cb = pump_bind(&on_handshakes_timeout);
+    time::timer_sptr t = time::timer::create(true, 1000000000, cb);
+    sv->start_timer(t);
+
+    sv->wait_stopped();
+}
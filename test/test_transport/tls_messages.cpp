@@ -0,0 +1,145 @@
+#include "tls_transport_test.h"
+
+#include <sys/time.h>
+#include <sys/resource.h>
+
+static int32_t message_size = 256;
+static int32_t max_inflight_count = 4096;
+
+// Tls sessions use memory bio, else they are bound to socket.
+static bool by_memory_bio = true;
+
+static base_transport_sptr sender;
+static std::string message_data;
+// Read offset of all messages
+static int64_t read_offset = 0;
+
+static bench_counter issued_count;
+static bench_counter sent_count;
+static bench_counter read_bytes;
+static bench_counter corrupt_count;
+static std::atomic_int64_t inflight_count(0);
+
+static int64_t last_cpu_us = 0;
+
+/*********************************************************************************
+ * Tls read event callback
+ ********************************************************************************/
+static void on_read_callback(const char *b, int32_t size) {
+    // Every message is filled with a letter in order.
+    for (int32_t i = 0; i < size; i++, read_offset++) {
+        if (b[i] != char('a' + (read_offset / message_size) % 26)) {
+            corrupt_count.add(1);
+        }
+    }
+    read_bytes.add(size);
+}
+
+/*********************************************************************************
+ * Tls sent batch event callback
+ ********************************************************************************/
+static void on_sent_callback(toolkit::io_buffer **iobs, int32_t count) {
+    sent_count.add(count);
+    inflight_count.fetch_sub(count, std::memory_order_relaxed);
+}
+
+/*********************************************************************************
+ * Tls accepted event callback
+ ********************************************************************************/
+static void on_accepted_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.read_cb = pump_bind(&on_read_callback, _1, _2);
+    start_bench_transport(transp, cbs);
+}
+
+static bool send_message() {
+    if (inflight_count.load(std::memory_order_relaxed) > max_inflight_count) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        return true;
+    }
+    message_data.assign(message_size, char('a' + issued_count.total() % 26));
+    inflight_count.fetch_add(1, std::memory_order_relaxed);
+    if (sender->send(message_data.data(), message_size) != 0) {
+        return false;
+    }
+    issued_count.add(1);
+    return true;
+}
+
+/*********************************************************************************
+ * Tls dialed event callback
+ ********************************************************************************/
+static void on_dialed_callback(base_transport_sptr &transp) {
+    pump::transport_callbacks cbs;
+    cbs.sent_batch_cb = pump_bind(&on_sent_callback, _1, _2);
+
+    sender = transp;
+    if (start_bench_transport(transp, cbs)) {
+        start_bench_send_loop(pump_bind(&send_message));
+    }
+}
+
+static int64_t get_cpu_us() {
+    struct rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    return (int64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000 +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void on_messages_report() {
+    auto cpu_us = get_cpu_us();
+    auto used_us = cpu_us - last_cpu_us;
+    last_cpu_us = cpu_us;
+    auto count = sent_count.take();
+    printf("tls %s read %lld MB/s, sent %lld msg/s, cpu %lld ms, %lld ns/msg, corrupt %lld\n",
+           by_memory_bio ? "memory bio" : "socket bio",
+           (long long)read_bytes.take() / (1024 * 1024),
+           (long long)count,
+           (long long)used_us / 1000,
+           (long long)(count > 0 ? used_us * 1000 / count : 0),
+           (long long)corrupt_count.total());
+}
+
+static const char *check_messages() {
+    if (corrupt_count.total() != 0) {
+        return "message data corrupt";
+    }
+    if (issued_count.total() == 0) {
+        return "no message sent";
+    }
+    if (sent_count.total() != issued_count.total()) {
+        return "sent callbacks mismatch sent messages";
+    }
+    if (read_bytes.total() != issued_count.total() * message_size) {
+        return "read bytes mismatch sent messages";
+    }
+    return nullptr;
+}
+
+void start_tls_messages(
+    const std::string &ip,
+    uint16_t port,
+    bool memory_bio,
+    int32_t size) {
+    by_memory_bio = memory_bio;
+    if (size > 0) {
+        message_size = size;
+    }
+
+    start_bench_service();
+
+    if (!start_bench_tls(
+            ip,
+            port,
+            by_memory_bio,
+            pump_bind(&on_accepted_callback, _1),
+            pump_bind(&on_dialed_callback, _1))) {
+        return;
+    }
+
+    last_cpu_us = get_cpu_us();
+    run_bench(
+        "tls messages",
+        pump_bind(&on_messages_report),
+        pump_bind(&check_messages));
+}
@@ -8,11 +8,18 @@
 #include <pump/transport/tls_transport.h>
 #include <stdio.h>
 
-namespace pump {
-using namespace transport;
-}
+#include "tcp_transport_test.h"
 
-using namespace pump;
+// Certificate and key of test tls server
+extern const char *cert;
+extern const char *key;
+
+extern bool start_bench_tls(
+    const std::string &ip,
+    uint16_t port,
+    bool memory_bio,
+    const bench_transport_callback &accepted,
+    const bench_transport_callback &dialed);
 
 extern void start_tls_server(
     const std::string &ip,
@@ -25,4 +32,16 @@ extern void start_tls_client(
     uint16_t port,
     int32_t conn_count);
 
+extern void start_tls_messages(
+    const std::string &ip,
+    uint16_t port,
+    bool memory_bio,
+    int32_t size);
+
+extern void start_tls_handshakes(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &mode,
+    int32_t conn_count);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "udp_transport_test.h"
+
+static int32_t segment_size = 1400;
+
+// Send and read with segment offload, else send and read datagrams one by one.
+static bool by_offload = true;
+
+static bench_counter read_bytes;
+static bench_counter read_count;
+static bench_counter sent_count;
+static bench_counter corrupt_count;
+
+static udp_transport_sptr receiver;
+static udp_transport_sptr sender;
+
+static int32_t gso_segments = 0;
+static std::string gso_data;
+
+/*********************************************************************************
+ * Udp read event callback
+ ********************************************************************************/
+static void on_read_callback(const address &from, const char *b, int32_t size) {
+    // Every datagram is filled with its first byte.
+    if (size != segment_size || b[size - 1] != b[0]) {
+        corrupt_count.add(1);
+    }
+    read_bytes.add(size);
+    read_count.add(1);
+}
+
+static bool send_segments(address to) {
+    // Send buffers of max segments which are segmented to datagrams.
+    if (by_offload) {
+        if (sender->send(gso_data.data(), (int32_t)gso_data.size(), to) != 0) {
+            std::this_thread::yield();
+        } else {
+            sent_count.add(gso_segments);
+        }
+        return sender->is_started();
+    }
+    for (int32_t i = 0; i < gso_segments; i++) {
+        while (sender->send(gso_data.data() + i * segment_size, segment_size, to) != 0) {
+            if (!sender->is_started()) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+        sent_count.add(1);
+    }
+    return true;
+}
+
+static void on_gso_report() {
+    printf("udp %s read %lld MB/s, %lld pps, corrupt %lld\n",
+           by_offload ? "gso" : "plain",
+           (long long)read_bytes.take() / (1024 * 1024),
+           (long long)read_count.take(),
+           (long long)corrupt_count.total());
+}
+
+static const char *check_gso() {
+    // Datagrams maybe dropped by receiver, but never duplicated.
+    if (corrupt_count.total() != 0) {
+        return "datagram data corrupt";
+    }
+    if (read_count.total() == 0) {
+        return "no datagram read";
+    }
+    if (read_count.total() > sent_count.total()) {
+        return "read more datagrams than sent";
+    }
+    return nullptr;
+}
+
+void start_udp_gso(
+    const std::string &ip,
+    uint16_t port,
+    bool offload,
+    int32_t size) {
+    by_offload = offload;
+    if (size > 0 && size <= max_udp_buffer_size) {
+        segment_size = size;
+    }
+
+    start_bench_service();
+
+    address recv_address(ip, port);
+    receiver = udp_transport::create(recv_address);
+    if (by_offload) {
+        receiver->set_segment_offload(segment_size);
+    }
+    transport_callbacks rcbs;
+    rcbs.read_from_cb = pump_bind(&on_read_callback, _1, _2, _3);
+    if (!start_bench_transport(receiver, rcbs)) {
+        return;
+    }
+
+    address send_address(ip, 0);
+    sender = udp_transport::create(send_address);
+    if (by_offload) {
+        sender->set_segment_offload(segment_size);
+    }
+    transport_callbacks scbs;
+    scbs.read_from_cb = pump_bind(&on_read_callback, _1, _2, _3);
+    if (!start_bench_transport(sender, scbs)) {
+        return;
+    }
+
+    gso_segments = max_udp_gso_size / segment_size;
+    if (gso_segments > max_udp_gso_segments) {
+        gso_segments = max_udp_gso_segments;
+    }
+    for (int32_t i = 0; i < gso_segments; i++) {
+        gso_data.append(segment_size, char('a' + i % 26));
+    }
+    start_bench_send_loop(pump_bind(&send_segments, recv_address));
+
+    run_bench(
+        "udp gso",
+        pump_bind(&on_gso_report),
+        pump_bind(&check_gso));
+}
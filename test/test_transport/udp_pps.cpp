@@ -0,0 +1,124 @@
+#include "udp_transport_test.h"
+
+#include <vector>
+
+static int32_t datagram_size = 64;
+
+// Read and send datagrams in batch, else one by one.
+static bool by_batch = true;
+
+static bench_counter read_count;
+static bench_counter sent_count;
+static bench_counter corrupt_count;
+
+static udp_transport_sptr receiver;
+static udp_transport_sptr sender;
+
+static std::string pps_data;
+static std::vector<udp_datagram> pps_dgs;
+
+/*********************************************************************************
+ * Udp read event callback
+ ********************************************************************************/
+static void on_read_callback(const address &from, const char *b, int32_t size) {
+    if (size != datagram_size) {
+        corrupt_count.add(1);
+    }
+    read_count.add(1);
+}
+
+/*********************************************************************************
+ * Udp read batch event callback
+ ********************************************************************************/
+static void on_read_batch_callback(const udp_datagram *dgs, int32_t count) {
+    for (int32_t i = 0; i < count; i++) {
+        if (dgs[i].size != datagram_size) {
+            corrupt_count.add(1);
+        }
+    }
+    read_count.add(count);
+}
+
+static bool send_datagrams(address to) {
+    if (by_batch) {
+        int32_t count = 0;
+        sender->send_batch(pps_dgs.data(), (int32_t)pps_dgs.size(), &count);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        sent_count.add(count);
+    } else if (sender->send(pps_data.data(), datagram_size, to) == 0) {
+        sent_count.add(1);
+    } else {
+        std::this_thread::yield();
+    }
+    return sender->is_started();
+}
+
+static void on_pps_report() {
+    printf("udp %s read %lld pps, sent %lld pps\n",
+           by_batch ? "batch" : "single",
+           (long long)read_count.take(),
+           (long long)sent_count.take());
+}
+
+static const char *check_pps() {
+    // Datagrams maybe dropped by receiver, but never duplicated.
+    if (corrupt_count.total() != 0) {
+        return "datagram size corrupt";
+    }
+    if (read_count.total() == 0) {
+        return "no datagram read";
+    }
+    if (read_count.total() > sent_count.total()) {
+        return "read more datagrams than sent";
+    }
+    return nullptr;
+}
+
+void start_udp_pps(
+    const std::string &ip,
+    uint16_t port,
+    bool batch,
+    int32_t size) {
+    by_batch = batch;
+    if (size > 0 && size <= max_udp_buffer_size) {
+        datagram_size = size;
+    }
+
+    start_bench_service();
+
+    address recv_address(ip, port);
+    receiver = udp_transport::create(recv_address);
+    transport_callbacks rcbs;
+    if (by_batch) {
+        rcbs.read_from_batch_cb = pump_bind(&on_read_batch_callback, _1, _2);
+    } else {
+        rcbs.read_from_cb = pump_bind(&on_read_callback, _1, _2, _3);
+    }
+    if (!start_bench_transport(receiver, rcbs)) {
+        return;
+    }
+
+    address send_address(ip, 0);
+    sender = udp_transport::create(send_address);
+    transport_callbacks scbs;
+    scbs.read_from_cb = pump_bind(&on_read_callback, _1, _2, _3);
+    if (!start_bench_transport(sender, scbs)) {
+        return;
+    }
+
+    pps_data.assign(datagram_size, 'u');
+    pps_dgs.resize(net::max_batch_count);
+    for (auto &dg : pps_dgs) {
+        dg.addr = recv_address;
+        dg.data = pps_data.data();
+        dg.size = datagram_size;
+    }
+    start_bench_send_loop(pump_bind(&send_datagrams, recv_address));
+
+    run_bench(
+        "udp pps",
+        pump_bind(&on_pps_report),
+        pump_bind(&check_pps));
+}
@@ -0,0 +1,146 @@
+#include "udp_transport_test.h"
+
+static int32_t datagram_size = 1024;
+// Datagrams of one burst
+static int32_t burst_count = 10000;
+
+// Queue policy, newest, oldest, block or none.
+static std::string queue_policy;
+
+static bench_counter read_count;
+static bench_counter again_count;
+
+static udp_transport_sptr receiver;
+static udp_transport_sptr sender;
+
+static std::string queue_data;
+
+/*********************************************************************************
+ * Udp read event callback
+ ********************************************************************************/
+static void on_read_callback(const address &from, const char *b, int32_t size) {
+    read_count.add(1);
+}
+
+static bool send_burst(address to) {
+    // Send a burst faster than socket buffer drains, then keep quiet.
+    for (int32_t i = 0; i < burst_count; i++) {
+        if (sender->send(queue_data.data(), datagram_size, to) == error_again) {
+            again_count.add(1);
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return sender->is_started();
+}
+
+static void on_queue_report() {
+    auto stats = sender->get_send_queue_stats();
+    printf("udp queue read %lld, again %lld, queued %llu, sent %llu, "
+           "dropped %llu, blocked %llu, pending %d\n",
+           (long long)read_count.take(),
+           (long long)again_count.take(),
+           (unsigned long long)stats.queued,
+           (unsigned long long)stats.sent,
+           (unsigned long long)stats.dropped,
+           (unsigned long long)stats.blocked,
+           stats.pending);
+}
+
+static const char *check_queue() {
+    auto stats = sender->get_send_queue_stats();
+    if (read_count.total() == 0) {
+        return "no datagram read";
+    }
+    if (stats.pending != 0) {
+        return "queued datagrams not drained";
+    }
+    if (queue_policy == "none") {
+        if (stats.queued != 0) {
+            return "datagrams queued without send queue";
+        }
+        if (again_count.total() == 0) {
+            return "bursts never filled socket buffer";
+        }
+        return nullptr;
+    }
+
+    // Queued datagrams are sent or dropped from the queue by drop oldest
+    // policy, datagrams dropped by drop newest policy are never queued.
+    uint64_t dropped_queued = queue_policy == "oldest" ? stats.dropped : 0;
+    if (stats.queued != stats.sent + dropped_queued) {
+        return "queued datagrams mismatch sent and dropped ones";
+    }
+    if (queue_policy == "newest") {
+        if (stats.dropped == 0) {
+            return "no datagram dropped by full queue";
+        }
+        if ((uint64_t)again_count.total() != stats.dropped) {
+            return "again errors mismatch dropped datagrams";
+        }
+        if (stats.blocked != 0) {
+            return "sending blocked by drop policy";
+        }
+    } else if (queue_policy == "oldest") {
+        if (stats.dropped == 0) {
+            return "no datagram dropped by full queue";
+        }
+        if (again_count.total() != 0 || stats.blocked != 0) {
+            return "sending failed or blocked by drop oldest policy";
+        }
+    } else {
+        if (stats.blocked == 0) {
+            return "sending never blocked by full queue";
+        }
+        if (again_count.total() != 0 || stats.dropped != 0) {
+            return "datagrams dropped by block policy";
+        }
+    }
+    return nullptr;
+}
+
+void start_udp_queue(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &policy,
+    int32_t max_count) {
+    start_bench_service();
+
+    address recv_address(ip, port);
+    receiver = udp_transport::create(recv_address);
+    transport_callbacks rcbs;
+    rcbs.read_from_cb = pump_bind(&on_read_callback, _1, _2, _3);
+    if (!start_bench_transport(receiver, rcbs)) {
+        return;
+    }
+
+    address send_address(ip, 0);
+    sender = udp_transport::create(send_address);
+    if (policy == "oldest") {
+        sender->set_send_queue(max_count, udp_send_drop_oldest);
+    } else if (policy == "block") {
+        sender->set_send_queue(max_count, udp_send_block);
+    } else if (policy == "newest") {
+        sender->set_send_queue(max_count, udp_send_drop_newest);
+    }
+    if (policy == "oldest" || policy == "block" || policy == "newest") {
+        queue_policy = policy;
+    } else {
+        queue_policy = "none";
+    }
+    transport_callbacks scbs;
+    scbs.read_from_cb = pump_bind(&on_read_callback, _1, _2, _3);
+    if (!start_bench_transport(sender, scbs)) {
+        return;
+    }
+
+    // Small socket buffer makes bursts fill it.
+    net::set_send_bs(sender->get_fd(), 4096);
+
+    queue_data.assign(datagram_size, 'q');
+    start_bench_send_loop(pump_bind(&send_burst, recv_address));
+
+    run_bench(
+        "udp queue",
+        pump_bind(&on_queue_report),
+        pump_bind(&check_queue));
+}
@@ -6,14 +6,33 @@
 #include <pump/transport/udp_transport.h>
 #include <stdio.h>
 
-namespace pump {
-using namespace transport;
-}
-
-using namespace pump;
+#include "tcp_transport_test.h"
 
 extern void start_udp_server(const std::string &ip, uint16_t port);
 
 extern void start_udp_client(const std::string &ip, uint16_t port);
 
+extern void start_udp_pps(
+    const std::string &ip,
+    uint16_t port,
+    bool batch,
+    int32_t size);
+
+extern void start_udp_gso(
+    const std::string &ip,
+    uint16_t port,
+    bool offload,
+    int32_t size);
+
+extern void start_udp_queue(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &policy,
+    int32_t max_count);
+
+extern void start_udp_again(
+    const std::string &ip,
+    uint16_t port,
+    const std::string &mode);
+
 #endif
\ No newline at end of file